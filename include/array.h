@@ -0,0 +1,56 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_ARRAY_H_
+#define _INCLUDE_ARRAY_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+// Table-valued function that expands a bound array into rows, registered on every database as it is opened.
+//
+//   SELECT * FROM players WHERE id IN gm_array(?1)
+//   SELECT value FROM gm_array(?1)
+//
+// The parameter has to be bound with ARRAY_POINTER_TYPE (stmt:BindArray from Lua), anything else gives no rows.
+// One prepared statement works for any number of elements.
+
+#define ARRAY_MODULE_NAME	"gm_array"
+#define ARRAY_POINTER_TYPE	"gm_array"
+
+struct ArrayParam
+{
+	int iType;			// SQLITE_INTEGER, SQLITE_FLOAT or SQLITE_TEXT
+	int iCount;
+	sqlite3_int64* pIntegers;
+	double* pFloats;
+	char** ppStrings;	// each one allocated with sqlite3_malloc
+};
+
+// Allocates room for count elements of the given type, zeroed
+ArrayParam* CreateArrayParam(int type, int count);
+
+// Matches the destructor sqlite3_bind_pointer expects
+void FreeArrayParam(void* param);
+
+int RegisterArray(sqlite3* db);
+
+#endif
@@ -0,0 +1,97 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_BACKUP_H_
+#define _INCLUDE_BACKUP_H_
+
+#include "module.h"
+#include "thread.h"
+#include <sqlite3.h>
+
+class CDatabase;
+
+class CBackup
+{
+
+private:
+
+	sqlite3_backup* m_pBackup;
+
+	sqlite3* m_pSource;
+
+	// Only closed by us when the backup opened the destination itself
+	sqlite3* m_pDestination;
+	bool m_bOwnsDestination;
+
+	// Set when the destination is another open database, its result cache is bypassed until the backup finishes
+	CDatabase* m_pDestinationDatabase;
+
+	int m_iPagesPerStep;
+	int m_iLastResult;
+
+	int m_iRemaining;
+	int m_iPageCount;
+
+	// Background mode
+	CThread m_Thread;
+	CMutex m_Mutex;
+	volatile bool m_bStopThread;
+	int m_iSleepMs;
+
+	static void threadMain(void* usrPtr);
+
+	int stepLocked(int pages);
+
+	// Every backup that exists, so the module can stop them all before SQLite shuts down
+	static CBackup* s_pFirstLive;
+	CBackup* m_pPrevLive;
+	CBackup* m_pNextLive;
+
+public:
+
+	CBackup(sqlite3_backup* backup, sqlite3* source, sqlite3* destination, bool ownsDestination, int pagesPerStep);
+	~CBackup(void);
+
+	static int create(CBackup** backup, sqlite3* destination, const char* destinationName, sqlite3* source, const char* sourceName, bool ownsDestination, int pagesPerStep);
+
+	int step(void);
+	int step(int pages);
+	int finish(void);
+
+	bool isDone(void);
+	bool isThreaded(void);
+
+	int getRemaining(void);
+	int getPageCount(void);
+	int getLastResult(void);
+
+	sqlite3* getDestination(void);
+
+	void setDestinationDatabase(CDatabase* database);
+	static void forgetDestination(CDatabase* database);
+
+	int startThread(int sleepMs);
+
+	static void finishAll(void);
+
+};
+
+#endif
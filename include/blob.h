@@ -0,0 +1,70 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_BLOB_H_
+#define _INCLUDE_BLOB_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+class CDatabase;
+
+class CBlob
+{
+
+	friend class CDatabase;
+
+private:
+
+	sqlite3_blob* m_pBlob;
+
+	// Linked into the database that opened the blob until it closes. Writes drop the cached results that read
+	// m_pszTable, which is only set for writable blobs.
+	CDatabase* m_pOwner;
+	CBlob* m_pPrevBlob;
+	CBlob* m_pNextBlob;
+	char* m_pszTable;
+
+	// Reused between reads so streaming a large blob doesn't allocate per chunk
+	char* m_pBuffer;
+	int m_iBufferSize;
+
+public:
+
+	CBlob(sqlite3_blob* blob, CDatabase* owner=NULL, const char* table=NULL);
+	~CBlob(void);
+
+	int close(void);
+
+	bool isOpen(void);
+
+	int getSize(void);
+
+	int read(void* buffer, int length, int offset);
+	int write(const void* data, int length, int offset);
+
+	int reopen(sqlite3_int64 rowid);
+
+	char* getBuffer(int size);
+
+};
+
+#endif
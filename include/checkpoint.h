@@ -0,0 +1,87 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_CHECKPOINT_H_
+#define _INCLUDE_CHECKPOINT_H_
+
+#include "module.h"
+#include "thread.h"
+#include <sqlite3.h>
+
+// Runs WAL checkpoints from a background thread on a connection of its own.
+// The game thread only reports commits through noteCommit (from its wal hook), it never checkpoints itself.
+
+class CCheckpointer
+{
+
+private:
+
+	sqlite3* m_pConnection;
+	int m_iPageSize;
+
+	int m_iIntervalMs;
+	int m_iIdleMs;
+
+	CThread m_Thread;
+	CMutex m_Mutex;
+	volatile bool m_bStopThread;
+
+	// Guarded by m_Mutex
+	bool m_bDirty;
+	double m_dLastCommit;
+	int m_iWalFrames;
+	int m_iFramesBehind;
+	int m_iLastResult;
+	double m_dLastDuration;
+	double m_dMaxDuration;
+	int m_iNumCheckpoints;
+	int m_iNumTruncates;
+
+	static void threadMain(void* usrPtr);
+
+	void checkpoint(bool idle);
+
+public:
+
+	CCheckpointer(sqlite3* connection, int pageSize, int intervalMs, int idleMs);
+	~CCheckpointer(void);
+
+	static int create(CCheckpointer** checkpointer, const char* fileName, int intervalMs, int idleMs);
+
+	int start(void);
+	void stop(void);
+
+	void noteCommit(int walFrames);
+
+	bool isRunning(void);
+
+	int getWalFrames(void);
+	sqlite3_int64 getWalSize(void);
+	int getFramesBehind(void);
+	int getLastResult(void);
+	double getLastDuration(void);
+	double getMaxDuration(void);
+	int getNumCheckpoints(void);
+	int getNumTruncates(void);
+
+};
+
+#endif
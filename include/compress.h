@@ -0,0 +1,70 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_COMPRESS_H_
+#define _INCLUDE_COMPRESS_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+// Self contained LZ77 codec (LZ4 block layout) behind the compress()/decompress() SQL functions, registered on every
+// database as it is opened.
+//
+//   compress(x)		TEXT or BLOB to a compressed BLOB, anything else is returned as it is
+//   decompress(x)		undoes compress(), giving back the original TEXT or BLOB. Values that were never compressed
+//						or fail to decompress are returned as they are, so a column can be converted gradually.
+//
+// Compressed values start with a header byte and the original size as a varint. Input that does not shrink is kept
+// uncompressed behind the same header.
+
+#define COMPRESS_MAGIC		0xA0
+#define COMPRESS_FLAG_LZ	0x01	// payload is compressed, otherwise it is stored as is
+#define COMPRESS_FLAG_TEXT	0x02	// decompresses to TEXT rather than a BLOB
+
+#define COMPRESS_MAX_HEADER	6
+
+struct CompressionStats
+{
+	sqlite3_int64 iCompressed;		// values run through compress
+	sqlite3_int64 iDecompressed;	// values run through decompress
+	sqlite3_int64 iBytesIn;			// bytes handed to compress
+	sqlite3_int64 iBytesOut;		// bytes it produced
+	double dCompressMs;
+	double dDecompressMs;
+};
+
+// Largest output CompressValue can produce for length bytes of input
+int CompressBound(int length);
+
+// Writes the header and payload for data into out, which needs CompressBound(length) bytes. Returns the size written.
+int CompressValue(const void* data, int length, bool isText, unsigned char* out);
+
+// Reads the header of a compressed value, returns false if data is not one
+bool CompressedInfo(const void* data, int length, int* originalLength, bool* isText);
+
+// Decompresses data into out, which needs the original length from CompressedInfo. Returns false if data is corrupt.
+bool DecompressValue(const void* data, int length, unsigned char* out);
+
+int RegisterCompression(sqlite3* db);
+
+void GetCompressionStats(CompressionStats* stats, bool reset);
+
+#endif
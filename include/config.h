@@ -0,0 +1,79 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_CONFIG_H_
+#define _INCLUDE_CONFIG_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+// Process wide SQLite settings, these can only be changed before sqlite3_initialize
+// so they are read from a file when the module loads. Recognized keys:
+//
+//   threading			single, multi or serialized
+//   memstatus			0 or 1
+//   pagecache_size		bytes per page cache slot, used with pagecache_count
+//   pagecache_count
+//   lookaside_size		bytes per lookaside slot, used with lookaside_count
+//   lookaside_count
+//   heap_mb			size of a fixed heap arena, needs SQLITE_ENABLE_MEMSYS5
+//   heap_min_alloc
+
+#define CONFIG_FILE "cfg/gm_sqlite3.cfg"
+
+struct GlobalConfig
+{
+
+	int iThreading;				// SQLITE_CONFIG_SINGLETHREAD, _MULTITHREAD, _SERIALIZED or 0 for the default
+	int iMemStatus;				// -1 for the default
+
+	int iPageCacheSize;			// bytes per slot
+	int iPageCacheCount;
+
+	int iLookasideSize;			// bytes per slot
+	int iLookasideCount;
+
+	int iHeapMB;
+	int iHeapMinAlloc;
+
+	// Result of the sqlite3_config call for each setting, SQLITE_OK when it wasn't set
+	int iThreadingResult;
+	int iMemStatusResult;
+	int iPageCacheResult;
+	int iLookasideResult;
+	int iHeapResult;
+
+	GlobalConfig(void);
+
+};
+
+// Returns false if the file doesn't exist, which is not an error
+bool ReadGlobalConfig(const char* fileName, GlobalConfig* config);
+
+// Must be called before sqlite3_initialize
+void ApplyGlobalConfig(GlobalConfig* config);
+
+// Frees the buffers handed to SQLite, must be called after sqlite3_shutdown
+void ReleaseGlobalConfig(void);
+
+const GlobalConfig* GetGlobalConfig(void);
+
+#endif
@@ -1,70 +1,328 @@
-/*
-
-    Gm_sqlite3 the improved sqlite library for Garry's Mod
-    Copyright (C) 2010 James John Kelly Jr
-
-	This library is free software; you can redistribute it and/or
-	modify it under the terms of the GNU Lesser General Public
-	License as published by the Free Software Foundation; either
-	version 2.1 of the License, or (at your option) any later version.
-
-	This library is distributed in the hope that it will be useful,
-	but WITHOUT ANY WARRANTY; without even the implied warranty of
-	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-	Lesser General Public License for more details.
-
-	You should have received a copy of the GNU Lesser General Public
-	License along with this library; if not, write to the Free Software
-	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
-
-*/
-
-#ifndef _INCLUDE_DATABASE_H_
-#define _INCLUDE_DATABASE_H_
-
-#include "module.h"
-#include <sqlite3.h>
-
-#ifndef CStatement
-class CStatement;
-#endif
-
-#ifndef sqlite3_callback
-typedef int (*sqlite3_callback)(void*,int,char**,char**);
-#endif
-
-class CDatabase
-{
-
-private:
-
-	sqlite3* m_pDatabase;
-
-public:
-
-	CDatabase(void);
-	~CDatabase(void);
-
-	sqlite3* getDatabase(void);
-
-	int open(const char* dbName, int flags=0, const char* zVfs=NULL);
-	int close(void);
-
-	bool isOpen(void);
-
-	int setExtendedErrors(bool onoff);
-
-	int getErrorCode(void);
-	const char* getErrorMessage(void);
-
-	sqlite3_int64 getLastInsertId(void);
-
-	int getChanges(void);
-	int getTotalChanges(void);
-
-	int execute(const char* sql, sqlite3_callback callback=NULL, void* usrPtr=NULL);
-	int prepare(CStatement** stmt, const char* sql);
-
-};
-
-#endif
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_DATABASE_H_
+#define _INCLUDE_DATABASE_H_
+
+#include "module.h"
+#include "pool.h"
+#include <sqlite3.h>
+
+#ifndef CStatement
+class CStatement;
+#endif
+
+class CBlob;
+class CBackup;
+class CCheckpointer;
+class CFunction;
+class CQueryCache;
+
+#ifndef sqlite3_callback
+typedef int (*sqlite3_callback)(void*,int,char**,char**);
+#endif
+
+// Called once a deferred write has gone through or been given up on, latency is in milliseconds since it was queued
+
+typedef void (*DeferredCallback)(void* usrPtr, int retcode, double latency);
+
+struct DeferredWrite
+{
+	char* pszSql;
+	DeferredCallback pCallback;
+	void* pUsrPtr;
+	double dQueued;
+	double dNextAttempt;
+	int iAttempts;
+	int iResult;
+	DeferredWrite* pNext;
+};
+
+// Settings applied right after a database is opened, anything left at its default is not touched
+
+struct DatabaseOptions
+{
+
+	const char* pszJournal;			// journal_mode
+	const char* pszSynchronous;		// synchronous
+	const char* pszTempStore;		// temp_store
+	int iCacheMB;					// cache_size
+	int iMmapMB;					// mmap_size
+	int iBusyTimeout;				// milliseconds
+	bool bBusyBackoff;				// see CDatabase::setBusyBackoff
+	bool bBatch;					// see CDatabase::setBatching
+	int iMemoryLimitMB;				// see CDatabase::setMemoryLimit
+
+	// Passed as URI parameters
+	bool bImmutable;
+	bool bNoLock;
+
+	// See CDatabase::openInMemory
+	bool bMemory;
+	double dSnapshotInterval;
+
+	DatabaseOptions(void);
+
+	// Fills in one of "throughput", "durable", "readonly" or "shared", returns false for anything else
+	bool setPreset(const char* name, int* flags);
+
+};
+
+class CDatabase
+{
+
+	friend class CStatement;
+	friend class CBlob;
+
+private:
+
+	sqlite3* m_pDatabase;
+
+	// Every open database, so per-tick work can be driven from a single hook
+	static CDatabase* s_pFirstOpen;
+	CDatabase* m_pPrevOpen;
+	CDatabase* m_pNextOpen;
+
+	// Callbacks may close or collect any database, thinkAll marks the ones it has done instead of keeping a pointer
+	static unsigned int s_iThinkTick;
+	unsigned int m_iThinkTick;
+	bool m_bThinking;
+
+	void link(void);
+	void unlink(void);
+
+	// Statements prepared on this database that have not been finalized yet
+	CStatement* m_pFirstStatement;
+	int m_iNumStatements;
+	int m_iNumLeakedStatements;
+	int m_iNumClosedStatements;
+
+	void trackStatement(CStatement* stmt);
+	void untrackStatement(CStatement* stmt);
+	void finalizeStatements(void);
+
+	// Blobs opened on this database, writable ones report their writes to the result cache
+	CBlob* m_pFirstBlob;
+
+	void trackBlob(CBlob* blob);
+	void untrackBlob(CBlob* blob);
+
+	// In-memory working set, periodically persisted to m_pszSnapshotFile
+	char* m_pszSnapshotFile;
+	double m_dSnapshotInterval;
+	CBackup* m_pSnapshot;
+	double m_dSnapshotStarted;
+	double m_dLastSnapshot;
+	double m_dLastSnapshotAttempt;
+	double m_dLastSnapshotDuration;
+	int m_iSnapshotChanges;
+	int m_iSnapshotStartChanges;
+
+	// total_changes misses schema changes and VACUUM, the pager's data version counts every commit that wrote
+	unsigned int m_iSnapshotVersion;
+	unsigned int m_iSnapshotStartVersion;
+	int m_iSnapshotResult;
+	int m_iNumSnapshots;
+	int m_iNumSnapshotFailures;
+
+	int startSnapshot(void);
+	int stepSnapshot(int pages);
+
+	unsigned int getDataVersion(void);
+
+	static CPool s_Pool;
+
+	// Writes that hit SQLITE_BUSY, retried in order from think with an increasing delay
+	DeferredWrite* m_pFirstDeferred;
+	DeferredWrite* m_pLastDeferred;
+	int m_iNumQueued;
+	int m_iBusyTimeout;
+	double m_dDeferredTimeout;
+	int m_iNumBusy;
+	int m_iNumDeferred;
+	int m_iNumRetried;
+	int m_iNumAbandoned;
+	double m_dRetryLatencyTotal;
+	double m_dRetryLatencyMax;
+
+	// The database's own userdata, referenced while writes are queued so it can't be collected before their callbacks ran
+	ILuaObject* m_pQueueRef;
+	void releaseQueue(void);
+
+	int tryExecute(const char* sql, bool savepoint=true);
+	void pumpDeferred(void);
+	void flushBatch(void);
+	void backoffDeferred(DeferredWrite* write, double now);
+	void finishDeferred(DeferredWrite* write, int retcode, double latency);
+	void failBatch(int retcode, double now);
+	void abandonDeferred(int retcode);
+
+	// Several processes writing the same file, see setBusyBackoff and setBatching
+	bool m_bBusyBackoff;
+	bool m_bBatching;
+	double m_dBusyStarted;
+	int m_iNumBusyWaits;
+	int m_iNumLockTimeouts;
+	double m_dLockWaitTotal;
+	double m_dLockWaitMax;
+	int m_iNumBatches;
+	int m_iNumBatched;
+
+	static int busyHandler(void* usrPtr, int count);
+	void restoreBusyHandler(void);
+	void syncBusyTimeout(void);
+
+	// Background WAL checkpoints, auto-checkpointing is off while this is set
+	CCheckpointer* m_pCheckpointer;
+
+	static int walHook(void* usrPtr, sqlite3* db, const char* dbName, int walFrames);
+
+	// Cache memory is released on think once sqlite3_memory_used goes over m_iMemoryLimit
+	sqlite3_int64 m_iMemoryLimit;
+	sqlite3_int64 m_iBytesReclaimed;
+	int m_iNumEvictions;
+	int m_iNumReleases;
+	double m_dLastRelease;
+
+	// Results of read-only statements, only statements prepared while it is set are cached
+	CQueryCache* m_pResultCache;
+
+	// Backups from other databases writing into this one, the result cache can't see what they change
+	int m_iNumIncoming;
+
+	// The last search statement and the SQL it was prepared from, Search runs the same one again and again
+	CStatement* m_pSearch;
+	char* m_pszSearchSql;
+	void dropSearch(void);
+
+public:
+
+	CDatabase(void);
+	~CDatabase(void);
+
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr, size_t size);
+	static CPool* getPool(void);
+
+	sqlite3* getDatabase(void);
+
+	int open(const char* dbName, int flags=0, const char* zVfs=NULL);
+	int open(const char* dbName, int flags, const DatabaseOptions& options);
+	int applyOptions(const DatabaseOptions& options);
+	int close(void);
+
+	bool isOpen(void);
+
+	int setExtendedErrors(bool onoff);
+	int setBusyTimeout(int milliseconds);
+	int setBusyBackoff(bool onoff);
+
+	int getErrorCode(void);
+	const char* getErrorMessage(void);
+
+	sqlite3_int64 getLastInsertId(void);
+
+	int getChanges(void);
+	int getTotalChanges(void);
+
+	int getStatus(int op, int* current, int* highwater, bool reset=false);
+
+	int releaseMemory(int* reclaimed=NULL);
+
+	void setMemoryLimit(sqlite3_int64 bytes);
+	sqlite3_int64 getMemoryLimit(void);
+	sqlite3_int64 getBytesReclaimed(void);
+	int getNumEvictions(void);
+	int getNumReleases(void);
+
+	int execute(const char* sql, sqlite3_callback callback=NULL, void* usrPtr=NULL);
+	int prepare(CStatement** stmt, const char* sql);
+
+	int createFunction(const char* name, int numArgs, int flags, CFunction* function);
+
+	int createTextIndex(const char* name, const char** columns, int numColumns, const char* tokenizer=NULL);
+	int prepareSearch(CStatement** stmt, const char* name, const char* open="[", const char* close="]", const char* ellipsis="...", int tokens=10);
+
+	int executeDeferred(const char* sql, DeferredCallback callback, void* usrPtr);
+	void holdQueue(ILuaObject* self);
+	void setDeferredTimeout(double milliseconds);
+	void setBatching(bool onoff);
+
+	int getNumQueued(void);
+	int getNumBusy(void);
+	int getNumDeferred(void);
+	int getNumRetried(void);
+	int getNumAbandoned(void);
+	double getRetryLatencyAverage(void);
+	double getRetryLatencyMax(void);
+
+	int getNumBusyWaits(void);
+	int getNumLockTimeouts(void);
+	double getLockWaitTotal(void);
+	double getLockWaitMax(void);
+	int getNumBatches(void);
+	int getNumBatched(void);
+
+	int setResultCache(sqlite3_int64 maxBytes, double maxAge);
+	CQueryCache* getResultCache(void);
+
+	CStatement* getFirstStatement(void);
+	CStatement* getNextStatement(CStatement* stmt);
+	int getNumStatements(void);
+	int getNumLeakedStatements(void);
+	int getNumClosedStatements(void);
+
+	int openBlob(CBlob** blob, const char* table, const char* column, sqlite3_int64 rowid, bool writable, const char* dbName="main");
+
+	int backupTo(CBackup** backup, const char* fileName, int pagesPerStep);
+	int backupTo(CBackup** backup, CDatabase* destination, int pagesPerStep);
+
+	// Called by a backup into this database as it starts and finishes
+	void beginIncoming(void);
+	void endIncoming(void);
+
+	int openInMemory(const char* fileName, int flags, double snapshotInterval);
+	bool isInMemory(void);
+
+	int snapshot(void);
+
+	double getSnapshotLag(void);
+	int getSnapshotChanges(void);
+	bool isSnapshotDirty(void);
+	double getSnapshotDuration(void);
+	int getNumSnapshots(void);
+	int getNumSnapshotFailures(void);
+	int getSnapshotResult(void);
+	bool isSnapshotting(void);
+
+	int startCheckpointer(int intervalMs, int idleMs);
+	void stopCheckpointer(void);
+	CCheckpointer* getCheckpointer(void);
+
+	void think(void);
+	static void thinkAll(void);
+
+	// Closes every open database along with its blobs, for when the module unloads
+	static void closeAll(void);
+
+};
+
+#endif
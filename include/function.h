@@ -0,0 +1,59 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_FUNCTION_H_
+#define _INCLUDE_FUNCTION_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+// A Lua function registered as an SQL function. The Lua references are held for as long as SQLite keeps the
+// function and released through xDestroy, arguments are pushed straight onto the stack so a call allocates nothing.
+// Aggregates get step(state, ...) returning the new state and final(state) returning the result, state starts as nil.
+
+class CFunction
+{
+
+private:
+
+	ILuaObject* m_pFunction;
+	ILuaObject* m_pStep;
+	ILuaObject* m_pFinal;
+
+	static void pushArguments(int argc, sqlite3_value** argv);
+	static bool setResult(sqlite3_context* context, ILuaObject* result);
+
+public:
+
+	CFunction(ILuaObject* function);
+	CFunction(ILuaObject* step, ILuaObject* final);
+	~CFunction(void);
+
+	bool isAggregate(void);
+
+	static void xFunc(sqlite3_context* context, int argc, sqlite3_value** argv);
+	static void xStep(sqlite3_context* context, int argc, sqlite3_value** argv);
+	static void xFinal(sqlite3_context* context);
+	static void xDestroy(void* usrPtr);
+
+};
+
+#endif
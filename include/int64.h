@@ -0,0 +1,60 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_INT64_H_
+#define _INCLUDE_INT64_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+// Lua numbers can't hold every 64-bit integer, so they cross the boundary as decimal strings.
+// Strings also make good table keys and match what SteamID64 already returns.
+
+#define INT64_STRING_LENGTH 21
+
+// Writes value into buffer, which must hold at least INT64_STRING_LENGTH characters
+const char* Int64ToString(sqlite3_int64 value, char* buffer);
+
+// Returns false if the string isn't an integer or doesn't fit in 64 bits
+bool StringToInt64(const char* string, sqlite3_int64* value);
+
+// Reads either a number or a decimal string from the Lua stack
+bool LuaGetInt64(int stackPos, sqlite3_int64* value);
+
+// The same for arguments that must be given, raises a Lua argument error for anything that isn't a whole number
+sqlite3_int64 LuaCheckInt64(int stackPos);
+
+// Pushes the value as a decimal string
+void LuaPushInt64(sqlite3_int64 value);
+
+// Stores the value in a table the same way LuaPushInt64 pushes it
+void LuaSetMemberInt64(ILuaObject* table, float key, sqlite3_int64 value);
+void LuaSetMemberInt64(ILuaObject* table, const char* key, sqlite3_int64 value);
+
+// Numbers reach Lua through a float, which holds every integer up to 2^24 exactly
+#define INT64_FLOAT_EXACT 16777216
+
+// Pushes the value as a number while the float keeps it exact, as a decimal string beyond that
+void LuaPushInteger(sqlite3_int64 value);
+void LuaSetMemberInteger(ILuaObject* table, float key, sqlite3_int64 value);
+void LuaSetMemberInteger(ILuaObject* table, const char* key, sqlite3_int64 value);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_JSON_H_
+#define _INCLUDE_JSON_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+// Converts between Lua values and JSON text without going through Lua.
+//
+// Tables whose keys are exactly 1..n become arrays, any other table becomes an object with its keys turned into
+// strings. Functions, userdata and cycles deeper than JSON_MAX_DEPTH can not be encoded. Decoding maps null to nil,
+// so nulls inside arrays leave holes. Integers beyond 2^24 decode to decimal strings so they stay exact, see LuaPushInteger.
+
+#define JSON_MAX_DEPTH 64
+
+// The members of a table being encoded, shared with packed.cpp so both formats agree on what is an array.
+// ppValues holds the values in index order when the keys are exactly 1..iCount and is NULL for a map.
+struct LuaTableWalk
+{
+	CUtlLuaVector* pMembers;
+	ILuaObject** ppValues;
+	int iCount;
+};
+
+// Returns false if the members could not be read, LuaTableWalkEnd has to be called otherwise
+bool LuaTableWalkBegin(ILuaObject* table, LuaTableWalk* walk);
+void LuaTableWalkEnd(LuaTableWalk* walk);
+
+// Lua strings may hold NULs, these go through the stack so their length is kept. The pointer stays valid
+// for as long as the object is referenced, the new string is returned as a reference the caller releases.
+const char* LuaObjectString(ILuaObject* value, unsigned int* length);
+ILuaObject* LuaNewString(const char* value, unsigned int length);
+
+// Appends value as JSON to out, returns false if something in it can not be represented
+bool JsonEncode(ILuaObject* value, sqlite3_str* out);
+
+// Returns the decoded value, or NULL if text is not valid JSON. The caller releases the reference.
+ILuaObject* JsonDecode(const char* text, int length);
+
+#endif
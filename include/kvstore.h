@@ -0,0 +1,95 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_KVSTORE_H_
+#define _INCLUDE_KVSTORE_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+class CDatabase;
+class CStatement;
+
+// A single value to bind, iType is one of SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL
+struct KVValue
+{
+	int iType;
+	sqlite3_int64 iInteger;
+	double dFloat;
+	const char* pData;
+	int iLength;
+};
+
+// Called with the statement positioned on the value, which is always column 0
+typedef void (*KVCallback)(void* usrPtr, CStatement* row);
+
+// Key-value access on top of a two column table (k TEXT PRIMARY KEY, v), created if it does not exist.
+// Every statement is prepared once and reused, the increment ones only on first use since they depend on the SQLite
+// version. Batches run inside a savepoint so they also nest in a transaction the caller already has open.
+
+class CKVStore
+{
+
+private:
+
+	CStatement* m_pGet;
+	CStatement* m_pSet;
+	CStatement* m_pDelete;
+
+	// UPSERT ... RETURNING from SQLite 3.35 on, before that an insert of 0 and an update run in a savepoint
+	CStatement* m_pIncrement;
+	CStatement* m_pInsertZero;
+	CStatement* m_pAdd;
+
+	CDatabase* m_pDatabase;
+	char* m_pszName;
+
+	CStatement* m_pBegin;
+	CStatement* m_pCommit;
+	CStatement* m_pRollback;
+
+	static int bindValue(CStatement* stmt, int index, const KVValue& value);
+	static int run(CStatement* stmt);
+
+	int prepareIncrement(void);
+	int incrementInSavepoint(const KVValue& key, const KVValue& delta, KVCallback callback, void* usrPtr);
+
+public:
+
+	CKVStore(void);
+	~CKVStore(void);
+
+	static int create(CKVStore** store, CDatabase* database, const char* name);
+
+	// Returns SQLITE_OK without calling back when the key is not set
+	int get(const KVValue& key, KVCallback callback, void* usrPtr);
+	int set(const KVValue& key, const KVValue& value);
+	int remove(const KVValue& key);
+
+	// Adds delta to the stored number, a missing key counts as 0
+	int increment(const KVValue& key, const KVValue& delta, KVCallback callback, void* usrPtr);
+
+	int beginBatch(void);
+	int endBatch(bool commit);
+
+};
+
+#endif
@@ -0,0 +1,44 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_NATIVES_H_
+#define _INCLUDE_NATIVES_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+// Game math SQL functions and collations implemented in C++, registered on every database as it is opened.
+//
+//   dist3(x1, y1, z1, x2, y2, z2)					distance between two points
+//   dist2(x1, y1, x2, y2)							distance ignoring height
+//   vec_len(x, y[, z])								length of a vector
+//   inbox(x, y, z, x1, y1, z1, x2, y2, z2)			1 when the point is inside the box spanned by the two corners
+//   bitpack(value, bits[, value, bits ...])		packs fields into one integer, the first field in the lowest bits
+//   bitunpack(packed, offset, bits)				reads a field back out
+//
+//   COLLATE ASCII_NOCASE		compares A-Z as a-z and leaves every other byte alone
+//   COLLATE NATSORT			like ASCII_NOCASE but runs of digits compare by value, so "item9" sorts before "item10"
+//
+// Every function is deterministic, so they can be used in index expressions. Any NULL argument gives NULL.
+
+int RegisterNatives(sqlite3* db);
+
+#endif
@@ -0,0 +1,55 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_PACKED_H_
+#define _INCLUDE_PACKED_H_
+
+#include "module.h"
+
+// Converts between Lua values and a MessagePack encoded BLOB without going through Lua.
+//
+// Whole numbers are stored in the smallest integer that holds them and fractions as float32 whenever that is exact,
+// so the small numeric tables most addons persist take a fraction of their JSON size. Arrays and maps follow the same
+// rules as json.h, map keys have to be strings or numbers.
+
+#define PACKED_MAX_DEPTH 64
+#define PACKED_INLINE_SIZE 512
+
+// Output buffer, small values never leave the inline storage
+struct PackBuffer
+{
+	unsigned char* pData;
+	int iLength;
+	int iCapacity;
+	bool bOutOfMemory;
+	unsigned char aInline[PACKED_INLINE_SIZE];
+};
+
+void PackBufferInit(PackBuffer* buffer);
+void PackBufferFree(PackBuffer* buffer);
+
+// Appends value to buffer, returns false if something in it can not be represented
+bool PackEncode(ILuaObject* value, PackBuffer* buffer);
+
+// Returns the decoded value, or NULL if data is not a single valid value. The caller releases the reference.
+ILuaObject* PackDecode(const void* data, int length);
+
+#endif
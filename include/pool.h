@@ -0,0 +1,80 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_POOL_H_
+#define _INCLUDE_POOL_H_
+
+#include "module.h"
+#include <stddef.h>
+
+// Free list of fixed size blocks carved out of larger chunks.
+// Freed blocks are kept for reuse, the chunks are only released by the destructor and only if nothing is live.
+// Not thread safe, only the game thread allocates from these.
+
+class CPool
+{
+
+private:
+
+	struct Block { Block* pNext; };
+	struct Chunk { Chunk* pNext; };
+
+	size_t m_iBlockSize;
+	int m_iBlocksPerChunk;
+
+	Block* m_pFree;
+	Chunk* m_pChunks;
+
+	int m_iLive;
+	int m_iPeak;
+	int m_iReserved;
+	int m_iAllocs;
+	int m_iReused;
+
+	bool grow(void);
+
+public:
+
+	CPool(size_t blockSize, int blocksPerChunk);
+	~CPool(void);
+
+	void* alloc(void);
+	void free(void* ptr);
+
+	size_t getBlockSize(void);
+
+	int getLive(void);
+	int getPeak(void);
+	int getReserved(void);
+	int getAllocs(void);
+	int getReused(void);
+
+};
+
+// Short lived arrays (bind pins, result schemas) come from a few size classes, anything larger goes to the heap
+
+void* ScratchAlloc(size_t size);
+void ScratchFree(void* ptr, size_t size);
+
+int GetNumScratchPools(void);
+CPool* GetScratchPool(int index);
+
+#endif
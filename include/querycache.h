@@ -0,0 +1,208 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_QUERYCACHE_H_
+#define _INCLUDE_QUERYCACHE_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+// Result rows of a statement run with one set of parameters, shared by every statement serving it
+struct CachedResult
+{
+	char* pszKey;				// sqlite3_expanded_sql, the statement with its parameters filled in
+	unsigned int iHash;
+	char* pszTables;			// tables read, each terminated, the list ends with an empty name
+	int iNumRows;
+	int iNumColumns;
+	sqlite3_value** ppValues;	// iNumRows * iNumColumns copies
+	sqlite3_int64 iBytes;
+	double dStored;
+	int iRefs;					// the cache itself and every statement reading from it
+	CachedResult* pNextInBucket;
+	CachedResult* pPrev;		// least recently used order, newest first
+	CachedResult* pNext;
+};
+
+// What a statement needs to take part in the cache, worked out by the authorizer while it is prepared
+struct StatementCacheInfo
+{
+	char* pszReads;				// NULL if the statement can not be cached
+	char* pszWrites;			// NULL if it does not write, "*" stands for a schema change
+
+	// Parameters the expanded SQL can't show exactly: pointers, reals it rounds to 15 digits and text it cuts at a NUL.
+	// A bit per index, the top one standing for every index past 63. Statements with any of these bound aren't cached.
+	sqlite3_uint64 iInexactParams;
+	bool bStarted;				// stepped since the last reset
+	bool bDone;
+
+	CachedResult* pServing;		// rows come from here instead of the VDBE when set
+	int iRow;
+
+	// Rows copied out while the VDBE runs, stored once it reaches SQLITE_DONE
+	char* pszRecordKey;
+	sqlite3_value** ppRecorded;
+	int iNumRecorded;
+	int iRecordCapacity;
+	sqlite3_int64 iRecordBytes;
+	unsigned int iGeneration;	// a write while recording makes the rows unsafe to store
+};
+
+struct CacheTable;
+
+// Opt-in result cache of a single connection.
+//
+// Read-only statements prepared while the cache is on are keyed by their expanded SQL, so the same statement with the
+// same parameters is answered from memory until one of the tables it reads is written. Writes are caught by the update
+// hook for rowid tables and by the tables each statement was prepared to write (WITHOUT ROWID tables, virtual tables,
+// truncating deletes). Tables written in an open transaction bypass the cache until it ends, so nothing uncommitted is
+// ever stored. Writes from other connections are not seen, maxAge bounds how stale that can make an entry.
+//
+// Statements calling a function that is not registered as SQLITE_DETERMINISTIC (built-in aggregates aside), the date
+// and time functions, PRAGMAs and transaction control are not cached, nor are statements with a real, a pointer or text
+// holding a NUL bound, which the expanded SQL can't render exactly. Nothing is cached while a backup writes into the
+// connection.
+//
+// The cache takes over the connection's authorizer, update hook and rollback hook while it exists, anything else set
+// through sqlite3_set_authorizer and the like is replaced.
+
+class CQueryCache
+{
+
+private:
+
+	sqlite3* m_pDatabase;
+
+	sqlite3_int64 m_iMaxBytes;
+	double m_dMaxAge;
+
+	CachedResult** m_ppBuckets;
+	int m_iNumBuckets;
+	CachedResult* m_pNewest;
+	CachedResult* m_pOldest;
+	int m_iNumEntries;
+	sqlite3_int64 m_iBytes;
+
+	// How many entries read each table, so writes to tables nothing depends on return straight away
+	CacheTable* m_pTables;
+	unsigned int m_iGeneration;
+
+	// Tables written in the transaction that is open, cleared once the connection is back in autocommit
+	sqlite3_str* m_pDirty;
+	bool m_bAllDirty;
+
+	// A backup from another connection is writing pages into this one, the hooks see none of them
+	bool m_bIncoming;
+
+	// Gathered by the authorizer while CDatabase::prepare runs
+	bool m_bCollecting;
+	sqlite3_str* m_pReads;
+	sqlite3_str* m_pWrites;
+	sqlite3_str* m_pCalls;
+	bool m_bVolatile;
+
+	// Functions that may give different results for the same arguments, read from pragma_function_list when a
+	// statement first calls one. Without that pragma every function counts as volatile.
+	sqlite3_str* m_pVolatileFunctions;
+	bool m_bFunctionsLoaded;
+	bool m_bFunctionsKnown;
+
+	sqlite3_int64 m_iHits;
+	sqlite3_int64 m_iMisses;
+	sqlite3_int64 m_iStores;
+	sqlite3_int64 m_iInvalidations;
+	sqlite3_int64 m_iEvictions;
+	sqlite3_int64 m_iBypasses;
+
+	static int authorizer(void* usrPtr, int action, const char* arg1, const char* arg2, const char* dbName, const char* trigger);
+	static void updateHook(void* usrPtr, int op, const char* dbName, const char* table, sqlite3_int64 rowid);
+	static void rollbackHook(void* usrPtr);
+
+	static bool listContains(const char* list, int length, const char* name);
+	static void listAdd(sqlite3_str* list, const char* name);
+
+	void markDirty(const char* table);
+	bool isDirty(const char* tables);
+
+	void loadFunctions(void);
+	bool callsVolatile(void);
+
+	CacheTable* findTable(const char* name, bool create);
+
+	CachedResult* lookup(const char* key);
+	void store(StatementCacheInfo* info, int columns);
+	void remove(CachedResult* entry);
+	void evict(void);
+
+	static void releaseResult(CachedResult* entry);
+	static void discardRecording(StatementCacheInfo* info);
+
+public:
+
+	CQueryCache(sqlite3* db, sqlite3_int64 maxBytes, double maxAge);
+	~CQueryCache(void);
+
+	void setLimits(sqlite3_int64 maxBytes, double maxAge);
+
+	// Wrapped around sqlite3_prepare_v2, endPrepare returns NULL for statements with nothing to track
+	void beginPrepare(void);
+	StatementCacheInfo* endPrepare(sqlite3_stmt* stmt);
+
+	// For statements prepared before the cache existed, only what they write is tracked and their rows are never cached
+	StatementCacheInfo* trackWrites(sqlite3_stmt* stmt);
+
+	int step(sqlite3_stmt* stmt, StatementCacheInfo* info);
+
+	// Drops every entry that read the table, "*" drops everything
+	void invalidate(const char* table);
+	void flush(void);
+
+	// A write the hooks can not see, like an incremental blob write. Also keeps the table out of the cache until the
+	// open transaction ends.
+	void tableWritten(const char* table);
+
+	// Called when a function is created or replaced, what it returns may have changed
+	void functionsChanged(void);
+
+	// Drops everything and bypasses the cache while a backup writes into the connection
+	void setIncoming(bool incoming);
+
+	static void resetInfo(StatementCacheInfo* info);
+	static void freeInfo(StatementCacheInfo* info);
+
+	// The column of the current cached row, or NULL when the statement is not reading from the cache
+	static sqlite3_value* getValue(StatementCacheInfo* info, int column);
+
+	int getNumEntries(void);
+	sqlite3_int64 getBytes(void);
+	sqlite3_int64 getMaxBytes(void);
+	sqlite3_int64 getNumHits(void);
+	sqlite3_int64 getNumMisses(void);
+	sqlite3_int64 getNumStores(void);
+	sqlite3_int64 getNumInvalidations(void);
+	sqlite3_int64 getNumEvictions(void);
+	sqlite3_int64 getNumBypasses(void);
+
+	void resetStats(void);
+
+};
+
+#endif
@@ -0,0 +1,69 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_SPATIAL_H_
+#define _INCLUDE_SPATIAL_H_
+
+#include "module.h"
+#include <sqlite3.h>
+
+class CDatabase;
+class CStatement;
+
+// R*Tree supports between one and five dimensions
+#define SPATIAL_MAX_DIMENSIONS 5
+
+typedef void (*SpatialCallback)(void* usrPtr, sqlite3_int64 id);
+
+// A bounding box index on top of an rtree virtual table named after the index, with the columns
+// id, min0, max0, min1, max1 and so on. Statements are prepared once and tracked by the database like any other.
+
+class CSpatialIndex
+{
+
+private:
+
+	int m_iDimensions;
+
+	CStatement* m_pInsert;
+	CStatement* m_pRemove;
+	CStatement* m_pQuery;
+
+	int bindBox(CStatement* stmt, int firstIndex, const double* min, const double* max);
+
+public:
+
+	CSpatialIndex(int dimensions);
+	~CSpatialIndex(void);
+
+	static int create(CSpatialIndex** index, CDatabase* database, const char* name, int dimensions);
+
+	int getDimensions(void);
+
+	int insert(sqlite3_int64 id, const double* min, const double* max);
+	int remove(sqlite3_int64 id);
+
+	int queryBox(const double* min, const double* max, SpatialCallback callback, void* usrPtr);
+	int queryRadius(const double* center, double radius, SpatialCallback callback, void* usrPtr);
+
+};
+
+#endif
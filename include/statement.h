@@ -1,102 +1,186 @@
-/*
-
-    Gm_sqlite3 the improved sqlite library for Garry's Mod
-    Copyright (C) 2010 James John Kelly Jr
-
-	This library is free software; you can redistribute it and/or
-	modify it under the terms of the GNU Lesser General Public
-	License as published by the Free Software Foundation; either
-	version 2.1 of the License, or (at your option) any later version.
-
-	This library is distributed in the hope that it will be useful,
-	but WITHOUT ANY WARRANTY; without even the implied warranty of
-	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-	Lesser General Public License for more details.
-
-	You should have received a copy of the GNU Lesser General Public
-	License along with this library; if not, write to the Free Software
-	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
-
-*/
-
-#ifndef _INCLUDE_STATEMENT_H_
-#define _INCLUDE_STATEMENT_H_
-
-#include "module.h"
-#include <sqlite3.h>
-
-#ifndef CDatabase
-class CDatabase;
-#endif
-
-class CStatement
-{
-
-private:
-
-	sqlite3_stmt* m_pStmt;
-
-public:
-
-	CStatement(int code, sqlite3_stmt* stmt);
-	~CStatement(void);
-
-	int finalize(void);
-
-	const char* getSql(void);
-
-	int step(void);
-	int reset(void);
-	int clearBindings(void);
-
-	int getNumberOfParameters(void);
-	const char* getParameterName(int index);
-	int getParameterIndex(const char* name);
-
-	int bindNull(int index);
-	int bindNull(const char* name);
-
-	int bindInteger(int index, int value);
-	int bindInteger(const char* name, int value);
-
-	int bindInt64(int index, sqlite3_int64 value);
-	int bindInt64(const char* name, sqlite3_int64 value);
-
-	int bindFloat(int index, float value);
-	int bindFloat(const char* name, float value);
-
-	int bindDouble(int index, double value);
-	int bindDouble(const char* name, double value);
-
-	int bindText(int index, const char* value);
-	int bindText(const char* name, const char* value);
-
-	int bindBlob(int index, const char* value, int length);
-	int bindBlob(const char* name, const char* value, int length);
-
-	int getNumberOfColumns(void);
-	const char* getColumnName(int index);
-	int getColumnIndex(const char* name);
-	int getColumnType(int index);
-
-	int getInteger(int index);
-	int getInteger(const char* name);
-
-	sqlite3_int64 getInt64(int index);
-	sqlite3_int64 getInt64(const char* name);
-
-	float getFloat(int index);
-	float getFloat(const char* name);
-
-	double getDouble(int index);
-	double getDouble(const char* name);
-
-	const char* getText(int index);
-	const char* getText(const char* name);
-
-	const void* getBlob(int index, int* length);
-	const void* getBlob(const char* name, int* length);
-
-};
-
-#endif
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_STATEMENT_H_
+#define _INCLUDE_STATEMENT_H_
+
+#include "module.h"
+#include "pool.h"
+#include "querycache.h"
+#include <sqlite3.h>
+
+#ifndef CDatabase
+class CDatabase;
+#endif
+
+class CStatement;
+
+// Decodes a single column of the current row into a Lua table
+
+typedef void (*ColumnDecoder)(CStatement* pStatement, ILuaObject* pRow, const char* pszName, int index);
+
+// A declared result column, the name and decoder are resolved once when the schema is set. The first row of every
+// result set checks the storage class, pResolved is the decoder the rest of the set uses.
+
+struct ResultColumn
+{
+	int iType;
+	const char* pszName;
+	ColumnDecoder pDecoder;
+	ColumnDecoder pResolved;
+};
+
+class CStatement
+{
+
+	friend class CDatabase;
+
+private:
+
+	sqlite3_stmt* m_pStmt;
+
+	// Live statements are linked into their database so it can finalize them before closing
+	CDatabase* m_pOwner;
+	CStatement* m_pPrevLive;
+	CStatement* m_pNextLive;
+	double m_dCreated;
+
+	ResultColumn* m_pSchema;
+	int m_iSchemaSize;
+
+	// Rows returned since the result set started, 1 while on its first row
+	int m_iRow;
+
+	// Lua strings bound with SQLITE_STATIC, held until their parameter is rebound, cleared or finalized
+	ILuaObject** m_ppPins;
+	int m_iNumPins;
+
+	// Set while the database has a result cache, rows may then come from the cache instead of the VDBE
+	StatementCacheInfo* m_pCacheInfo;
+
+	sqlite3_value* getCachedValue(int index);
+	void setExactParam(int index, bool exact);
+
+	bool canPin(int index);
+	void pin(int index, ILuaObject* value);
+	void releasePin(int index);
+	void releasePins(void);
+
+	int bindStatic(int index, const char* value, int length, ILuaObject* owner, bool isText);
+
+	// Statements are prepared and collected constantly, so they are recycled instead of going through the heap
+	static CPool s_Pool;
+
+public:
+
+	CStatement(int code, sqlite3_stmt* stmt, CDatabase* owner=NULL);
+	~CStatement(void);
+
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr, size_t size);
+	static CPool* getPool(void);
+
+	int finalize(void);
+	bool isFinalized(void);
+
+	double getAge(void);
+
+	const char* getSql(void);
+
+	int step(void);
+	int reset(void);
+	int clearBindings(void);
+
+	int getRow(void);
+
+	int getNumberOfParameters(void);
+	const char* getParameterName(int index);
+	int getParameterIndex(const char* name);
+
+	int bindNull(int index);
+	int bindNull(const char* name);
+
+	int bindInteger(int index, int value);
+	int bindInteger(const char* name, int value);
+
+	int bindInt64(int index, sqlite3_int64 value);
+	int bindInt64(const char* name, sqlite3_int64 value);
+
+	int bindFloat(int index, float value);
+	int bindFloat(const char* name, float value);
+
+	int bindDouble(int index, double value);
+	int bindDouble(const char* name, double value);
+
+	int bindText(int index, const char* value);
+	int bindText(const char* name, const char* value);
+
+	int bindText(int index, const char* value, int length);
+	int bindText(const char* name, const char* value, int length);
+
+	int bindTextStatic(int index, const char* value, int length, ILuaObject* owner);
+	int bindTextStatic(const char* name, const char* value, int length, ILuaObject* owner);
+
+	int bindBlob(int index, const char* value, int length);
+	int bindBlob(const char* name, const char* value, int length);
+
+	int bindBlobStatic(int index, const char* value, int length, ILuaObject* owner);
+	int bindBlobStatic(const char* name, const char* value, int length, ILuaObject* owner);
+
+	// SQLite owns value from here on and calls destroy once it is rebound or finalized, even if binding fails
+	int bindPointer(int index, void* value, const char* type, void (*destroy)(void*));
+	int bindPointer(const char* name, void* value, const char* type, void (*destroy)(void*));
+
+	int getNumberOfColumns(void);
+	const char* getColumnName(int index);
+	int getColumnIndex(const char* name);
+	int getColumnType(int index);
+
+	int getStatus(int op, bool reset=false);
+
+	int getInteger(int index);
+	int getInteger(const char* name);
+
+	sqlite3_int64 getInt64(int index);
+	sqlite3_int64 getInt64(const char* name);
+
+	float getFloat(int index);
+	float getFloat(const char* name);
+
+	double getDouble(int index);
+	double getDouble(const char* name);
+
+	const char* getText(int index);
+	const char* getText(const char* name);
+
+	const void* getBlob(int index, int* length);
+	const void* getBlob(const char* name, int* length);
+
+	int setResultSchema(const ResultColumn* columns, int count);
+	void clearResultSchema(void);
+	const ResultColumn* getResultSchema(int* count);
+
+	// Picks the declared decoder for every column the current row matches and fallback for the others
+	void resolveResultSchema(ColumnDecoder fallback);
+
+};
+
+#endif
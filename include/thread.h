@@ -0,0 +1,111 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef _INCLUDE_THREAD_H_
+#define _INCLUDE_THREAD_H_
+
+#include "module.h"
+
+#if !_WIN32
+#include <pthread.h>
+#endif
+
+// Minimal threading primitives for work that has to stay off the game thread.
+// Nothing running on these threads may touch g_pLua.
+
+class CMutex
+{
+
+private:
+
+#if _WIN32
+	CRITICAL_SECTION m_Section;
+#else
+	pthread_mutex_t m_Mutex;
+#endif
+
+public:
+
+	CMutex(void);
+	~CMutex(void);
+
+	void lock(void);
+	void unlock(void);
+
+};
+
+// Locks a mutex for the lifetime of the scope
+
+class CAutoLock
+{
+
+private:
+
+	CMutex* m_pMutex;
+
+public:
+
+	CAutoLock(CMutex* mutex) : m_pMutex(mutex) { m_pMutex->lock(); }
+	~CAutoLock(void) { m_pMutex->unlock(); }
+
+};
+
+typedef void (*ThreadFunction)(void* usrPtr);
+
+class CThread
+{
+
+private:
+
+#if _WIN32
+	HANDLE m_hThread;
+#else
+	pthread_t m_Thread;
+	bool m_bStarted;
+#endif
+
+	ThreadFunction m_pFunction;
+	void* m_pUsrPtr;
+
+#if _WIN32
+	static DWORD WINAPI entry(LPVOID param);
+#else
+	static void* entry(void* param);
+#endif
+
+public:
+
+	CThread(void);
+	~CThread(void);
+
+	bool start(ThreadFunction function, void* usrPtr);
+	void join(void);
+
+	bool isRunning(void);
+
+};
+
+void ThreadSleep(int milliseconds);
+
+// Milliseconds from an arbitrary fixed point, only useful for measuring intervals
+double GetTimeMilliseconds(void);
+
+#endif
@@ -0,0 +1,136 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "LuaBackup.h"
+#include "backup.h"
+
+//-----------------------------------------------------------------------------
+// Backup functions
+//-----------------------------------------------------------------------------
+
+LUA_FUNCTION(BackupDelete)
+{
+
+	BACKUP_FROM_LUA();
+
+	ASSERT(pBackup != NULL);
+	if( pBackup )
+	{
+		delete pBackup;
+		pBackup = NULL;
+	}
+
+	return 0;
+
+}
+
+
+// Copies up to the given number of pages, or the amount passed to BackupTo when omitted
+LUA_FUNCTION(BackupStep)
+{
+
+	BACKUP_FROM_LUA();
+
+	ASSERT(pBackup != NULL);
+	if( pBackup )
+	{
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			g_pLua->Push((float)pBackup->step(g_pLua->GetInteger(2)));
+		} else {
+			g_pLua->Push((float)pBackup->step());
+		}
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(BackupFinish)
+{
+
+	BACKUP_FROM_LUA();
+
+	ASSERT(pBackup != NULL);
+	if( pBackup )
+	{
+		g_pLua->Push((float)pBackup->finish());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(BackupIsDone)
+{
+
+	BACKUP_FROM_LUA();
+
+	ASSERT(pBackup != NULL);
+	if( pBackup )
+	{
+		g_pLua->Push((bool)pBackup->isDone());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(BackupRemaining)
+{
+
+	BACKUP_FROM_LUA();
+
+	ASSERT(pBackup != NULL);
+	if( pBackup )
+	{
+		g_pLua->Push((float)pBackup->getRemaining());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(BackupPageCount)
+{
+
+	BACKUP_FROM_LUA();
+
+	ASSERT(pBackup != NULL);
+	if( pBackup )
+	{
+		g_pLua->Push((float)pBackup->getPageCount());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
@@ -0,0 +1,196 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "LuaBlob.h"
+#include "blob.h"
+#include "int64.h"
+
+//-----------------------------------------------------------------------------
+// Blob functions
+//-----------------------------------------------------------------------------
+
+LUA_FUNCTION(BlobDelete)
+{
+
+	BLOB_FROM_LUA();
+
+	ASSERT(pBlob != NULL);
+	if( pBlob )
+	{
+		delete pBlob;
+		pBlob = NULL;
+	}
+
+	return 0;
+
+}
+
+
+LUA_FUNCTION(BlobClose)
+{
+
+	BLOB_FROM_LUA();
+
+	ASSERT(pBlob != NULL);
+	if( pBlob )
+	{
+		g_pLua->Push((float)pBlob->close());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(BlobSize)
+{
+
+	BLOB_FROM_LUA();
+
+	ASSERT(pBlob != NULL);
+	if( pBlob )
+	{
+		g_pLua->Push((float)pBlob->getSize());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+// Returns at most n bytes starting at offset as a string, reads past the end are clamped
+LUA_FUNCTION(BlobRead)
+{
+
+	BLOB_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	g_pLua->CheckType(3, GLua::TYPE_NUMBER);
+
+	ASSERT(pBlob != NULL);
+	if( pBlob )
+	{
+
+		int offset = g_pLua->GetInteger(2);
+		int length = g_pLua->GetInteger(3);
+		int size = pBlob->getSize();
+
+		if( offset < 0 || length < 0 || offset > size ) {
+			g_pLua->PushNil();
+			g_pLua->Push((float)SQLITE_RANGE);
+			return 2;
+		}
+
+		if( length > size - offset ) {
+			length = size - offset;
+		}
+
+		if( length == 0 ) {
+			g_pLua->Push((const char*)"", 0);
+			g_pLua->Push((float)SQLITE_OK);
+			return 2;
+		}
+
+		char* pBuffer = pBlob->getBuffer(length);
+		if( !pBuffer ) {
+			g_pLua->PushNil();
+			g_pLua->Push((float)SQLITE_NOMEM);
+			return 2;
+		}
+
+		int retcode = pBlob->read(pBuffer, length, offset);
+
+		if( retcode == SQLITE_OK ) {
+			g_pLua->Push((const char*)pBuffer, (unsigned int)length);
+		} else {
+			g_pLua->PushNil();
+		}
+
+		g_pLua->Push((float)retcode);
+		return 2;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// Writes can't change the size of a blob, use zeroblob() when inserting the row to reserve space
+LUA_FUNCTION(BlobWrite)
+{
+
+	BLOB_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	g_pLua->CheckType(3, GLua::TYPE_STRING);
+
+	ASSERT(pBlob != NULL);
+	if( pBlob )
+	{
+
+		unsigned int length = 0;
+		const char* pData = g_pLua->GetString(3, &length);
+
+		g_pLua->Push((float)pBlob->write(pData, (int)length, g_pLua->GetInteger(2)));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(BlobReopen)
+{
+
+	BLOB_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+
+	ASSERT(pBlob != NULL);
+	if( pBlob )
+	{
+
+		sqlite3_int64 rowid = 0;
+		if( !LuaGetInt64(2, &rowid) ) {
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 1;
+		}
+
+		g_pLua->Push((float)pBlob->reopen(rowid));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
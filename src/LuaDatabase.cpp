@@ -1,364 +1,1586 @@
-/*
-
-    Gm_sqlite3 the improved sqlite library for Garry's Mod
-    Copyright (C) 2010 James John Kelly Jr
-
-	This library is free software; you can redistribute it and/or
-	modify it under the terms of the GNU Lesser General Public
-	License as published by the Free Software Foundation; either
-	version 2.1 of the License, or (at your option) any later version.
-
-	This library is distributed in the hope that it will be useful,
-	but WITHOUT ANY WARRANTY; without even the implied warranty of
-	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-	Lesser General Public License for more details.
-
-	You should have received a copy of the GNU Lesser General Public
-	License along with this library; if not, write to the Free Software
-	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
-
-*/
-
-#include "LuaDatabase.h"
-#include "database.h"
-#include "statement.h"
-
-//-----------------------------------------------------------------------------
-// Database functions
-//-----------------------------------------------------------------------------
-
-static int DatabaseExecCallback(void* usrPtr, int numColumns, char** values, char** columns)
-{
-
-	ASSERT(usrPtr != NULL);
-	if( !usrPtr ) return SQLITE_ABORT; // THIS SHOULD NOT BE HAPPENING AAAAAHHHH!!!
-
-	ILuaObject* pColumns = g_pLua->GetNewTable();
-
-	ASSERT(pColumns != NULL);
-	if( !pColumns ) { return SQLITE_ABORT; }
-
-	ILuaObject* pValues = g_pLua->GetNewTable();
-	
-	ASSERT(pValues != NULL);
-	if( !pValues ) { SAFE_UNREF(pColumns); return SQLITE_ABORT; }
-
-	for( int i = 0; i < numColumns; i++ ) {
-		pColumns->SetMember((float)i, columns[i]);
-		pValues->SetMember((float)i, values[i]);
-	}
-
-	((ILuaObject*)usrPtr)->Push();
-	g_pLua->Push((float)numColumns);
-	pColumns->Push();
-	pValues->Push();
-	g_pLua->Call(3, 1);
-
-	SAFE_UNREF(pColumns);
-	SAFE_UNREF(pValues);
-
-	return (int)(g_pLua->GetInteger(1));
-
-}
-
-LUA_FUNCTION(DatabaseNew)
-{
-
-	CDatabase* pDatabase = new CDatabase();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-
-		ILuaObject* pMeta = g_pLua->GetMetaTable(META_DATABASE, TYPE_DATABASE);
-
-		ASSERT(pMeta != NULL);
-		if( pMeta ) {
-			g_pLua->PushUserData(pMeta, pDatabase);
-			SAFE_UNREF(pMeta);
-			return 1;
-		}
-
-		SAFE_UNREF(pMeta);
-
-	}
-
-	if( pDatabase ) delete pDatabase;
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(DatabaseDelete)
-{
-
-	DATABASE_FROM_LUA();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		delete pDatabase;
-		pDatabase = NULL;
-	}
-
-	return 0;
-
-}
-
-
-LUA_FUNCTION(DatabaseOpen)
-{
-
-	DATABASE_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_STRING);
-	g_pLua->CheckType(3, GLua::TYPE_NUMBER);
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-
-		const char* pszDbName = g_pLua->GetString(2);
-		int flags = g_pLua->GetInteger(3);
-		char pszNewDbName[MAX_PATH];
-
-		int length = strlen(pszDbName);
-		if(  length < 1 || ( length == 1 && pszDbName[0] == '?' ) ) {
-			g_pLua->PushNil();
-			return 1;
-		}
-
-		// For security reasons, don't allow clients to create databases outside memory or game folder just in case they download a malicious script
-		if( g_pLua->IsClient() ) { 
-			if( pszDbName[0] != '?' && stricmp(pszDbName,":memory:") != 0 ) {
-				sprintf(pszNewDbName, "%s%s", modulemanager->GetBaseFolder(), &pszDbName[1]);
-			} else {
-				sprintf(pszNewDbName, "%s", pszDbName);
-			}
-		} else {
-			if( pszDbName[0] == '?' ) {
-				sprintf(pszNewDbName, "%s%s", modulemanager->GetBaseFolder(), &pszDbName[1]);
-			} else {
-				sprintf(pszNewDbName, "%s", pszDbName);
-			}
-		}
-
-		g_pLua->Push((float)pDatabase->open(pszNewDbName, flags, NULL));
-		return 1;
-
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(DatabaseClose)
-{
-
-	DATABASE_FROM_LUA();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		g_pLua->Push((float)pDatabase->close());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(DatabaseIsOpen)
-{
-
-	DATABASE_FROM_LUA();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		g_pLua->Push((bool)pDatabase->isOpen());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(DatabaseExtendedErrors)
-{
-
-	DATABASE_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_BOOL);
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		g_pLua->Push((float)pDatabase->setExtendedErrors(g_pLua->GetBool(2)));
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(DatabaseLastError)
-{
-
-	DATABASE_FROM_LUA();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		g_pLua->Push((float)pDatabase->getErrorCode());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(DatabaseLastErrorMessage)
-{
-	
-	DATABASE_FROM_LUA();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		g_pLua->Push((const char*)pDatabase->getErrorMessage());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(DatabaseLastInsertId)
-{
-
-	DATABASE_FROM_LUA();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		g_pLua->Push((float)pDatabase->getLastInsertId());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(DatabaseChanges)
-{
-
-	DATABASE_FROM_LUA();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		g_pLua->Push((float)pDatabase->getChanges());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(DatabaseTotalChanges)
-{
-
-	DATABASE_FROM_LUA();
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		g_pLua->Push((float)pDatabase->getTotalChanges());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(DatabaseExecute)
-{
-
-	DATABASE_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_STRING);
-
-	ILuaObject* pCallback = NULL;
-
-	if( g_pLua->GetType(3) == GLua::TYPE_FUNCTION ) {
-		pCallback = g_pLua->GetObject(3);
-	} else if( g_pLua->GetType(3) == GLua::TYPE_NIL ) {
-	} else {
-		g_pLua->CheckType(3, GLua::TYPE_FUNCTION);
-	}
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-		int retcode = SQLITE_ERROR;
-		if( pCallback != NULL ) {
-			retcode = pDatabase->execute(g_pLua->GetString(2), DatabaseExecCallback, (void*)pCallback);
-		} else {
-			retcode = pDatabase->execute(g_pLua->GetString(2));
-		}
-		g_pLua->Push((float)retcode);
-		SAFE_UNREF(pCallback);
-		return 1;
-	}
-
-	SAFE_UNREF(pCallback);
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(DatabasePrepare)
-{
-
-	DATABASE_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_STRING);
-
-	CStatement* pStatement = NULL;
-
-	ASSERT(pDatabase != NULL);
-	if( pDatabase ) {
-
-		int retcode = pDatabase->prepare(&pStatement, g_pLua->GetString(2));
-
-		ASSERT(pStatement != NULL);
-		if( pStatement ) {
-
-			ILuaObject* pMeta = g_pLua->GetMetaTable(META_STATEMENT, TYPE_STATEMENT);
-
-			ASSERT(pMeta != NULL);
-			if( pMeta ) {
-				g_pLua->PushUserData(pMeta, pStatement);
-				g_pLua->Push((float)retcode);
-				SAFE_UNREF(pMeta);
-				return 2;
-			}
-
-			SAFE_UNREF(pMeta);
-
-		}
-
-	}
-
-	if( pStatement ) delete pStatement;
-
-	g_pLua->PushNil();
-	return 1;
-
-}
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "LuaDatabase.h"
+#include "database.h"
+#include "statement.h"
+#include "blob.h"
+#include "backup.h"
+#include "int64.h"
+#include "checkpoint.h"
+#include "function.h"
+#include "spatial.h"
+#include "kvstore.h"
+#include "querycache.h"
+
+//-----------------------------------------------------------------------------
+// Database functions
+//-----------------------------------------------------------------------------
+
+static int DatabaseExecCallback(void* usrPtr, int numColumns, char** values, char** columns)
+{
+
+	ASSERT(usrPtr != NULL);
+	if( !usrPtr ) return SQLITE_ABORT; // THIS SHOULD NOT BE HAPPENING AAAAAHHHH!!!
+
+	ILuaObject* pColumns = g_pLua->GetNewTable();
+
+	ASSERT(pColumns != NULL);
+	if( !pColumns ) { return SQLITE_ABORT; }
+
+	ILuaObject* pValues = g_pLua->GetNewTable();
+	
+	ASSERT(pValues != NULL);
+	if( !pValues ) { SAFE_UNREF(pColumns); return SQLITE_ABORT; }
+
+	for( int i = 0; i < numColumns; i++ ) {
+		pColumns->SetMember((float)i, columns[i]);
+		pValues->SetMember((float)i, values[i]);
+	}
+
+	((ILuaObject*)usrPtr)->Push();
+	g_pLua->Push((float)numColumns);
+	pColumns->Push();
+	pValues->Push();
+	g_pLua->Call(3, 1);
+
+	SAFE_UNREF(pColumns);
+	SAFE_UNREF(pValues);
+
+	return (int)(g_pLua->GetInteger(1));
+
+}
+
+// A leading question mark is replaced with the base folder
+static bool ResolveDatabasePath(const char* pszDbName, char* pszNewDbName)
+{
+
+	int length = strlen(pszDbName);
+	if(  length < 1 || ( length == 1 && pszDbName[0] == '?' ) ) {
+		return false;
+	}
+
+	// For security reasons, don't allow clients to create databases outside memory or game folder just in case they download a malicious script
+	if( g_pLua->IsClient() ) { 
+		if( pszDbName[0] != '?' && stricmp(pszDbName,":memory:") != 0 ) {
+			sprintf(pszNewDbName, "%s%s", modulemanager->GetBaseFolder(), &pszDbName[1]);
+		} else {
+			sprintf(pszNewDbName, "%s", pszDbName);
+		}
+	} else {
+		if( pszDbName[0] == '?' ) {
+			sprintf(pszNewDbName, "%s%s", modulemanager->GetBaseFolder(), &pszDbName[1]);
+		} else {
+			sprintf(pszNewDbName, "%s", pszDbName);
+		}
+	}
+
+	return true;
+
+}
+
+LUA_FUNCTION(DatabaseNew)
+{
+
+	CDatabase* pDatabase = new CDatabase();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		ILuaObject* pMeta = g_pLua->GetMetaTable(META_DATABASE, TYPE_DATABASE);
+
+		ASSERT(pMeta != NULL);
+		if( pMeta ) {
+			g_pLua->PushUserData(pMeta, pDatabase);
+			SAFE_UNREF(pMeta);
+			return 1;
+		}
+
+		SAFE_UNREF(pMeta);
+
+	}
+
+	if( pDatabase ) delete pDatabase;
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabaseDelete)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		delete pDatabase;
+		pDatabase = NULL;
+	}
+
+	return 0;
+
+}
+
+
+// Reads either a preset name or an options table, a preset given in the table is applied before its other members
+static bool ReadDatabaseOptions(int stackPos, DatabaseOptions* pOptions, int* flags)
+{
+
+	if( g_pLua->GetType(stackPos) == GLua::TYPE_STRING ) {
+		return pOptions->setPreset(g_pLua->GetString(stackPos), flags);
+	}
+
+	ILuaObject* pTable = g_pLua->GetObject(stackPos);
+	if( !pTable ) return false;
+
+	bool valid = true;
+
+	const char* pszPreset = pTable->GetMemberStr("preset", NULL);
+	if( pszPreset && !pOptions->setPreset(pszPreset, flags) ) {
+		valid = false;
+	}
+
+	*flags = pTable->GetMemberInt("flags", *flags);
+
+	pOptions->pszJournal = pTable->GetMemberStr("journal", pOptions->pszJournal);
+	pOptions->pszSynchronous = pTable->GetMemberStr("synchronous", pOptions->pszSynchronous);
+	pOptions->pszTempStore = pTable->GetMemberStr("temp_store", pOptions->pszTempStore);
+	pOptions->iCacheMB = pTable->GetMemberInt("cache_mb", pOptions->iCacheMB);
+	pOptions->iMmapMB = pTable->GetMemberInt("mmap_mb", pOptions->iMmapMB);
+	pOptions->iBusyTimeout = pTable->GetMemberInt("busy_timeout", pOptions->iBusyTimeout);
+	pOptions->bBusyBackoff = pTable->GetMemberBool("busy_backoff", pOptions->bBusyBackoff);
+	pOptions->bBatch = pTable->GetMemberBool("batch", pOptions->bBatch);
+	pOptions->iMemoryLimitMB = pTable->GetMemberInt("memory_limit_mb", pOptions->iMemoryLimitMB);
+
+	pOptions->bImmutable = pTable->GetMemberBool("immutable", pOptions->bImmutable);
+	pOptions->bNoLock = pTable->GetMemberBool("nolock", pOptions->bNoLock);
+
+	pOptions->bMemory = pTable->GetMemberBool("memory", pOptions->bMemory);
+	pOptions->dSnapshotInterval = pTable->GetMemberFloat("snapshot_interval", (float)pOptions->dSnapshotInterval);
+
+	SAFE_UNREF(pTable);
+	return valid;
+
+}
+
+// db:Open(name, flags)
+// db:Open(name, flags, options)
+// db:Open(name, options)
+//
+// options is either a preset name ("throughput", "durable", "readonly", "shared") or a table with any of
+//   preset, flags, journal, synchronous, temp_store, cache_mb, mmap_mb, busy_timeout, busy_backoff, batch, memory_limit_mb,
+//   immutable, nolock, memory, snapshot_interval
+//
+// memory serves everything from a :memory: copy of the file, which is written back every
+// snapshot_interval seconds and on close. Names starting with file: are opened as URIs on the server.
+LUA_FUNCTION(DatabaseOpen)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+
+	int optionsPos = 4;
+
+	if( g_pLua->GetType(3) != GLua::TYPE_NUMBER ) {
+		if( g_pLua->GetType(3) != GLua::TYPE_TABLE && g_pLua->GetType(3) != GLua::TYPE_STRING ) {
+			g_pLua->CheckType(3, GLua::TYPE_NUMBER);
+		}
+		optionsPos = 3;
+	} else if( g_pLua->GetType(4) != GLua::TYPE_NIL && g_pLua->GetType(4) != GLua::TYPE_STRING ) {
+		g_pLua->CheckType(4, GLua::TYPE_TABLE);
+	}
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		int flags = ( optionsPos == 4 ) ? g_pLua->GetInteger(3) : ( SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE );
+		char pszNewDbName[MAX_PATH];
+
+		const char* pszDbName = g_pLua->GetString(2);
+
+		if( !ResolveDatabasePath(pszDbName, pszNewDbName) ) {
+			g_pLua->PushNil();
+			return 1;
+		}
+
+		if( !g_pLua->IsClient() && strnicmp(pszDbName, "file:", 5) == 0 ) {
+			flags |= SQLITE_OPEN_URI;
+		}
+
+		if( g_pLua->GetType(optionsPos) == GLua::TYPE_NIL ) {
+			g_pLua->Push((float)pDatabase->open(pszNewDbName, flags, NULL));
+			return 1;
+		}
+
+		DatabaseOptions options;
+
+		if( !ReadDatabaseOptions(optionsPos, &options, &flags) ) {
+			g_pLua->Push((float)SQLITE_MISUSE);
+			return 1;
+		}
+
+		g_pLua->Push((float)pDatabase->open(pszNewDbName, flags, options));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabaseClose)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->close());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(DatabaseIsOpen)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((bool)pDatabase->isOpen());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(DatabaseExtendedErrors)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_BOOL);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->setExtendedErrors(g_pLua->GetBool(2)));
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(DatabaseLastError)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->getErrorCode());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabaseLastErrorMessage)
+{
+	
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((const char*)pDatabase->getErrorMessage());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(DatabaseLastInsertId)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->getLastInsertId());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(DatabaseLastInsertId64)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		LuaPushInt64(pDatabase->getLastInsertId());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(DatabaseChanges)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->getChanges());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabaseTotalChanges)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->getTotalChanges());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(DatabaseExecute)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+
+	ILuaObject* pCallback = NULL;
+
+	if( g_pLua->GetType(3) == GLua::TYPE_FUNCTION ) {
+		pCallback = g_pLua->GetObject(3);
+	} else if( g_pLua->GetType(3) == GLua::TYPE_NIL ) {
+	} else {
+		g_pLua->CheckType(3, GLua::TYPE_FUNCTION);
+	}
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		int retcode = SQLITE_ERROR;
+		if( pCallback != NULL ) {
+			retcode = pDatabase->execute(g_pLua->GetString(2), DatabaseExecCallback, (void*)pCallback);
+		} else {
+			retcode = pDatabase->execute(g_pLua->GetString(2));
+		}
+		g_pLua->Push((float)retcode);
+		SAFE_UNREF(pCallback);
+		return 1;
+	}
+
+	SAFE_UNREF(pCallback);
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabasePrepare)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+
+	CStatement* pStatement = NULL;
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		int retcode = pDatabase->prepare(&pStatement, g_pLua->GetString(2));
+
+		ASSERT(pStatement != NULL);
+		if( pStatement ) {
+
+			ILuaObject* pMeta = g_pLua->GetMetaTable(META_STATEMENT, TYPE_STATEMENT);
+
+			ASSERT(pMeta != NULL);
+			if( pMeta ) {
+				g_pLua->PushUserData(pMeta, pStatement);
+				g_pLua->Push((float)retcode);
+				SAFE_UNREF(pMeta);
+				return 2;
+			}
+
+			SAFE_UNREF(pMeta);
+
+		}
+
+	}
+
+	if( pStatement ) delete pStatement;
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+// db:OpenBlob(table, column, rowid, writable, dbname) streams a single value without loading it all into memory
+LUA_FUNCTION(DatabaseOpenBlob)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+	g_pLua->CheckType(3, GLua::TYPE_STRING);
+	if( g_pLua->GetType(4) != GLua::TYPE_STRING && g_pLua->GetType(4) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(4, GLua::TYPE_STRING);
+		g_pLua->CheckType(4, GLua::TYPE_NUMBER);
+	}
+
+	CBlob* pBlob = NULL;
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		sqlite3_int64 rowid = 0;
+		if( !LuaGetInt64(4, &rowid) ) {
+			g_pLua->PushNil();
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 2;
+		}
+
+		bool writable = ( g_pLua->GetType(5) == GLua::TYPE_BOOL && g_pLua->GetBool(5) );
+		const char* pszDbName = ( g_pLua->GetType(6) == GLua::TYPE_STRING ) ? g_pLua->GetString(6) : "main";
+
+		int retcode = pDatabase->openBlob(&pBlob, g_pLua->GetString(2), g_pLua->GetString(3), rowid, writable, pszDbName);
+
+		if( pBlob ) {
+
+			ILuaObject* pMeta = g_pLua->GetMetaTable(META_BLOB, TYPE_BLOB);
+
+			ASSERT(pMeta != NULL);
+			if( pMeta ) {
+				g_pLua->PushUserData(pMeta, pBlob);
+				g_pLua->Push((float)retcode);
+				SAFE_UNREF(pMeta);
+				return 2;
+			}
+
+			SAFE_UNREF(pMeta);
+
+		} else {
+
+			g_pLua->PushNil();
+			g_pLua->Push((float)retcode);
+			return 2;
+
+		}
+
+	}
+
+	if( pBlob ) delete pBlob;
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+// db:BackupTo(pathOrDb, pagesPerStep, threaded) copies the database while it stays usable.
+// Call Step on the returned object every tick until it returns SQLITE_DONE, or pass threaded
+// to have a background thread do the stepping.
+LUA_FUNCTION(DatabaseBackupTo)
+{
+
+	DATABASE_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != TYPE_DATABASE ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+	}
+
+	CBackup* pBackup = NULL;
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		int pagesPerStep = ( g_pLua->GetType(3) == GLua::TYPE_NUMBER ) ? g_pLua->GetInteger(3) : 100;
+		int retcode = SQLITE_ERROR;
+
+		if( g_pLua->GetType(2) == TYPE_DATABASE ) {
+
+			retcode = pDatabase->backupTo(&pBackup, (CDatabase*)g_pLua->GetUserData(2), pagesPerStep);
+
+		} else {
+
+			char pszFileName[MAX_PATH];
+
+			if( !ResolveDatabasePath(g_pLua->GetString(2), pszFileName) ) {
+				g_pLua->PushNil();
+				g_pLua->Push((float)SQLITE_CANTOPEN);
+				return 2;
+			}
+
+			retcode = pDatabase->backupTo(&pBackup, pszFileName, pagesPerStep);
+
+		}
+
+		if( pBackup && g_pLua->GetType(4) == GLua::TYPE_BOOL && g_pLua->GetBool(4) ) {
+			retcode = pBackup->startThread(1);
+		}
+
+		if( pBackup && retcode == SQLITE_OK ) {
+
+			ILuaObject* pMeta = g_pLua->GetMetaTable(META_BACKUP, TYPE_BACKUP);
+
+			ASSERT(pMeta != NULL);
+			if( pMeta ) {
+				g_pLua->PushUserData(pMeta, pBackup);
+				g_pLua->Push((float)retcode);
+				SAFE_UNREF(pMeta);
+				return 2;
+			}
+
+			SAFE_UNREF(pMeta);
+
+		} else {
+
+			if( pBackup ) delete pBackup;
+
+			g_pLua->PushNil();
+			g_pLua->Push((float)retcode);
+			return 2;
+
+		}
+
+	}
+
+	if( pBackup ) delete pBackup;
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+// Writes an in-memory database back to its file right away
+LUA_FUNCTION(DatabaseSnapshot)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->snapshot());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabaseSnapshotStats)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase && pDatabase->isInMemory() ) {
+
+		ILuaObject* pStats = g_pLua->GetNewTable();
+
+		ASSERT(pStats != NULL);
+		if( pStats ) {
+
+			pStats->SetMember("lag", (float)pDatabase->getSnapshotLag());
+			pStats->SetMember("changes", (float)pDatabase->getSnapshotChanges());
+			pStats->SetMember("dirty", (bool)pDatabase->isSnapshotDirty());
+			pStats->SetMember("duration", (float)pDatabase->getSnapshotDuration());
+			pStats->SetMember("count", (float)pDatabase->getNumSnapshots());
+			pStats->SetMember("failures", (float)pDatabase->getNumSnapshotFailures());
+			pStats->SetMember("result", (float)pDatabase->getSnapshotResult());
+			pStats->SetMember("active", (bool)pDatabase->isSnapshotting());
+
+			g_pLua->Push(pStats);
+			SAFE_UNREF(pStats);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+// Reports what the connection actually ended up with, journal_mode in particular can silently fall back
+LUA_FUNCTION(DatabaseSettings)
+{
+
+	DATABASE_FROM_LUA();
+
+	static const char* pszPragmas[] = {
+		"journal_mode", "synchronous", "temp_store", "cache_size", "mmap_size", "page_size", "busy_timeout", "wal_autocheckpoint", NULL
+	};
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase && pDatabase->isOpen() ) {
+
+		ILuaObject* pSettings = g_pLua->GetNewTable();
+
+		ASSERT(pSettings != NULL);
+		if( pSettings ) {
+
+			char sql[64];
+
+			for( int i = 0; pszPragmas[i]; i++ ) {
+
+				CStatement* pStatement = NULL;
+				sqlite3_snprintf(sizeof(sql), sql, "PRAGMA %s;", pszPragmas[i]);
+
+				if( pDatabase->prepare(&pStatement, sql) == SQLITE_OK && pStatement ) {
+					if( pStatement->step() == SQLITE_ROW ) {
+						if( pStatement->getColumnType(0) == SQLITE_TEXT ) {
+							pSettings->SetMember(pszPragmas[i], pStatement->getText(0));
+						} else {
+							pSettings->SetMember(pszPragmas[i], (float)pStatement->getInt64(0));
+						}
+					}
+					pStatement->finalize();
+				}
+
+				if( pStatement ) delete pStatement;
+
+			}
+
+			g_pLua->Push(pSettings);
+			SAFE_UNREF(pSettings);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+// db:Status(reset) wraps sqlite3_db_status, the *_peak members are the highwater marks
+LUA_FUNCTION(DatabaseStatus)
+{
+
+	DATABASE_FROM_LUA();
+
+	static const struct { int op; const char* pszName; const char* pszPeakName; } s_Counters[] = {
+		{ SQLITE_DBSTATUS_LOOKASIDE_USED,		"lookaside_used",		"lookaside_used_peak" },
+		{ SQLITE_DBSTATUS_LOOKASIDE_HIT,		NULL,					"lookaside_hit" },
+		{ SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE,	NULL,					"lookaside_miss_size" },
+		{ SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL,	NULL,					"lookaside_miss_full" },
+		{ SQLITE_DBSTATUS_CACHE_USED,			"cache_used",			NULL },
+		{ SQLITE_DBSTATUS_SCHEMA_USED,			"schema_used",			NULL },
+		{ SQLITE_DBSTATUS_STMT_USED,			"stmt_used",			NULL },
+		{ SQLITE_DBSTATUS_CACHE_HIT,			"cache_hit",			NULL },
+		{ SQLITE_DBSTATUS_CACHE_MISS,			"cache_miss",			NULL },
+		{ SQLITE_DBSTATUS_CACHE_WRITE,			"cache_write",			NULL },
+		{ SQLITE_DBSTATUS_CACHE_SPILL,			"cache_spill",			NULL },
+		{ SQLITE_DBSTATUS_DEFERRED_FKS,			"deferred_fks",			NULL },
+	};
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase && pDatabase->isOpen() ) {
+
+		bool reset = ( g_pLua->GetType(2) == GLua::TYPE_BOOL && g_pLua->GetBool(2) );
+
+		ILuaObject* pStatus = g_pLua->GetNewTable();
+
+		ASSERT(pStatus != NULL);
+		if( pStatus ) {
+
+			for( int i = 0; i < (int)( sizeof(s_Counters) / sizeof(s_Counters[0]) ); i++ ) {
+
+				int current = 0;
+				int highwater = 0;
+
+				if( pDatabase->getStatus(s_Counters[i].op, &current, &highwater, reset) != SQLITE_OK ) continue;
+
+				if( s_Counters[i].pszName ) pStatus->SetMember(s_Counters[i].pszName, (float)current);
+				if( s_Counters[i].pszPeakName ) pStatus->SetMember(s_Counters[i].pszPeakName, (float)highwater);
+
+			}
+
+			g_pLua->Push(pStatus);
+			SAFE_UNREF(pStatus);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:ReleaseMemory() returns the bytes freed from the page cache and the return code
+LUA_FUNCTION(DatabaseReleaseMemory)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		int reclaimed = 0;
+		int retcode = pDatabase->releaseMemory(&reclaimed);
+
+		g_pLua->Push((float)reclaimed);
+		g_pLua->Push((float)retcode);
+		return 2;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:SetMemoryLimit(bytes) releases cache memory on think, at most once a second, while sqlite3_memory_used is above bytes.
+// 0 turns it off. MemoryStats().evictions counts the automatic releases that actually freed something
+LUA_FUNCTION(DatabaseSetMemoryLimit)
+{
+
+	DATABASE_FROM_LUA();
+
+	sqlite3_int64 bytes = LuaCheckInt64(2);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		pDatabase->setMemoryLimit(bytes);
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabaseMemoryStats)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		ILuaObject* pStats = g_pLua->GetNewTable();
+
+		ASSERT(pStats != NULL);
+		if( pStats ) {
+
+			pStats->SetMember("limit", (float)pDatabase->getMemoryLimit());
+			pStats->SetMember("reclaimed", (float)pDatabase->getBytesReclaimed());
+			pStats->SetMember("evictions", (float)pDatabase->getNumEvictions());
+			pStats->SetMember("releases", (float)pDatabase->getNumReleases());
+
+			g_pLua->Push(pStats);
+			SAFE_UNREF(pStats);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:LiveStatements() returns { count, leaked, closed, statements = { { sql, age }, ... } }, age is in seconds
+LUA_FUNCTION(DatabaseLiveStatements)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		ILuaObject* pResult = g_pLua->GetNewTable();
+		ILuaObject* pList = g_pLua->GetNewTable();
+
+		ASSERT(pResult != NULL && pList != NULL);
+		if( pResult && pList ) {
+
+			int index = 1;
+
+			for( CStatement* pStatement = pDatabase->getFirstStatement(); pStatement; pStatement = pDatabase->getNextStatement(pStatement) ) {
+
+				ILuaObject* pEntry = g_pLua->GetNewTable();
+
+				if( pEntry ) {
+					pEntry->SetMember("sql", pStatement->getSql());
+					pEntry->SetMember("age", (float)pStatement->getAge());
+					pList->SetMember((float)index++, pEntry);
+					SAFE_UNREF(pEntry);
+				}
+
+			}
+
+			pResult->SetMember("count", (float)pDatabase->getNumStatements());
+			pResult->SetMember("leaked", (float)pDatabase->getNumLeakedStatements());
+			pResult->SetMember("closed", (float)pDatabase->getNumClosedStatements());
+			pResult->SetMember("statements", pList);
+
+			g_pLua->Push(pResult);
+			SAFE_UNREF(pList);
+			SAFE_UNREF(pResult);
+			return 1;
+
+		}
+
+		SAFE_UNREF(pList);
+		SAFE_UNREF(pResult);
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:StartCheckpointer(intervalMs = 1000, idleMs = 5000), the database has to be in WAL mode
+LUA_FUNCTION(DatabaseStartCheckpointer)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		int intervalMs = ( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) ? g_pLua->GetInteger(2) : 1000;
+		int idleMs = ( g_pLua->GetType(3) == GLua::TYPE_NUMBER ) ? g_pLua->GetInteger(3) : 5000;
+
+		g_pLua->Push((float)pDatabase->startCheckpointer(intervalMs, idleMs));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabaseStopCheckpointer)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		pDatabase->stopCheckpointer();
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// Durations are in milliseconds, wal_size is in bytes
+LUA_FUNCTION(DatabaseCheckpointStats)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		CCheckpointer* pCheckpointer = pDatabase->getCheckpointer();
+
+		ILuaObject* pStats = g_pLua->GetNewTable();
+
+		ASSERT(pStats != NULL);
+		if( pStats ) {
+
+			pStats->SetMember("active", pCheckpointer != NULL);
+
+			if( pCheckpointer ) {
+				pStats->SetMember("wal_frames", (float)pCheckpointer->getWalFrames());
+				pStats->SetMember("wal_size", (float)pCheckpointer->getWalSize());
+				pStats->SetMember("frames_behind", (float)pCheckpointer->getFramesBehind());
+				pStats->SetMember("duration", (float)pCheckpointer->getLastDuration());
+				pStats->SetMember("max_duration", (float)pCheckpointer->getMaxDuration());
+				pStats->SetMember("count", (float)pCheckpointer->getNumCheckpoints());
+				pStats->SetMember("truncates", (float)pCheckpointer->getNumTruncates());
+				pStats->SetMember("result", (float)pCheckpointer->getLastResult());
+			}
+
+			g_pLua->Push(pStats);
+			SAFE_UNREF(pStats);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:SetResultCache(maxBytes, maxAgeSeconds = 0) caches the rows of read-only statements prepared from here on,
+// writes through this database invalidate them, 0 bytes turns it off again. While it is on the cache owns the
+// connection's authorizer.
+LUA_FUNCTION(DatabaseSetResultCache)
+{
+
+	DATABASE_FROM_LUA();
+
+	sqlite3_int64 bytes = LuaCheckInt64(2);
+
+	double maxAge = ( g_pLua->GetType(3) == GLua::TYPE_NUMBER ) ? g_pLua->GetNumber(3) : 0.0;
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->setResultCache(bytes, maxAge * 1000.0));
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(DatabaseFlushResultCache)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		CQueryCache* pCache = pDatabase->getResultCache();
+		if( pCache ) pCache->invalidate("*");
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:ResultCacheStats(reset), bytes is an estimate of what the cached rows take up
+LUA_FUNCTION(DatabaseResultCacheStats)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		CQueryCache* pCache = pDatabase->getResultCache();
+
+		ILuaObject* pStats = g_pLua->GetNewTable();
+
+		ASSERT(pStats != NULL);
+		if( pStats ) {
+
+			pStats->SetMember("active", pCache != NULL);
+
+			if( pCache ) {
+
+				sqlite3_int64 lookups = pCache->getNumHits() + pCache->getNumMisses();
+
+				pStats->SetMember("entries", (float)pCache->getNumEntries());
+				pStats->SetMember("bytes", (float)pCache->getBytes());
+				pStats->SetMember("max_bytes", (float)pCache->getMaxBytes());
+				pStats->SetMember("hits", (float)pCache->getNumHits());
+				pStats->SetMember("misses", (float)pCache->getNumMisses());
+				pStats->SetMember("hit_rate", lookups ? (float)pCache->getNumHits() / (float)lookups : 0.0f);
+				pStats->SetMember("stores", (float)pCache->getNumStores());
+				pStats->SetMember("invalidations", (float)pCache->getNumInvalidations());
+				pStats->SetMember("evictions", (float)pCache->getNumEvictions());
+				pStats->SetMember("bypasses", (float)pCache->getNumBypasses());
+
+				if( g_pLua->GetBool(2) ) pCache->resetStats();
+
+			}
+
+			g_pLua->Push(pStats);
+			SAFE_UNREF(pStats);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+static void DeferredFinished(void* usrPtr, int retcode, double latency)
+{
+
+	ILuaObject* pCallback = (ILuaObject*)usrPtr;
+	if( !pCallback ) return;
+
+	pCallback->Push();
+	g_pLua->Push((float)retcode);
+	g_pLua->Push((float)latency);
+	g_pLua->Call(2, 0);
+
+	SAFE_UNREF(pCallback);
+
+}
+
+// db:ExecuteDeferred(sql, callback) runs sql without waiting on locks, if the database is busy it is retried from
+// the Think hook until it goes through. Returns SQLITE_BUSY when it was queued, callback(retcode, latencyMs) fires either way.
+// Each attempt is all or nothing, so sql may hold several statements but no BEGIN, COMMIT or SAVEPOINT of its own.
+LUA_FUNCTION(DatabaseExecuteDeferred)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+
+	if( g_pLua->GetType(3) != GLua::TYPE_NIL ) {
+		g_pLua->CheckType(3, GLua::TYPE_FUNCTION);
+	}
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase && pDatabase->isOpen() ) {
+
+		ILuaObject* pCallback = ( g_pLua->GetType(3) == GLua::TYPE_FUNCTION ) ? g_pLua->GetObject(3) : NULL;
+
+		g_pLua->Push((float)pDatabase->executeDeferred(g_pLua->GetString(2), DeferredFinished, pCallback));
+
+		// Keeps the database alive until the queue is empty, so its callbacks never have to run from __gc
+		pDatabase->holdQueue(g_pLua->GetObject(1));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:SetDeferredTimeout(ms) is how long a queued write is retried before its callback gets SQLITE_BUSY
+LUA_FUNCTION(DatabaseSetDeferredTimeout)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		pDatabase->setDeferredTimeout(g_pLua->GetNumber(2));
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// Latencies are in milliseconds and only cover writes that had to wait
+LUA_FUNCTION(DatabaseDeferredStats)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		ILuaObject* pStats = g_pLua->GetNewTable();
+
+		ASSERT(pStats != NULL);
+		if( pStats ) {
+
+			pStats->SetMember("queued", (float)pDatabase->getNumQueued());
+			pStats->SetMember("busy", (float)pDatabase->getNumBusy());
+			pStats->SetMember("deferred", (float)pDatabase->getNumDeferred());
+			pStats->SetMember("retried", (float)pDatabase->getNumRetried());
+			pStats->SetMember("abandoned", (float)pDatabase->getNumAbandoned());
+			pStats->SetMember("latency", (float)pDatabase->getRetryLatencyAverage());
+			pStats->SetMember("max_latency", (float)pDatabase->getRetryLatencyMax());
+
+			g_pLua->Push(pStats);
+			SAFE_UNREF(pStats);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:SetBusyBackoff(on) waits on locks with a jittered exponential backoff for up to the busy timeout, which has to be set first
+LUA_FUNCTION(DatabaseSetBusyBackoff)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_BOOL);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		g_pLua->Push((float)pDatabase->setBusyBackoff(g_pLua->GetBool(2)));
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:SetBatching(on) commits everything ExecuteDeferred queued during a tick in a single BEGIN IMMEDIATE transaction
+LUA_FUNCTION(DatabaseSetBatching)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_BOOL);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+		pDatabase->setBatching(g_pLua->GetBool(2));
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// Lock waits are in milliseconds and only counted while the backoff busy handler is on
+LUA_FUNCTION(DatabaseContentionStats)
+{
+
+	DATABASE_FROM_LUA();
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		ILuaObject* pStats = g_pLua->GetNewTable();
+
+		ASSERT(pStats != NULL);
+		if( pStats ) {
+
+			pStats->SetMember("busy_waits", (float)pDatabase->getNumBusyWaits());
+			pStats->SetMember("lock_timeouts", (float)pDatabase->getNumLockTimeouts());
+			pStats->SetMember("lock_wait", (float)pDatabase->getLockWaitTotal());
+			pStats->SetMember("max_lock_wait", (float)pDatabase->getLockWaitMax());
+			pStats->SetMember("busy", (float)pDatabase->getNumBusy());
+			pStats->SetMember("batches", (float)pDatabase->getNumBatches());
+			pStats->SetMember("batched", (float)pDatabase->getNumBatched());
+
+			g_pLua->Push(pStats);
+			SAFE_UNREF(pStats);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+static int ReadFunctionFlags(int stackPos)
+{
+
+	int flags = 0;
+
+	if( g_pLua->GetType(stackPos) == GLua::TYPE_TABLE ) {
+
+		ILuaObject* pOptions = g_pLua->GetObject(stackPos);
+
+		if( pOptions ) {
+			if( pOptions->GetMemberBool("deterministic", false) ) flags |= SQLITE_DETERMINISTIC;
+			SAFE_UNREF(pOptions);
+		}
+
+	}
+
+	return flags;
+
+}
+
+// db:CreateFunction(name, nargs, fn, options) makes fn(...) callable from SQL, nargs of -1 takes any number of arguments.
+// options may set deterministic = true, which lets SQLite factor calls out and use the function in indexes.
+// INTEGER arguments beyond 2^24 arrive as decimal strings so they stay exact, see LuaPushInteger.
+LUA_FUNCTION(DatabaseCreateFunction)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+	g_pLua->CheckType(3, GLua::TYPE_NUMBER);
+	g_pLua->CheckType(4, GLua::TYPE_FUNCTION);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase && pDatabase->isOpen() ) {
+
+		CFunction* pFunction = new CFunction(g_pLua->GetObject(4));
+
+		g_pLua->Push((float)pDatabase->createFunction(g_pLua->GetString(2), g_pLua->GetInteger(3), ReadFunctionFlags(5), pFunction));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:CreateAggregate(name, step, final, options) calls step(state, ...) for every row and returns final(state) for each group.
+// state starts out as nil and is replaced by whatever step returns, without final the last state is the result.
+// options takes deterministic like CreateFunction and nargs, which defaults to -1.
+LUA_FUNCTION(DatabaseCreateAggregate)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+	g_pLua->CheckType(3, GLua::TYPE_FUNCTION);
+
+	if( g_pLua->GetType(4) != GLua::TYPE_NIL ) {
+		g_pLua->CheckType(4, GLua::TYPE_FUNCTION);
+	}
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase && pDatabase->isOpen() ) {
+
+		int numArgs = -1;
+
+		if( g_pLua->GetType(5) == GLua::TYPE_TABLE ) {
+			ILuaObject* pOptions = g_pLua->GetObject(5);
+			if( pOptions ) {
+				numArgs = pOptions->GetMemberInt("nargs", -1);
+				SAFE_UNREF(pOptions);
+			}
+		}
+
+		ILuaObject* pFinal = ( g_pLua->GetType(4) == GLua::TYPE_FUNCTION ) ? g_pLua->GetObject(4) : NULL;
+		CFunction* pFunction = new CFunction(g_pLua->GetObject(3), pFinal);
+
+		g_pLua->Push((float)pDatabase->createFunction(g_pLua->GetString(2), numArgs, ReadFunctionFlags(5), pFunction));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:CreateSpatialIndex(name, dimensions = 3) opens the R*Tree table name, creating it if needed.
+// Returns the index object and the return code, SQLite has to be built with R*Tree for this to work.
+LUA_FUNCTION(DatabaseCreateSpatialIndex)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		int dimensions = ( g_pLua->GetType(3) == GLua::TYPE_NUMBER ) ? g_pLua->GetInteger(3) : 3;
+
+		CSpatialIndex* pIndex = NULL;
+		int retcode = CSpatialIndex::create(&pIndex, pDatabase, g_pLua->GetString(2), dimensions);
+
+		if( pIndex ) {
+
+			ILuaObject* pMeta = g_pLua->GetMetaTable(META_SPATIAL, TYPE_SPATIAL);
+
+			ASSERT(pMeta != NULL);
+			if( pMeta ) {
+				g_pLua->PushUserData(pMeta, pIndex);
+				g_pLua->Push((float)retcode);
+				SAFE_UNREF(pMeta);
+				return 2;
+			}
+
+			SAFE_UNREF(pMeta);
+			delete pIndex;
+
+		} else {
+
+			g_pLua->PushNil();
+			g_pLua->Push((float)retcode);
+			return 2;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:KV(name) returns a key-value store on the table name, creating it if needed, and the return code
+LUA_FUNCTION(DatabaseKV)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		CKVStore* pStore = NULL;
+		int retcode = CKVStore::create(&pStore, pDatabase, g_pLua->GetString(2));
+
+		if( pStore ) {
+
+			ILuaObject* pMeta = g_pLua->GetMetaTable(META_KVSTORE, TYPE_KVSTORE);
+
+			ASSERT(pMeta != NULL);
+			if( pMeta ) {
+				g_pLua->PushUserData(pMeta, pStore);
+				g_pLua->Push((float)retcode);
+				SAFE_UNREF(pMeta);
+				return 2;
+			}
+
+			SAFE_UNREF(pMeta);
+			delete pStore;
+
+		} else {
+
+			g_pLua->PushNil();
+			g_pLua->Push((float)retcode);
+			return 2;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:CreateTextIndex(name, columns, tokenizer) creates an FTS5 table with the given array of column names,
+// of which there may be up to 64. Returns SQLITE_RANGE for more.
+LUA_FUNCTION(DatabaseCreateTextIndex)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+	g_pLua->CheckType(3, GLua::TYPE_TABLE);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		const char* pszColumns[64];
+		ILuaObject* pColumnObjects[64];
+		int numColumns = 0;
+
+		ILuaObject* pColumns = g_pLua->GetObject(3);
+
+		while( pColumns && numColumns < 64 ) {
+
+			ILuaObject* pColumn = pColumns->GetMember((float)(numColumns + 1));
+
+			if( !pColumn || !pColumn->isString() ) {
+				SAFE_UNREF(pColumn);
+				break;
+			}
+
+			// Held on to so the strings stay valid until the table is created
+			pColumnObjects[numColumns] = pColumn;
+			pszColumns[numColumns] = pColumn->GetString();
+			numColumns++;
+
+		}
+
+		const char* pszTokenizer = ( g_pLua->GetType(4) == GLua::TYPE_STRING ) ? g_pLua->GetString(4) : NULL;
+
+		// Creating the table without the columns that didn't fit would leave it short of them for good
+		ILuaObject* pExtra = ( pColumns && numColumns == 64 ) ? pColumns->GetMember((float)65) : NULL;
+		bool tooMany = ( pExtra && pExtra->GetType() != GLua::TYPE_NIL );
+		SAFE_UNREF(pExtra);
+
+		if( tooMany ) {
+			g_pLua->Push((float)SQLITE_RANGE);
+		} else {
+			g_pLua->Push((float)pDatabase->createTextIndex(g_pLua->GetString(2), pszColumns, numColumns, pszTokenizer));
+		}
+
+		for( int i = 0; i < numColumns; i++ ) {
+			SAFE_UNREF(pColumnObjects[i]);
+		}
+		SAFE_UNREF(pColumns);
+
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// db:Search(name, query, limit = 20, options) runs an FTS5 MATCH query and returns the rows best match first and the return code.
+// Every row is { rowid, score, snippet, columns = { name = value } } with rowid as a decimal string like LastInsertId64,
+// options may set open, close, ellipsis and tokens for the snippet.
+LUA_FUNCTION(DatabaseSearch)
+{
+
+	DATABASE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+	g_pLua->CheckType(3, GLua::TYPE_STRING);
+
+	ASSERT(pDatabase != NULL);
+	if( pDatabase ) {
+
+		int limit = ( g_pLua->GetType(4) == GLua::TYPE_NUMBER ) ? g_pLua->GetInteger(4) : 20;
+
+		ILuaObject* pOptions = ( g_pLua->GetType(5) == GLua::TYPE_TABLE ) ? g_pLua->GetObject(5) : NULL;
+
+		CStatement* pStatement = NULL;
+		int retcode = SQLITE_OK;
+
+		if( pOptions ) {
+			retcode = pDatabase->prepareSearch(&pStatement, g_pLua->GetString(2),
+				pOptions->GetMemberStr("open", "["), pOptions->GetMemberStr("close", "]"),
+				pOptions->GetMemberStr("ellipsis", "..."), pOptions->GetMemberInt("tokens", 10));
+		} else {
+			retcode = pDatabase->prepareSearch(&pStatement, g_pLua->GetString(2));
+		}
+
+		SAFE_UNREF(pOptions);
+
+		if( !pStatement ) {
+			g_pLua->PushNil();
+			g_pLua->Push((float)retcode);
+			return 2;
+		}
+
+		unsigned int queryLength = 0;
+		const char* pszQuery = g_pLua->GetString(3, &queryLength);
+
+		pStatement->bindText(1, pszQuery, (int)queryLength);
+		pStatement->bindInteger(2, limit);
+
+		ILuaObject* pRows = g_pLua->GetNewTable();
+
+		ASSERT(pRows != NULL);
+		if( pRows ) {
+
+			int numColumns = pStatement->getNumberOfColumns();
+			int count = 0;
+
+			while( ( retcode = pStatement->step() ) == SQLITE_ROW ) {
+
+				ILuaObject* pRow = g_pLua->GetNewTable();
+				ILuaObject* pValues = g_pLua->GetNewTable();
+
+				if( pRow && pValues ) {
+
+					LuaSetMemberInt64(pRow, "rowid", pStatement->getInt64(0));
+					pRow->SetMember("score", (float)pStatement->getDouble(1));
+					pRow->SetMember("snippet", pStatement->getText(2));
+
+					for( int i = 3; i < numColumns; i++ ) {
+						if( pStatement->getColumnType(i) != SQLITE_NULL ) {
+							pValues->SetMember(pStatement->getColumnName(i), pStatement->getText(i));
+						}
+					}
+
+					pRow->SetMember("columns", pValues);
+					pRows->SetMember((float)++count, pRow);
+
+				}
+
+				SAFE_UNREF(pValues);
+				SAFE_UNREF(pRow);
+
+			}
+
+			if( retcode == SQLITE_DONE ) retcode = SQLITE_OK;
+
+			// The database keeps the statement for the next search
+			pStatement->reset();
+
+			g_pLua->Push(pRows);
+			g_pLua->Push((float)retcode);
+			SAFE_UNREF(pRows);
+			return 2;
+
+		}
+
+		pStatement->reset();
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
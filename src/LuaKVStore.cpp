@@ -0,0 +1,445 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "LuaKVStore.h"
+#include "kvstore.h"
+#include "statement.h"
+#include "packed.h"
+#include "int64.h"
+#include <math.h>
+
+// Keys have to be strings or numbers, values may also be booleans (stored as 0 and 1) or tables (stored packed).
+// Table values are encoded into buffer, which has to outlive the bind.
+static bool ReadValue(ILuaObject* pObject, KVValue* value, PackBuffer* buffer, bool isKey)
+{
+
+	memset(value, 0, sizeof(*value));
+	value->iType = SQLITE_NULL;
+
+	switch( pObject ? pObject->GetType() : GLua::TYPE_NIL ) {
+	case GLua::TYPE_NUMBER:
+		{
+			double number = pObject->GetDouble();
+			if( number == floor(number) && number >= -9223372036854775808.0 && number < 9223372036854775808.0 ) {
+				value->iType = SQLITE_INTEGER;
+				value->iInteger = (sqlite3_int64)number;
+			} else {
+				value->iType = SQLITE_FLOAT;
+				value->dFloat = number;
+			}
+		}
+		return true;
+	case GLua::TYPE_STRING:
+		value->iType = SQLITE_TEXT;
+		value->pData = pObject->GetString();
+		value->iLength = (int)strlen(value->pData);
+		return true;
+	case GLua::TYPE_BOOL:
+		if( isKey ) return false;
+		value->iType = SQLITE_INTEGER;
+		value->iInteger = pObject->GetBool() ? 1 : 0;
+		return true;
+	case GLua::TYPE_TABLE:
+		if( isKey || !PackEncode(pObject, buffer) ) return false;
+		value->iType = SQLITE_BLOB;
+		value->pData = (const char*)buffer->pData;
+		value->iLength = buffer->iLength;
+		return true;
+	case GLua::TYPE_NIL:
+		return !isKey;
+	}
+
+	return false;
+
+}
+
+// Strings on the stack keep their length, so values with embedded zeros survive
+static bool ReadStackValue(int stackPos, KVValue* value, PackBuffer* buffer, bool isKey)
+{
+
+	if( g_pLua->GetType(stackPos) == GLua::TYPE_STRING ) {
+		unsigned int length = 0;
+		memset(value, 0, sizeof(*value));
+		value->iType = SQLITE_TEXT;
+		value->pData = g_pLua->GetString(stackPos, &length);
+		value->iLength = (int)length;
+		return true;
+	}
+
+	ILuaObject* pObject = g_pLua->GetObject(stackPos);
+	bool valid = ReadValue(pObject, value, buffer, isKey);
+	SAFE_UNREF(pObject);
+
+	return valid;
+
+}
+
+// Pushes column 0 as a plain Lua value, packed tables are decoded on the way. Integers are numbers while a float
+// holds them exactly and decimal strings beyond that, so large counters survive the trip.
+static void PushStoredValue(CStatement* pRow)
+{
+
+	int length = 0;
+	const void* pData = NULL;
+	ILuaObject* pTable = NULL;
+
+	switch( pRow->getColumnType(0) ) {
+	case SQLITE_INTEGER:
+		LuaPushInteger(pRow->getInt64(0));
+		break;
+	case SQLITE_FLOAT:
+		g_pLua->Push((float)pRow->getDouble(0));
+		break;
+	case SQLITE_TEXT:
+		// Read as bytes so the length comes along, text with embedded zeros is kept whole
+		pData = pRow->getBlob(0, &length);
+		g_pLua->Push(length ? (const char*)pData : "", (unsigned int)length);
+		break;
+	case SQLITE_BLOB:
+		pData = pRow->getBlob(0, &length);
+		pTable = PackDecode(pData, length);
+		if( pTable ) {
+			g_pLua->Push(pTable);
+			SAFE_UNREF(pTable);
+		} else {
+			g_pLua->Push((const char*)pData, (unsigned int)length);
+		}
+		break;
+	default:
+		g_pLua->PushNil();
+		break;
+	}
+
+}
+
+static void PushValueCallback(void* usrPtr, CStatement* row)
+{
+	PushStoredValue(row);
+	*(bool*)usrPtr = true;
+}
+
+struct KVManyResults
+{
+	ILuaObject* pTable;
+	ILuaObject* pKey;
+};
+
+static void CollectValueCallback(void* usrPtr, CStatement* row)
+{
+
+	KVManyResults* pResults = (KVManyResults*)usrPtr;
+
+	PushStoredValue(row);
+	ILuaObject* pValue = g_pLua->GetObject(g_pLua->Top());
+	g_pLua->Pop();
+
+	if( pValue ) {
+		pResults->pTable->SetMember(pResults->pKey, pValue);
+	}
+
+	SAFE_UNREF(pValue);
+
+}
+
+//-----------------------------------------------------------------------------
+// Key-value store functions
+//-----------------------------------------------------------------------------
+
+LUA_FUNCTION(KVStoreDelete)
+{
+
+	KVSTORE_FROM_LUA();
+
+	ASSERT(pStore != NULL);
+	if( pStore )
+	{
+		delete pStore;
+		pStore = NULL;
+	}
+
+	return 0;
+
+}
+
+
+// kv:Get(key) returns the value or nil, and the return code
+LUA_FUNCTION(KVStoreGet)
+{
+
+	KVSTORE_FROM_LUA();
+
+	ASSERT(pStore != NULL);
+	if( pStore )
+	{
+
+		KVValue key;
+
+		if( !ReadStackValue(2, &key, NULL, true) ) {
+			g_pLua->PushNil();
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 2;
+		}
+
+		bool found = false;
+		int retcode = pStore->get(key, PushValueCallback, &found);
+
+		if( !found ) g_pLua->PushNil();
+		g_pLua->Push((float)retcode);
+		return 2;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// kv:Set(key, value) replaces the value, setting nil deletes the key
+LUA_FUNCTION(KVStoreSet)
+{
+
+	KVSTORE_FROM_LUA();
+
+	ASSERT(pStore != NULL);
+	if( pStore )
+	{
+
+		KVValue key;
+		KVValue value;
+
+		PackBuffer buffer;
+		PackBufferInit(&buffer);
+
+		int retcode = SQLITE_MISMATCH;
+
+		if( ReadStackValue(2, &key, NULL, true) && ReadStackValue(3, &value, &buffer, false) ) {
+			retcode = ( value.iType == SQLITE_NULL ) ? pStore->remove(key) : pStore->set(key, value);
+		}
+
+		PackBufferFree(&buffer);
+
+		g_pLua->Push((float)retcode);
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(KVStoreRemove)
+{
+
+	KVSTORE_FROM_LUA();
+
+	ASSERT(pStore != NULL);
+	if( pStore )
+	{
+
+		KVValue key;
+
+		if( !ReadStackValue(2, &key, NULL, true) ) {
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 1;
+		}
+
+		g_pLua->Push((float)pStore->remove(key));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// kv:Increment(key, delta) adds delta (default 1) and returns the new value and the return code.
+// Integer results are numbers up to 2^24 and decimal strings past that, see LuaPushInteger.
+LUA_FUNCTION(KVStoreIncrement)
+{
+
+	KVSTORE_FROM_LUA();
+
+	ASSERT(pStore != NULL);
+	if( pStore )
+	{
+
+		KVValue key;
+		KVValue delta;
+
+		memset(&delta, 0, sizeof(delta));
+		delta.iType = SQLITE_INTEGER;
+		delta.iInteger = 1;
+
+		bool valid = ReadStackValue(2, &key, NULL, true);
+
+		// The delta can be a number or a decimal string, so a value read back from the store can be passed in again
+		switch( g_pLua->GetType(3) ) {
+		case GLua::TYPE_NIL:
+			break;
+		case GLua::TYPE_NUMBER:
+			valid = valid && ReadStackValue(3, &delta, NULL, false);
+			break;
+		case GLua::TYPE_STRING:
+			valid = valid && LuaGetInt64(3, &delta.iInteger);
+			break;
+		default:
+			valid = false;
+			break;
+		}
+
+		if( !valid ) {
+			g_pLua->PushNil();
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 2;
+		}
+
+		bool found = false;
+		int retcode = pStore->increment(key, delta, PushValueCallback, &found);
+
+		if( !found ) g_pLua->PushNil();
+		g_pLua->Push((float)retcode);
+		return 2;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+// kv:GetMany(keys) looks up an array of keys in one transaction, returning a table of the ones found and the return code
+LUA_FUNCTION(KVStoreGetMany)
+{
+
+	KVSTORE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_TABLE);
+
+	ASSERT(pStore != NULL);
+	if( pStore )
+	{
+
+		ILuaObject* pKeys = g_pLua->GetObject(2);
+		CUtlLuaVector* pMembers = pKeys ? pKeys->GetMembers() : NULL;
+
+		KVManyResults results;
+		results.pTable = g_pLua->GetNewTable();
+		results.pKey = NULL;
+
+		int retcode = ( pMembers && results.pTable ) ? pStore->beginBatch() : SQLITE_NOMEM;
+
+		if( retcode == SQLITE_OK ) {
+
+			for( int i = 0; i < pMembers->Count() && retcode == SQLITE_OK; i++ ) {
+
+				KVValue key;
+				results.pKey = pMembers->Element(i).pValue;
+
+				if( ReadValue(results.pKey, &key, NULL, true) ) {
+					retcode = pStore->get(key, CollectValueCallback, &results);
+				} else {
+					retcode = SQLITE_MISMATCH;
+				}
+
+			}
+
+			// Nothing was written, so a failed lookup leaves nothing to undo
+			int endcode = pStore->endBatch(true);
+			if( retcode == SQLITE_OK ) retcode = endcode;
+
+		}
+
+		if( pMembers ) g_pLua->DeleteLuaVector(pMembers);
+		SAFE_UNREF(pKeys);
+
+		if( results.pTable ) {
+			g_pLua->Push(results.pTable);
+			g_pLua->Push((float)retcode);
+			SAFE_UNREF(results.pTable);
+			return 2;
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// kv:SetMany(map) writes every pair of the table in one transaction, nothing is written if any of them fails
+LUA_FUNCTION(KVStoreSetMany)
+{
+
+	KVSTORE_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_TABLE);
+
+	ASSERT(pStore != NULL);
+	if( pStore )
+	{
+
+		ILuaObject* pMap = g_pLua->GetObject(2);
+		CUtlLuaVector* pMembers = pMap ? pMap->GetMembers() : NULL;
+
+		int retcode = pMembers ? pStore->beginBatch() : SQLITE_NOMEM;
+
+		if( retcode == SQLITE_OK ) {
+
+			PackBuffer buffer;
+			PackBufferInit(&buffer);
+
+			for( int i = 0; i < pMembers->Count() && retcode == SQLITE_OK; i++ ) {
+
+				LuaKeyValue& member = pMembers->Element(i);
+
+				KVValue key;
+				KVValue value;
+
+				if( ReadValue(member.pKey, &key, NULL, true) && ReadValue(member.pValue, &value, &buffer, false) ) {
+					retcode = pStore->set(key, value);
+				} else {
+					retcode = SQLITE_MISMATCH;
+				}
+
+				PackBufferFree(&buffer);
+
+			}
+
+			int endcode = pStore->endBatch(retcode == SQLITE_OK);
+			if( retcode == SQLITE_OK ) retcode = endcode;
+
+		}
+
+		if( pMembers ) g_pLua->DeleteLuaVector(pMembers);
+		SAFE_UNREF(pMap);
+
+		g_pLua->Push((float)retcode);
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
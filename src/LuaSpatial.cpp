@@ -0,0 +1,248 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "LuaSpatial.h"
+#include "spatial.h"
+#include "int64.h"
+
+static const char* s_pszAxes[] = { "x", "y", "z" };
+
+// Reads a point from either an array { 1, 2, 3 } or anything with x, y and z members such as a Vector
+static bool ReadPoint(int stackPos, int dimensions, double* point)
+{
+
+	ILuaObject* pPoint = g_pLua->GetObject(stackPos);
+	if( !pPoint ) return false;
+
+	bool valid = true;
+
+	for( int i = 0; i < dimensions && valid; i++ ) {
+
+		ILuaObject* pValue = pPoint->GetMember((float)(i + 1));
+
+		if( ( !pValue || !pValue->isNumber() ) && i < 3 ) {
+			SAFE_UNREF(pValue);
+			pValue = pPoint->GetMember(s_pszAxes[i]);
+		}
+
+		if( pValue && pValue->isNumber() ) {
+			point[i] = pValue->GetDouble();
+		} else {
+			valid = false;
+		}
+
+		SAFE_UNREF(pValue);
+
+	}
+
+	SAFE_UNREF(pPoint);
+	return valid;
+
+}
+
+struct SpatialResults
+{
+	ILuaObject* pTable;
+	int iCount;
+};
+
+static void CollectSpatialResult(void* usrPtr, sqlite3_int64 id)
+{
+	SpatialResults* pResults = (SpatialResults*)usrPtr;
+	LuaSetMemberInt64(pResults->pTable, (float)++pResults->iCount, id);
+}
+
+//-----------------------------------------------------------------------------
+// Spatial index functions
+//-----------------------------------------------------------------------------
+
+LUA_FUNCTION(SpatialDelete)
+{
+
+	SPATIAL_FROM_LUA();
+
+	ASSERT(pIndex != NULL);
+	if( pIndex )
+	{
+		delete pIndex;
+		pIndex = NULL;
+	}
+
+	return 0;
+
+}
+
+
+// index:Insert(id, min, max) stores the box between two corners, or a single point when max is left out
+LUA_FUNCTION(SpatialInsert)
+{
+
+	SPATIAL_FROM_LUA();
+
+	g_pLua->CheckType(3, GLua::TYPE_TABLE);
+
+	ASSERT(pIndex != NULL);
+	if( pIndex )
+	{
+
+		sqlite3_int64 id = 0;
+		double min[SPATIAL_MAX_DIMENSIONS];
+		double max[SPATIAL_MAX_DIMENSIONS];
+
+		int dimensions = pIndex->getDimensions();
+
+		if( !LuaGetInt64(2, &id) || !ReadPoint(3, dimensions, min) ) {
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 1;
+		}
+
+		if( g_pLua->GetType(4) == GLua::TYPE_NIL ) {
+			for( int i = 0; i < dimensions; i++ ) max[i] = min[i];
+		} else if( !ReadPoint(4, dimensions, max) ) {
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 1;
+		}
+
+		g_pLua->Push((float)pIndex->insert(id, min, max));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(SpatialRemove)
+{
+
+	SPATIAL_FROM_LUA();
+
+	ASSERT(pIndex != NULL);
+	if( pIndex )
+	{
+
+		sqlite3_int64 id = 0;
+
+		if( !LuaGetInt64(2, &id) ) {
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 1;
+		}
+
+		g_pLua->Push((float)pIndex->remove(id));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+// index:QueryBox(min, max) returns an array of the ids overlapping the box, as decimal strings, and the return code
+LUA_FUNCTION(SpatialQueryBox)
+{
+
+	SPATIAL_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_TABLE);
+	g_pLua->CheckType(3, GLua::TYPE_TABLE);
+
+	ASSERT(pIndex != NULL);
+	if( pIndex )
+	{
+
+		double min[SPATIAL_MAX_DIMENSIONS];
+		double max[SPATIAL_MAX_DIMENSIONS];
+
+		if( !ReadPoint(2, pIndex->getDimensions(), min) || !ReadPoint(3, pIndex->getDimensions(), max) ) {
+			g_pLua->PushNil();
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 2;
+		}
+
+		SpatialResults results;
+		results.pTable = g_pLua->GetNewTable();
+		results.iCount = 0;
+
+		ASSERT(results.pTable != NULL);
+		if( results.pTable ) {
+
+			int retcode = pIndex->queryBox(min, max, CollectSpatialResult, &results);
+
+			g_pLua->Push(results.pTable);
+			g_pLua->Push((float)retcode);
+			SAFE_UNREF(results.pTable);
+			return 2;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// index:QueryRadius(center, radius) returns an array of the ids within radius of center and the return code
+LUA_FUNCTION(SpatialQueryRadius)
+{
+
+	SPATIAL_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_TABLE);
+	g_pLua->CheckType(3, GLua::TYPE_NUMBER);
+
+	ASSERT(pIndex != NULL);
+	if( pIndex )
+	{
+
+		double center[SPATIAL_MAX_DIMENSIONS];
+
+		if( !ReadPoint(2, pIndex->getDimensions(), center) ) {
+			g_pLua->PushNil();
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 2;
+		}
+
+		SpatialResults results;
+		results.pTable = g_pLua->GetNewTable();
+		results.iCount = 0;
+
+		ASSERT(results.pTable != NULL);
+		if( results.pTable ) {
+
+			int retcode = pIndex->queryRadius(center, g_pLua->GetNumber(3), CollectSpatialResult, &results);
+
+			g_pLua->Push(results.pTable);
+			g_pLua->Push((float)retcode);
+			SAFE_UNREF(results.pTable);
+			return 2;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
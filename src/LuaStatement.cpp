@@ -1,543 +1,1291 @@
-/*
-
-    Gm_sqlite3 the improved sqlite library for Garry's Mod
-    Copyright (C) 2010 James John Kelly Jr
-
-	This library is free software; you can redistribute it and/or
-	modify it under the terms of the GNU Lesser General Public
-	License as published by the Free Software Foundation; either
-	version 2.1 of the License, or (at your option) any later version.
-
-	This library is distributed in the hope that it will be useful,
-	but WITHOUT ANY WARRANTY; without even the implied warranty of
-	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-	Lesser General Public License for more details.
-
-	You should have received a copy of the GNU Lesser General Public
-	License along with this library; if not, write to the Free Software
-	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
-
-*/
-
-#include "LuaStatement.h"
-#include "database.h"
-#include "statement.h"
-
-//-----------------------------------------------------------------------------
-// Statement functions
-//-----------------------------------------------------------------------------
-
-LUA_FUNCTION(StatementDelete)
-{
-
-	STATEMENT_FROM_LUA();
-
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		delete pStatement;
-		pStatement = NULL;
-	}
-
-	return 0;
-
-}
-
-
-
-LUA_FUNCTION(StatementFinalize)
-{
-
-	STATEMENT_FROM_LUA();
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->finalize());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(StatementSqlString)
-{
-
-	STATEMENT_FROM_LUA();
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((const char*)pStatement->getSql());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(StatementFetch)
-{
-
-	STATEMENT_FROM_LUA();
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-
-		ILuaObject* pRow = g_pLua->GetNewTable();
-		ASSERT(pRow != NULL);
-
-		if( pRow ) {
-
-			int retcode = pStatement->step();
-
-			if( retcode == SQLITE_ROW ) {
-
-				int numCols = pStatement->getNumberOfColumns();
-
-				int numBlobBytes = 0;
-				const void* pBlob = NULL;
-				ILuaObject* pLBlob = NULL;
-
-				for( int i = 0; i < numCols; i++ ) {
-
-					const char* pszColName = pStatement->getColumnName(i);
-
-					switch( pStatement->getColumnType(i) )
-					{
-						case SQLITE_INTEGER:
-							pRow->SetMember(pszColName, (float)pStatement->getInteger(i));
-						break;
-						case SQLITE_FLOAT:
-							pRow->SetMember(pszColName, pStatement->getFloat(i));
-						break;
-						case SQLITE_TEXT:
-							pRow->SetMember(pszColName, pStatement->getText(i));
-						break;
-						case SQLITE_BLOB:
-
-							numBlobBytes = 0;
-							pBlob = pStatement->getBlob(i, &numBlobBytes);
-
-							pLBlob = g_pLua->GetNewTable();
-							ASSERT(pLBlob != NULL);
-
-							if( pLBlob ) {
-								for( int b = 0; b < numBlobBytes; b++ ) {
-									pLBlob->SetMember((float)b, (float)((const char*)pBlob)[b]);
-								}
-								pRow->SetMember(pszColName, pLBlob);
-							} else {
-								pRow->SetMember(pszColName);
-							}
-
-							SAFE_UNREF(pLBlob);
-
-						break;
-						case SQLITE_NULL:
-							pRow->SetMember(pszColName);
-						break;
-					}
-
-				}
-
-				g_pLua->Push(pRow);
-
-			} else {
-
-				g_pLua->PushNil();
-
-			}
-
-			g_pLua->Push((float)retcode);
-			SAFE_UNREF(pRow);
-			return 2;
-
-		}
-
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementStep)
-{
-
-	STATEMENT_FROM_LUA();
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->step());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementReset)
-{
-
-	STATEMENT_FROM_LUA();
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->reset());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementClearBindings)
-{
-
-	STATEMENT_FROM_LUA();
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->clearBindings());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(StatementParameterCount)
-{
-
-	STATEMENT_FROM_LUA();
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->getNumberOfParameters());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementParameterName)
-{
-
-	STATEMENT_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((const char*)pStatement->getParameterName(g_pLua->GetInteger(2)));
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementParameterIndex)
-{
-
-	STATEMENT_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_STRING);
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->getParameterIndex(g_pLua->GetString(2)));
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-
-LUA_FUNCTION(StatementBindNull)
-{
-
-	STATEMENT_FROM_LUA();
-
-	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
-		g_pLua->CheckType(2, GLua::TYPE_STRING);
-		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	}
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
-			g_pLua->Push((float)pStatement->bindNull(g_pLua->GetInteger(2)));
-			return 1;
-		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
-			g_pLua->Push((float)pStatement->bindNull(g_pLua->GetString(2)));
-			return 1;
-		}
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementBindInteger)
-{
-
-	STATEMENT_FROM_LUA();
-
-	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
-		g_pLua->CheckType(2, GLua::TYPE_STRING);
-		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	}
-	g_pLua->CheckType(3, GLua::TYPE_NUMBER);
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
-			g_pLua->Push((float)pStatement->bindInteger(g_pLua->GetInteger(2), g_pLua->GetInteger(3)));
-			return 1;
-		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
-			g_pLua->Push((float)pStatement->bindInteger(g_pLua->GetString(2), g_pLua->GetInteger(3)));
-			return 1;
-		}
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementBindFloat)
-{
-
-	STATEMENT_FROM_LUA();
-
-	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
-		g_pLua->CheckType(2, GLua::TYPE_STRING);
-		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	}
-	g_pLua->CheckType(3, GLua::TYPE_NUMBER);
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
-			g_pLua->Push((float)pStatement->bindFloat(g_pLua->GetInteger(2), g_pLua->GetNumber(3)));
-			return 1;
-		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
-			g_pLua->Push((float)pStatement->bindFloat(g_pLua->GetString(2), g_pLua->GetNumber(3)));
-			return 1;
-		}
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementBindString)
-{
-
-	STATEMENT_FROM_LUA();
-
-	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
-		g_pLua->CheckType(2, GLua::TYPE_STRING);
-		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	}
-	g_pLua->CheckType(3, GLua::TYPE_STRING);
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
-			g_pLua->Push((float)pStatement->bindText(g_pLua->GetInteger(2), g_pLua->GetString(3)));
-			return 1;
-		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
-			g_pLua->Push((float)pStatement->bindText(g_pLua->GetString(2), g_pLua->GetString(3)));
-			return 1;
-		}
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementColumnCount)
-{
-
-	STATEMENT_FROM_LUA();
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->getNumberOfColumns());
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementColumnName)
-{
-
-	STATEMENT_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((const char*)pStatement->getColumnName(g_pLua->GetInteger(2)));
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementColumnIndex)
-{
-
-	STATEMENT_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_STRING);
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->getColumnIndex(g_pLua->GetString(2)));
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementColumnType)
-{
-
-	STATEMENT_FROM_LUA();
-
-	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		g_pLua->Push((float)pStatement->getColumnType(g_pLua->GetInteger(2)));
-		return 1;
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementGetInteger)
-{
-
-	STATEMENT_FROM_LUA();
-
-	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
-		g_pLua->CheckType(2, GLua::TYPE_STRING);
-		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	}
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
-			g_pLua->Push((float)pStatement->getInteger(g_pLua->GetInteger(2)));
-			return 1;
-		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
-			g_pLua->Push((float)pStatement->getInteger(g_pLua->GetString(2)));
-			return 1;
-		}
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementGetFloat)
-{
-
-	STATEMENT_FROM_LUA();
-
-	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
-		g_pLua->CheckType(2, GLua::TYPE_STRING);
-		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	}
-	
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
-			g_pLua->Push((float)pStatement->getFloat(g_pLua->GetInteger(2)));
-			return 1;
-		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
-			g_pLua->Push((float)pStatement->getFloat(g_pLua->GetString(2)));
-			return 1;
-		}
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
-
-LUA_FUNCTION(StatementGetString)
-{
-
-	STATEMENT_FROM_LUA();
-
-	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
-		g_pLua->CheckType(2, GLua::TYPE_STRING);
-		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
-	}
-
-	ASSERT(pStatement != NULL);
-	if( pStatement )
-	{
-		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
-			g_pLua->Push((const char*)pStatement->getText(g_pLua->GetInteger(2)));
-			return 1;
-		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
-			g_pLua->Push((const char*)pStatement->getText(g_pLua->GetString(2)));
-			return 1;
-		}
-	}
-
-	g_pLua->PushNil();
-	return 1;
-
-}
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "LuaStatement.h"
+#include "database.h"
+#include "statement.h"
+#include "int64.h"
+#include "json.h"
+#include "packed.h"
+#include "compress.h"
+#include "array.h"
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// Statement functions
+//-----------------------------------------------------------------------------
+
+LUA_FUNCTION(StatementDelete)
+{
+
+	STATEMENT_FROM_LUA();
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		delete pStatement;
+		pStatement = NULL;
+	}
+
+	return 0;
+
+}
+
+
+
+LUA_FUNCTION(StatementFinalize)
+{
+
+	STATEMENT_FROM_LUA();
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->finalize());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(StatementSqlString)
+{
+
+	STATEMENT_FROM_LUA();
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((const char*)pStatement->getSql());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+//-----------------------------------------------------------------------------
+// Column decoders used by Fetch
+//-----------------------------------------------------------------------------
+
+// Decodes a value already known to be of the given storage class
+
+template<int iType>
+static void DecodeValue(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i);
+
+// Integers past what a Lua number holds exactly come back as decimal strings
+template<>
+void DecodeValue<SQLITE_INTEGER>(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+	LuaSetMemberInteger(pRow, pszColName, pStatement->getInt64(i));
+}
+
+template<>
+void DecodeValue<SQLITE_FLOAT>(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+	pRow->SetMember(pszColName, pStatement->getFloat(i));
+}
+
+template<>
+void DecodeValue<SQLITE_TEXT>(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+	pRow->SetMember(pszColName, pStatement->getText(i));
+}
+
+template<>
+void DecodeValue<SQLITE_BLOB>(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+
+	int numBlobBytes = 0;
+	const void* pBlob = pStatement->getBlob(i, &numBlobBytes);
+
+	ILuaObject* pLBlob = g_pLua->GetNewTable();
+	ASSERT(pLBlob != NULL);
+
+	if( pLBlob ) {
+		for( int b = 0; b < numBlobBytes; b++ ) {
+			pLBlob->SetMember((float)b, (float)((const char*)pBlob)[b]);
+		}
+		pRow->SetMember(pszColName, pLBlob);
+	} else {
+		pRow->SetMember(pszColName);
+	}
+
+	SAFE_UNREF(pLBlob);
+
+}
+
+static void DecodeAny(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+	switch( pStatement->getColumnType(i) )
+	{
+		case SQLITE_INTEGER:
+			DecodeValue<SQLITE_INTEGER>(pStatement, pRow, pszColName, i);
+		break;
+		case SQLITE_FLOAT:
+			DecodeValue<SQLITE_FLOAT>(pStatement, pRow, pszColName, i);
+		break;
+		case SQLITE_TEXT:
+			DecodeValue<SQLITE_TEXT>(pStatement, pRow, pszColName, i);
+		break;
+		case SQLITE_BLOB:
+			DecodeValue<SQLITE_BLOB>(pStatement, pRow, pszColName, i);
+		break;
+		case SQLITE_NULL:
+			pRow->SetMember(pszColName);
+		break;
+	}
+}
+
+static void DecodeInt64(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+	if( pStatement->getColumnType(i) == SQLITE_INTEGER ) {
+		char buffer[INT64_STRING_LENGTH];
+		pRow->SetMember(pszColName, (const char*)Int64ToString(pStatement->getInt64(i), buffer));
+	} else {
+		DecodeAny(pStatement, pRow, pszColName, i);
+	}
+}
+
+// Text that does not parse is handed back as it is instead of being dropped
+static void DecodeJson(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+
+	if( pStatement->getColumnType(i) != SQLITE_TEXT ) {
+		DecodeAny(pStatement, pRow, pszColName, i);
+		return;
+	}
+
+	const char* pszText = pStatement->getText(i);
+	ILuaObject* pValue = JsonDecode(pszText, -1);
+
+	if( pValue ) {
+		pRow->SetMember(pszColName, pValue);
+	} else {
+		pRow->SetMember(pszColName, pszText);
+	}
+
+	SAFE_UNREF(pValue);
+
+}
+
+// BLOBs that do not decode are handed back as they are
+static void DecodePacked(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+
+	if( pStatement->getColumnType(i) != SQLITE_BLOB ) {
+		DecodeAny(pStatement, pRow, pszColName, i);
+		return;
+	}
+
+	int length = 0;
+	const void* pData = pStatement->getBlob(i, &length);
+	ILuaObject* pValue = PackDecode(pData, length);
+
+	if( pValue ) {
+		pRow->SetMember(pszColName, pValue);
+	} else {
+		DecodeAny(pStatement, pRow, pszColName, i);
+	}
+
+	SAFE_UNREF(pValue);
+
+}
+
+// Undoes BindCompressed or compress(), values that were never compressed or are corrupt come back as they are
+static void DecodeCompressed(CStatement* pStatement, ILuaObject* pRow, const char* pszColName, int i)
+{
+
+	int length = 0;
+	int originalLength = 0;
+	bool isText = false;
+	const void* pData = NULL;
+
+	if( pStatement->getColumnType(i) == SQLITE_BLOB ) {
+		pData = pStatement->getBlob(i, &length);
+	}
+
+	if( !CompressedInfo(pData, length, &originalLength, &isText) ) {
+		DecodeAny(pStatement, pRow, pszColName, i);
+		return;
+	}
+
+	// One extra byte terminates the text for Lua
+	unsigned char* pOut = (unsigned char*)ScratchAlloc(originalLength + 1);
+
+	if( pOut && DecompressValue(pData, length, pOut) ) {
+
+		if( isText ) {
+			pOut[originalLength] = '\0';
+			pRow->SetMember(pszColName, (const char*)pOut);
+		} else {
+			ILuaObject* pLBlob = g_pLua->GetNewTable();
+			if( pLBlob ) {
+				for( int b = 0; b < originalLength; b++ ) {
+					pLBlob->SetMember((float)b, (float)((const char*)pOut)[b]);
+				}
+				pRow->SetMember(pszColName, pLBlob);
+			}
+			SAFE_UNREF(pLBlob);
+		}
+
+	} else {
+		DecodeAny(pStatement, pRow, pszColName, i);
+	}
+
+	if( pOut ) ScratchFree(pOut, originalLength + 1);
+
+}
+
+static bool ResolveColumnDecoder(const char* pszType, ResultColumn* pColumn)
+{
+
+	if( stricmp(pszType, "int") == 0 || stricmp(pszType, "integer") == 0 ) {
+		pColumn->iType = SQLITE_INTEGER;
+		pColumn->pDecoder = DecodeValue<SQLITE_INTEGER>;
+	} else if( stricmp(pszType, "int64") == 0 ) {
+		pColumn->iType = SQLITE_INTEGER;
+		pColumn->pDecoder = DecodeInt64;
+	} else if( stricmp(pszType, "real") == 0 || stricmp(pszType, "float") == 0 ) {
+		pColumn->iType = SQLITE_FLOAT;
+		pColumn->pDecoder = DecodeValue<SQLITE_FLOAT>;
+	} else if( stricmp(pszType, "text") == 0 || stricmp(pszType, "string") == 0 ) {
+		pColumn->iType = SQLITE_TEXT;
+		pColumn->pDecoder = DecodeValue<SQLITE_TEXT>;
+	} else if( stricmp(pszType, "blob") == 0 ) {
+		pColumn->iType = SQLITE_BLOB;
+		pColumn->pDecoder = DecodeValue<SQLITE_BLOB>;
+	} else if( stricmp(pszType, "json") == 0 ) {
+		pColumn->iType = SQLITE_TEXT;
+		pColumn->pDecoder = DecodeJson;
+	} else if( stricmp(pszType, "packed") == 0 ) {
+		pColumn->iType = SQLITE_BLOB;
+		pColumn->pDecoder = DecodePacked;
+	} else if( stricmp(pszType, "compressed") == 0 ) {
+		pColumn->iType = SQLITE_BLOB;
+		pColumn->pDecoder = DecodeCompressed;
+	} else if( stricmp(pszType, "any") == 0 ) {
+		pColumn->iType = 0;
+		pColumn->pDecoder = DecodeAny;
+	} else {
+		return false;
+	}
+
+	return true;
+
+}
+
+LUA_FUNCTION(StatementFetch)
+{
+
+	STATEMENT_FROM_LUA();
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		ILuaObject* pRow = g_pLua->GetNewTable();
+		ASSERT(pRow != NULL);
+
+		if( pRow ) {
+
+			int retcode = pStatement->step();
+
+			if( retcode == SQLITE_ROW ) {
+
+				int numCols = pStatement->getNumberOfColumns();
+
+				int numSchemaCols = 0;
+				const ResultColumn* pSchema = pStatement->getResultSchema(&numSchemaCols);
+
+				int i = 0;
+
+				// Declared columns are only checked against the first row, after that they skip the type switch.
+				// A column that does not match keeps decoding dynamically until the next result set.
+				if( pSchema && pStatement->getRow() == 1 ) {
+					pStatement->resolveResultSchema(DecodeAny);
+				}
+
+				for( ; i < numSchemaCols && i < numCols; i++ ) {
+					pSchema[i].pResolved(pStatement, pRow, pSchema[i].pszName, i);
+				}
+
+				for( ; i < numCols; i++ ) {
+					DecodeAny(pStatement, pRow, pStatement->getColumnName(i), i);
+				}
+
+				g_pLua->Push(pRow);
+
+			} else {
+
+				g_pLua->PushNil();
+
+			}
+
+			g_pLua->Push((float)retcode);
+			SAFE_UNREF(pRow);
+			return 2;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// stmt:SetResultSchema({"int", "text", ...}) declares the storage class of the leading columns. The first row of each
+// result set is checked against it, the rest are decoded without looking at their type, so a column that can hold NULL
+// or mixed types further down should be declared "any".
+LUA_FUNCTION(StatementSetResultSchema)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_TABLE && g_pLua->GetType(2) != GLua::TYPE_NIL ) {
+		g_pLua->CheckType(2, GLua::TYPE_TABLE);
+	}
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		// Passing nil goes back to decoding every cell dynamically
+		if( g_pLua->GetType(2) == GLua::TYPE_NIL ) {
+			pStatement->clearResultSchema();
+			g_pLua->Push((float)SQLITE_OK);
+			return 1;
+		}
+
+		int numCols = pStatement->getNumberOfColumns();
+		size_t columnsSize = sizeof(ResultColumn) * ( numCols > 0 ? numCols : 1 );
+		ResultColumn* pColumns = (ResultColumn*)ScratchAlloc(columnsSize);
+
+		if( !pColumns ) {
+			g_pLua->Push((float)SQLITE_NOMEM);
+			return 1;
+		}
+
+		ILuaObject* pTypes = g_pLua->GetObject(2);
+
+		int count = 0;
+		int retcode = SQLITE_OK;
+
+		for( ; pTypes && count <= numCols; count++ ) {
+
+			ILuaObject* pType = pTypes->GetMember((float)(count + 1));
+
+			if( !pType || pType->isNil() ) {
+				SAFE_UNREF(pType);
+				break;
+			}
+
+			if( count == numCols ) {
+				retcode = SQLITE_RANGE;
+			} else if( !pType->isString() || !ResolveColumnDecoder(pType->GetString(), &pColumns[count]) ) {
+				retcode = SQLITE_MISMATCH;
+			}
+
+			SAFE_UNREF(pType);
+
+			if( retcode != SQLITE_OK ) break;
+
+		}
+
+		if( retcode == SQLITE_OK ) {
+			retcode = pStatement->setResultSchema(pColumns, count);
+		}
+
+		SAFE_UNREF(pTypes);
+		ScratchFree(pColumns, columnsSize);
+
+		g_pLua->Push((float)retcode);
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementStep)
+{
+
+	STATEMENT_FROM_LUA();
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->step());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementReset)
+{
+
+	STATEMENT_FROM_LUA();
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->reset());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementClearBindings)
+{
+
+	STATEMENT_FROM_LUA();
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->clearBindings());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(StatementParameterCount)
+{
+
+	STATEMENT_FROM_LUA();
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->getNumberOfParameters());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementParameterName)
+{
+
+	STATEMENT_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((const char*)pStatement->getParameterName(g_pLua->GetInteger(2)));
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementParameterIndex)
+{
+
+	STATEMENT_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->getParameterIndex(g_pLua->GetString(2)));
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+
+LUA_FUNCTION(StatementBindNull)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			g_pLua->Push((float)pStatement->bindNull(g_pLua->GetInteger(2)));
+			return 1;
+		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
+			g_pLua->Push((float)pStatement->bindNull(g_pLua->GetString(2)));
+			return 1;
+		}
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementBindInteger)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	g_pLua->CheckType(3, GLua::TYPE_NUMBER);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		// Go through int64 so values past 32 bits aren't truncated
+		sqlite3_int64 value = 0;
+		if( !LuaGetInt64(3, &value) ) {
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 1;
+		}
+
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			g_pLua->Push((float)pStatement->bindInt64(g_pLua->GetInteger(2), value));
+			return 1;
+		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
+			g_pLua->Push((float)pStatement->bindInt64(g_pLua->GetString(2), value));
+			return 1;
+		}
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// Accepts a number or a decimal string, so SteamID64s and large rowids survive intact
+LUA_FUNCTION(StatementBindInt64)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	if( g_pLua->GetType(3) != GLua::TYPE_STRING && g_pLua->GetType(3) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(3, GLua::TYPE_STRING);
+		g_pLua->CheckType(3, GLua::TYPE_NUMBER);
+	}
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		sqlite3_int64 value = 0;
+		if( !LuaGetInt64(3, &value) ) {
+			g_pLua->Push((float)SQLITE_MISMATCH);
+			return 1;
+		}
+
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			g_pLua->Push((float)pStatement->bindInt64(g_pLua->GetInteger(2), value));
+			return 1;
+		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
+			g_pLua->Push((float)pStatement->bindInt64(g_pLua->GetString(2), value));
+			return 1;
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementBindFloat)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	g_pLua->CheckType(3, GLua::TYPE_NUMBER);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			g_pLua->Push((float)pStatement->bindFloat(g_pLua->GetInteger(2), g_pLua->GetNumber(3)));
+			return 1;
+		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
+			g_pLua->Push((float)pStatement->bindFloat(g_pLua->GetString(2), g_pLua->GetNumber(3)));
+			return 1;
+		}
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// Passing true as the fourth argument binds the Lua string in place instead of letting SQLite copy it
+LUA_FUNCTION(StatementBindString)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	g_pLua->CheckType(3, GLua::TYPE_STRING);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		unsigned int length = 0;
+		const char* pszValue = g_pLua->GetString(3, &length);
+
+		int index = 0;
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			index = g_pLua->GetInteger(2);
+		} else {
+			index = pStatement->getParameterIndex(g_pLua->GetString(2));
+		}
+
+		// The reference is only taken once there's a statement to pin it to
+		if( g_pLua->GetType(4) == GLua::TYPE_BOOL && g_pLua->GetBool(4) && !pStatement->isFinalized() ) {
+			g_pLua->Push((float)pStatement->bindTextStatic(index, pszValue, (int)length, g_pLua->GetObject(3)));
+		} else {
+			g_pLua->Push((float)pStatement->bindText(index, pszValue, (int)length));
+		}
+
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementBindBlob)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	g_pLua->CheckType(3, GLua::TYPE_STRING);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		unsigned int length = 0;
+		const char* pData = g_pLua->GetString(3, &length);
+
+		int index = 0;
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			index = g_pLua->GetInteger(2);
+		} else {
+			index = pStatement->getParameterIndex(g_pLua->GetString(2));
+		}
+
+		if( g_pLua->GetType(4) == GLua::TYPE_BOOL && g_pLua->GetBool(4) && !pStatement->isFinalized() ) {
+			g_pLua->Push((float)pStatement->bindBlobStatic(index, pData, (int)length, g_pLua->GetObject(3)));
+		} else {
+			g_pLua->Push((float)pStatement->bindBlob(index, pData, (int)length));
+		}
+
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementBindJSON)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	g_pLua->CheckType(3, GLua::TYPE_TABLE);
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		int index = 0;
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			index = g_pLua->GetInteger(2);
+		} else {
+			index = pStatement->getParameterIndex(g_pLua->GetString(2));
+		}
+
+		sqlite3_str* pText = sqlite3_str_new(NULL);
+		ILuaObject* pValue = g_pLua->GetObject(3);
+
+		bool valid = JsonEncode(pValue, pText);
+		int length = sqlite3_str_length(pText);
+		char* pszText = sqlite3_str_finish(pText);
+
+		SAFE_UNREF(pValue);
+
+		if( valid && pszText ) {
+			g_pLua->Push((float)pStatement->bindText(index, pszText, length));
+		} else {
+			g_pLua->Push((float)( pszText ? SQLITE_MISMATCH : SQLITE_NOMEM ));
+		}
+
+		sqlite3_free(pszText);
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementBindPacked)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	g_pLua->CheckType(3, GLua::TYPE_TABLE);
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		int index = 0;
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			index = g_pLua->GetInteger(2);
+		} else {
+			index = pStatement->getParameterIndex(g_pLua->GetString(2));
+		}
+
+		PackBuffer buffer;
+		PackBufferInit(&buffer);
+
+		ILuaObject* pValue = g_pLua->GetObject(3);
+
+		if( PackEncode(pValue, &buffer) ) {
+			g_pLua->Push((float)pStatement->bindBlob(index, (const char*)buffer.pData, buffer.iLength));
+		} else {
+			g_pLua->Push((float)( buffer.bOutOfMemory ? SQLITE_NOMEM : SQLITE_MISMATCH ));
+		}
+
+		SAFE_UNREF(pValue);
+		PackBufferFree(&buffer);
+
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// Strings bind as TEXT once decompressed unless the fourth argument is true
+LUA_FUNCTION(StatementBindCompressed)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	g_pLua->CheckType(3, GLua::TYPE_STRING);
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		unsigned int length = 0;
+		const char* pData = g_pLua->GetString(3, &length);
+		bool isBlob = ( g_pLua->GetType(4) == GLua::TYPE_BOOL && g_pLua->GetBool(4) );
+
+		int index = 0;
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			index = g_pLua->GetInteger(2);
+		} else {
+			index = pStatement->getParameterIndex(g_pLua->GetString(2));
+		}
+
+		int bound = CompressBound((int)length);
+		unsigned char* pOut = (unsigned char*)ScratchAlloc(bound);
+
+		if( pOut ) {
+			int outLength = CompressValue(pData, (int)length, !isBlob, pOut);
+			g_pLua->Push((float)pStatement->bindBlob(index, (const char*)pOut, outLength));
+			ScratchFree(pOut, bound);
+		} else {
+			g_pLua->Push((float)SQLITE_NOMEM);
+		}
+
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// stmt:BindArray(index or name, array, type) binds the elements 1..n for gm_array(), type is "int", "real" or "text".
+// Without a type, numbers bind as int when every one of them is whole and fits 64 bits and strings as text.
+// With "int", strings have to be decimal integers like the ones LastInsertId64 returns.
+LUA_FUNCTION(StatementBindArray)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	g_pLua->CheckType(3, GLua::TYPE_TABLE);
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		int index = 0;
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			index = g_pLua->GetInteger(2);
+		} else {
+			index = pStatement->getParameterIndex(g_pLua->GetString(2));
+		}
+
+		int type = 0;
+		if( g_pLua->GetType(4) == GLua::TYPE_STRING ) {
+			const char* pszType = g_pLua->GetString(4);
+			if( stricmp(pszType, "int") == 0 || stricmp(pszType, "integer") == 0 ) type = SQLITE_INTEGER;
+			else if( stricmp(pszType, "real") == 0 || stricmp(pszType, "float") == 0 ) type = SQLITE_FLOAT;
+			else if( stricmp(pszType, "text") == 0 || stricmp(pszType, "string") == 0 ) type = SQLITE_TEXT;
+			else {
+				g_pLua->Push((float)SQLITE_MISMATCH);
+				return 1;
+			}
+		}
+
+		ILuaObject* pArray = g_pLua->GetObject(3);
+
+		// Counts the elements and works out the type when none was given
+		int count = 0;
+		bool allWhole = true;
+		bool allInRange = true;
+		int valueType = GLua::TYPE_NIL;
+		bool valid = ( pArray != NULL );
+
+		while( valid ) {
+
+			ILuaObject* pValue = pArray->GetMember((float)( count + 1 ));
+
+			if( !pValue || pValue->isNil() ) {
+				SAFE_UNREF(pValue);
+				break;
+			}
+
+			if( valueType == GLua::TYPE_NIL ) valueType = pValue->GetType();
+
+			if( pValue->GetType() != valueType || ( !pValue->isNumber() && !pValue->isString() ) ) {
+				valid = false;
+			} else if( pValue->isNumber() ) {
+				// NaN fails the range check as well, casting either to an integer is undefined
+				double number = pValue->GetDouble();
+				allWhole = allWhole && ( number == floor(number) );
+				allInRange = allInRange && ( number >= -9223372036854775808.0 && number < 9223372036854775808.0 );
+			} else if( type == SQLITE_INTEGER ) {
+				sqlite3_int64 integer = 0;
+				valid = StringToInt64(pValue->GetString(), &integer);
+			}
+
+			SAFE_UNREF(pValue);
+			count++;
+
+		}
+
+		// Strings only become numbers as 64-bit integers, checked above
+		if( valueType == GLua::TYPE_STRING && type == SQLITE_FLOAT ) valid = false;
+		if( valueType == GLua::TYPE_NUMBER && type == SQLITE_INTEGER && !allInRange ) valid = false;
+
+		if( type == 0 ) {
+			type = ( valueType == GLua::TYPE_STRING ) ? SQLITE_TEXT : ( allWhole && allInRange ? SQLITE_INTEGER : SQLITE_FLOAT );
+		}
+
+		ArrayParam* pParam = valid ? CreateArrayParam(type, count) : NULL;
+
+		for( int i = 0; pParam && i < count; i++ ) {
+
+			ILuaObject* pValue = pArray->GetMember((float)( i + 1 ));
+
+			switch( type ) {
+			case SQLITE_INTEGER:
+				if( pValue->isString() ) {
+					StringToInt64(pValue->GetString(), &pParam->pIntegers[i]);
+				} else {
+					pParam->pIntegers[i] = (sqlite3_int64)pValue->GetDouble();
+				}
+				break;
+			case SQLITE_FLOAT:		pParam->pFloats[i] = pValue->GetDouble(); break;
+			case SQLITE_TEXT:
+				// Whole numbers asked for as text are written without a fraction, the way tostring does
+				if( pValue->isString() ) {
+					pParam->ppStrings[i] = sqlite3_mprintf("%s", pValue->GetString());
+				} else if( pValue->GetDouble() == floor(pValue->GetDouble()) && fabs(pValue->GetDouble()) < 1e15 ) {
+					pParam->ppStrings[i] = sqlite3_mprintf("%lld", (sqlite3_int64)pValue->GetDouble());
+				} else {
+					pParam->ppStrings[i] = sqlite3_mprintf("%.14g", pValue->GetDouble());
+				}
+				if( !pParam->ppStrings[i] ) {
+					FreeArrayParam(pParam);
+					pParam = NULL;
+				}
+				break;
+			}
+
+			SAFE_UNREF(pValue);
+
+		}
+
+		SAFE_UNREF(pArray);
+
+		if( !pParam ) {
+			g_pLua->Push((float)( valid ? SQLITE_NOMEM : SQLITE_MISMATCH ));
+			return 1;
+		}
+
+		g_pLua->Push((float)pStatement->bindPointer(index, pParam, ARRAY_POINTER_TYPE, FreeArrayParam));
+		return 1;
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementColumnCount)
+{
+
+	STATEMENT_FROM_LUA();
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->getNumberOfColumns());
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementColumnName)
+{
+
+	STATEMENT_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((const char*)pStatement->getColumnName(g_pLua->GetInteger(2)));
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementColumnIndex)
+{
+
+	STATEMENT_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_STRING);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->getColumnIndex(g_pLua->GetString(2)));
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementColumnType)
+{
+
+	STATEMENT_FROM_LUA();
+
+	g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		g_pLua->Push((float)pStatement->getColumnType(g_pLua->GetInteger(2)));
+		return 1;
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+// stmt:Status(reset) wraps sqlite3_stmt_status
+LUA_FUNCTION(StatementStatus)
+{
+
+	STATEMENT_FROM_LUA();
+
+	static const struct { int op; const char* pszName; } s_Counters[] = {
+		{ SQLITE_STMTSTATUS_FULLSCAN_STEP,	"fullscan_step" },
+		{ SQLITE_STMTSTATUS_SORT,			"sort" },
+		{ SQLITE_STMTSTATUS_AUTOINDEX,		"autoindex" },
+		{ SQLITE_STMTSTATUS_VM_STEP,		"vm_step" },
+		{ SQLITE_STMTSTATUS_REPREPARE,		"reprepare" },
+		{ SQLITE_STMTSTATUS_RUN,			"run" },
+		{ SQLITE_STMTSTATUS_MEMUSED,		"memused" },
+	};
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		bool reset = ( g_pLua->GetType(2) == GLua::TYPE_BOOL && g_pLua->GetBool(2) );
+
+		ILuaObject* pStatus = g_pLua->GetNewTable();
+
+		ASSERT(pStatus != NULL);
+		if( pStatus ) {
+
+			for( int i = 0; i < (int)( sizeof(s_Counters) / sizeof(s_Counters[0]) ); i++ ) {
+				pStatus->SetMember(s_Counters[i].pszName, (float)pStatement->getStatus(s_Counters[i].op, reset));
+			}
+
+			g_pLua->Push(pStatus);
+			SAFE_UNREF(pStatus);
+			return 1;
+
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementGetInteger)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			g_pLua->Push((float)pStatement->getInteger(g_pLua->GetInteger(2)));
+			return 1;
+		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
+			g_pLua->Push((float)pStatement->getInteger(g_pLua->GetString(2)));
+			return 1;
+		}
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementGetInt64)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			LuaPushInt64(pStatement->getInt64(g_pLua->GetInteger(2)));
+			return 1;
+		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
+			LuaPushInt64(pStatement->getInt64(g_pLua->GetString(2)));
+			return 1;
+		}
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementGetFloat)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+	
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			g_pLua->Push((float)pStatement->getFloat(g_pLua->GetInteger(2)));
+			return 1;
+		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
+			g_pLua->Push((float)pStatement->getFloat(g_pLua->GetString(2)));
+			return 1;
+		}
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementGetString)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			g_pLua->Push((const char*)pStatement->getText(g_pLua->GetInteger(2)));
+			return 1;
+		} else if( g_pLua->GetType(2) == GLua::TYPE_STRING ) {
+			g_pLua->Push((const char*)pStatement->getText(g_pLua->GetString(2)));
+			return 1;
+		}
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
+
+LUA_FUNCTION(StatementGetPacked)
+{
+
+	STATEMENT_FROM_LUA();
+
+	if( g_pLua->GetType(2) != GLua::TYPE_STRING && g_pLua->GetType(2) != GLua::TYPE_NUMBER ) {
+		g_pLua->CheckType(2, GLua::TYPE_STRING);
+		g_pLua->CheckType(2, GLua::TYPE_NUMBER);
+	}
+
+	ASSERT(pStatement != NULL);
+	if( pStatement )
+	{
+
+		int length = 0;
+		const void* pData = NULL;
+
+		if( g_pLua->GetType(2) == GLua::TYPE_NUMBER ) {
+			pData = pStatement->getBlob(g_pLua->GetInteger(2), &length);
+		} else {
+			pData = pStatement->getBlob(g_pLua->GetString(2), &length);
+		}
+
+		ILuaObject* pValue = PackDecode(pData, length);
+
+		if( pValue ) {
+			g_pLua->Push(pValue);
+			SAFE_UNREF(pValue);
+			return 1;
+		}
+
+	}
+
+	g_pLua->PushNil();
+	return 1;
+
+}
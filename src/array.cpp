@@ -0,0 +1,233 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "array.h"
+
+#define ARRAY_COLUMN_VALUE		0
+#define ARRAY_COLUMN_POINTER	1	// hidden, the argument of the function
+
+ArrayParam* CreateArrayParam(int type, int count)
+{
+
+	if( count < 0 ) return NULL;
+
+	int elementSize = 0;
+	switch( type ) {
+	case SQLITE_INTEGER:	elementSize = sizeof(sqlite3_int64); break;
+	case SQLITE_FLOAT:		elementSize = sizeof(double); break;
+	case SQLITE_TEXT:		elementSize = sizeof(char*); break;
+	default:				return NULL;
+	}
+
+	// The elements follow the header in the same allocation
+	sqlite3_uint64 size = sizeof(ArrayParam) + (sqlite3_uint64)elementSize * count;
+	ArrayParam* pParam = (ArrayParam*)sqlite3_malloc64(size);
+	if( !pParam ) return NULL;
+
+	memset(pParam, 0, (size_t)size);
+	pParam->iType = type;
+	pParam->iCount = count;
+
+	void* pElements = (void*)( pParam + 1 );
+	if( type == SQLITE_INTEGER ) pParam->pIntegers = (sqlite3_int64*)pElements;
+	else if( type == SQLITE_FLOAT ) pParam->pFloats = (double*)pElements;
+	else pParam->ppStrings = (char**)pElements;
+
+	return pParam;
+
+}
+
+void FreeArrayParam(void* param)
+{
+
+	ArrayParam* pParam = (ArrayParam*)param;
+	if( !pParam ) return;
+
+	if( pParam->ppStrings ) {
+		for( int i = 0; i < pParam->iCount; i++ ) {
+			sqlite3_free(pParam->ppStrings[i]);
+		}
+	}
+
+	sqlite3_free(pParam);
+
+}
+
+//-----------------------------------------------------------------------------
+// Virtual table
+//-----------------------------------------------------------------------------
+
+struct ArrayCursor
+{
+	sqlite3_vtab_cursor base;
+	ArrayParam* pParam;		// owned by the bound parameter, NULL gives no rows
+	int iRow;
+};
+
+static int ArrayConnect(sqlite3* db, void* pAux, int argc, const char* const* argv, sqlite3_vtab** ppVtab, char** pzErr)
+{
+
+	int retcode = sqlite3_declare_vtab(db, "CREATE TABLE x(value, pointer HIDDEN)");
+	if( retcode != SQLITE_OK ) return retcode;
+
+	sqlite3_vtab* pVtab = (sqlite3_vtab*)sqlite3_malloc(sizeof(sqlite3_vtab));
+	if( !pVtab ) return SQLITE_NOMEM;
+
+	memset(pVtab, 0, sizeof(*pVtab));
+	*ppVtab = pVtab;
+
+#ifdef SQLITE_VTAB_INNOCUOUS
+	sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+#endif
+
+	return SQLITE_OK;
+
+}
+
+static int ArrayDisconnect(sqlite3_vtab* pVtab)
+{
+	sqlite3_free(pVtab);
+	return SQLITE_OK;
+}
+
+static int ArrayOpen(sqlite3_vtab* pVtab, sqlite3_vtab_cursor** ppCursor)
+{
+	ArrayCursor* pCursor = (ArrayCursor*)sqlite3_malloc(sizeof(ArrayCursor));
+	if( !pCursor ) return SQLITE_NOMEM;
+	memset(pCursor, 0, sizeof(*pCursor));
+	*ppCursor = &pCursor->base;
+	return SQLITE_OK;
+}
+
+static int ArrayClose(sqlite3_vtab_cursor* pCursor)
+{
+	sqlite3_free(pCursor);
+	return SQLITE_OK;
+}
+
+static int ArrayFilter(sqlite3_vtab_cursor* pBase, int idxNum, const char* idxStr, int argc, sqlite3_value** argv)
+{
+	ArrayCursor* pCursor = (ArrayCursor*)pBase;
+	pCursor->pParam = ( idxNum == 1 && argc > 0 ) ? (ArrayParam*)sqlite3_value_pointer(argv[0], ARRAY_POINTER_TYPE) : NULL;
+	pCursor->iRow = 0;
+	return SQLITE_OK;
+}
+
+static int ArrayNext(sqlite3_vtab_cursor* pBase)
+{
+	((ArrayCursor*)pBase)->iRow++;
+	return SQLITE_OK;
+}
+
+static int ArrayEof(sqlite3_vtab_cursor* pBase)
+{
+	ArrayCursor* pCursor = (ArrayCursor*)pBase;
+	return !pCursor->pParam || pCursor->iRow >= pCursor->pParam->iCount;
+}
+
+static int ArrayColumn(sqlite3_vtab_cursor* pBase, sqlite3_context* context, int column)
+{
+
+	ArrayCursor* pCursor = (ArrayCursor*)pBase;
+	ArrayParam* pParam = pCursor->pParam;
+
+	if( column != ARRAY_COLUMN_VALUE || !pParam ) {
+		sqlite3_result_null(context);
+		return SQLITE_OK;
+	}
+
+	switch( pParam->iType ) {
+	case SQLITE_INTEGER:
+		sqlite3_result_int64(context, pParam->pIntegers[pCursor->iRow]);
+		break;
+	case SQLITE_FLOAT:
+		sqlite3_result_double(context, pParam->pFloats[pCursor->iRow]);
+		break;
+	case SQLITE_TEXT:
+		if( pParam->ppStrings[pCursor->iRow] ) {
+			sqlite3_result_text(context, pParam->ppStrings[pCursor->iRow], -1, SQLITE_STATIC);
+		} else {
+			sqlite3_result_null(context);
+		}
+		break;
+	}
+
+	return SQLITE_OK;
+
+}
+
+static int ArrayRowid(sqlite3_vtab_cursor* pBase, sqlite_int64* pRowid)
+{
+	*pRowid = ((ArrayCursor*)pBase)->iRow + 1;
+	return SQLITE_OK;
+}
+
+// Only usable when the pointer argument is given, a scan without it would always be empty
+static int ArrayBestIndex(sqlite3_vtab* pVtab, sqlite3_index_info* pInfo)
+{
+
+	for( int i = 0; i < pInfo->nConstraint; i++ ) {
+
+		const sqlite3_index_info::sqlite3_index_constraint& constraint = pInfo->aConstraint[i];
+
+		if( constraint.iColumn == ARRAY_COLUMN_POINTER && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ ) {
+
+			if( !constraint.usable ) return SQLITE_CONSTRAINT;
+
+			pInfo->aConstraintUsage[i].argvIndex = 1;
+			pInfo->aConstraintUsage[i].omit = 1;
+			pInfo->idxNum = 1;
+			pInfo->estimatedCost = 10.0;
+			pInfo->estimatedRows = 100;
+			return SQLITE_OK;
+
+		}
+
+	}
+
+	pInfo->idxNum = 0;
+	pInfo->estimatedCost = 2147483647.0;
+	pInfo->estimatedRows = 2147483647;
+	return SQLITE_OK;
+
+}
+
+static sqlite3_module s_ArrayModule = {
+	0,					// iVersion
+	NULL,				// xCreate, NULL makes the table eponymous only
+	ArrayConnect,
+	ArrayBestIndex,
+	ArrayDisconnect,
+	NULL,				// xDestroy
+	ArrayOpen,
+	ArrayClose,
+	ArrayFilter,
+	ArrayNext,
+	ArrayEof,
+	ArrayColumn,
+	ArrayRowid,
+};
+
+int RegisterArray(sqlite3* db)
+{
+	if( !db ) return SQLITE_ERROR;
+	return sqlite3_create_module_v2(db, ARRAY_MODULE_NAME, &s_ArrayModule, NULL, NULL);
+}
@@ -0,0 +1,241 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "backup.h"
+#include "database.h"
+
+#define VALIDATE_BACKUP(ret) if( !this->m_pBackup ) { return ret; }
+
+// A step returning one of these is worth retrying later, anything else besides SQLITE_OK ends the backup
+#define BACKUP_RETRYABLE(rc) ( (rc) == SQLITE_OK || (rc) == SQLITE_BUSY || (rc) == SQLITE_LOCKED )
+
+CBackup* CBackup::s_pFirstLive = NULL;
+
+CBackup::CBackup(sqlite3_backup* backup, sqlite3* source, sqlite3* destination, bool ownsDestination, int pagesPerStep)
+{
+	ASSERT( backup != NULL );
+	this->m_pBackup = backup;
+	this->m_pSource = source;
+	this->m_pDestination = destination;
+	this->m_bOwnsDestination = ownsDestination;
+	this->m_pDestinationDatabase = NULL;
+	this->m_iPagesPerStep = ( pagesPerStep != 0 ) ? pagesPerStep : -1;
+	this->m_iLastResult = SQLITE_OK;
+	this->m_iRemaining = 0;
+	this->m_iPageCount = 0;
+	this->m_bStopThread = false;
+	this->m_iSleepMs = 0;
+	this->m_pPrevLive = NULL;
+	this->m_pNextLive = s_pFirstLive;
+	if( s_pFirstLive ) s_pFirstLive->m_pPrevLive = this;
+	s_pFirstLive = this;
+}
+
+CBackup::~CBackup(void)
+{
+	this->finish();
+	if( this->m_pPrevLive ) {
+		this->m_pPrevLive->m_pNextLive = this->m_pNextLive;
+	} else {
+		s_pFirstLive = this->m_pNextLive;
+	}
+	if( this->m_pNextLive ) this->m_pNextLive->m_pPrevLive = this->m_pPrevLive;
+}
+
+// The objects stay around until Lua collects them, finishing twice is harmless
+void CBackup::finishAll(void)
+{
+	for( CBackup* pBackup = s_pFirstLive; pBackup; pBackup = pBackup->m_pNextLive ) {
+		pBackup->finish();
+	}
+}
+
+
+int CBackup::create(CBackup** backup, sqlite3* destination, const char* destinationName, sqlite3* source, const char* sourceName, bool ownsDestination, int pagesPerStep)
+{
+
+	if( !backup || !destination || !source ) return SQLITE_ERROR;
+
+	*backup = NULL;
+
+	sqlite3_backup* pBackup = sqlite3_backup_init(destination, destinationName, source, sourceName);
+
+	// Errors are reported on the destination connection
+	if( !pBackup ) {
+		int retcode = sqlite3_errcode(destination);
+		if( ownsDestination ) sqlite3_close(destination);
+		return ( retcode != SQLITE_OK ) ? retcode : SQLITE_ERROR;
+	}
+
+	*backup = new CBackup(pBackup, source, destination, ownsDestination, pagesPerStep);
+	return SQLITE_OK;
+
+}
+
+
+int CBackup::stepLocked(int pages)
+{
+
+	VALIDATE_BACKUP(this->m_iLastResult);
+
+	if( !BACKUP_RETRYABLE(this->m_iLastResult) ) {
+		return this->m_iLastResult;
+	}
+
+	this->m_iLastResult = sqlite3_backup_step(this->m_pBackup, pages);
+	this->m_iRemaining = sqlite3_backup_remaining(this->m_pBackup);
+	this->m_iPageCount = sqlite3_backup_pagecount(this->m_pBackup);
+
+	return this->m_iLastResult;
+
+}
+
+int CBackup::step(void)
+{
+	return this->step(this->m_iPagesPerStep);
+}
+
+// In background mode the thread does the stepping, so this only reports progress
+int CBackup::step(int pages)
+{
+	CAutoLock lock(&this->m_Mutex);
+	if( this->m_Thread.isRunning() ) {
+		return this->m_iLastResult;
+	}
+	return this->stepLocked(pages);
+}
+
+int CBackup::finish(void)
+{
+
+	this->m_bStopThread = true;
+	this->m_Thread.join();
+
+	VALIDATE_BACKUP(SQLITE_ERROR);
+
+	int retcode = sqlite3_backup_finish(this->m_pBackup);
+	this->m_pBackup = NULL;
+
+	if( this->m_pDestinationDatabase ) {
+		this->m_pDestinationDatabase->endIncoming();
+		this->m_pDestinationDatabase = NULL;
+	}
+
+	if( this->m_bOwnsDestination && this->m_pDestination ) {
+		sqlite3_close(this->m_pDestination);
+	}
+	this->m_pDestination = NULL;
+	this->m_pSource = NULL;
+
+	return retcode;
+
+}
+
+
+bool CBackup::isDone(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return ( this->m_iLastResult == SQLITE_DONE );
+}
+
+bool CBackup::isThreaded(void)
+{
+	return this->m_Thread.isRunning();
+}
+
+
+int CBackup::getRemaining(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_iRemaining;
+}
+
+int CBackup::getPageCount(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_iPageCount;
+}
+
+int CBackup::getLastResult(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_iLastResult;
+}
+
+
+sqlite3* CBackup::getDestination(void)
+{
+	return this->m_pDestination;
+}
+
+void CBackup::setDestinationDatabase(CDatabase* database)
+{
+	if( this->m_pDestinationDatabase || !this->m_pBackup ) return;
+	this->m_pDestinationDatabase = database;
+	database->beginIncoming();
+}
+
+// Called by a database as it closes, the backups writing into it can't reach it after that
+void CBackup::forgetDestination(CDatabase* database)
+{
+	for( CBackup* pBackup = s_pFirstLive; pBackup; pBackup = pBackup->m_pNextLive ) {
+		if( pBackup->m_pDestinationDatabase == database ) pBackup->m_pDestinationDatabase = NULL;
+	}
+}
+
+
+void CBackup::threadMain(void* usrPtr)
+{
+
+	CBackup* pBackup = (CBackup*)usrPtr;
+
+	while( !pBackup->m_bStopThread ) {
+
+		pBackup->m_Mutex.lock();
+		int retcode = pBackup->stepLocked(pBackup->m_iPagesPerStep);
+		pBackup->m_Mutex.unlock();
+
+		if( !BACKUP_RETRYABLE(retcode) ) break;
+
+		// Sleeping between steps lets the game thread get at the source database
+		ThreadSleep(pBackup->m_iSleepMs);
+
+	}
+
+}
+
+// Stepping from another thread needs the source connection to be serialized
+int CBackup::startThread(int sleepMs)
+{
+
+	VALIDATE_BACKUP(SQLITE_ERROR);
+
+	if( this->m_Thread.isRunning() ) return SQLITE_MISUSE;
+
+	// Connections opened with SQLITE_OPEN_NOMUTEX (or a single threaded build) have no mutex
+	if( sqlite3_threadsafe() == 0 || !sqlite3_db_mutex(this->m_pSource) ) return SQLITE_MISUSE;
+
+	this->m_iSleepMs = ( sleepMs > 0 ) ? sleepMs : 1;
+	this->m_bStopThread = false;
+
+	return this->m_Thread.start(CBackup::threadMain, this) ? SQLITE_OK : SQLITE_ERROR;
+
+}
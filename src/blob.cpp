@@ -0,0 +1,116 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "blob.h"
+#include "database.h"
+#include "querycache.h"
+
+#define VALIDATE_BLOB(ret) if( !this->m_pBlob ) { return ret; }
+
+CBlob::CBlob(sqlite3_blob* blob, CDatabase* owner, const char* table)
+{
+	ASSERT( blob != NULL );
+	this->m_pBlob = blob;
+	this->m_pOwner = NULL;
+	this->m_pPrevBlob = NULL;
+	this->m_pNextBlob = NULL;
+	this->m_pszTable = NULL;
+	this->m_pBuffer = NULL;
+	this->m_iBufferSize = 0;
+	if( owner ) {
+		this->m_pszTable = table ? sqlite3_mprintf("%s", table) : NULL;
+		owner->trackBlob(this);
+	}
+}
+
+CBlob::~CBlob(void)
+{
+	this->close();
+	sqlite3_free(this->m_pszTable);
+	if( this->m_pBuffer ) {
+		delete[] this->m_pBuffer;
+		this->m_pBuffer = NULL;
+	}
+}
+
+int CBlob::close(void)
+{
+	if( this->m_pOwner ) this->m_pOwner->untrackBlob(this);
+	VALIDATE_BLOB(SQLITE_ERROR);
+	int retcode = sqlite3_blob_close(this->m_pBlob);
+	this->m_pBlob = NULL;
+	return retcode;
+}
+
+
+bool CBlob::isOpen(void)
+{
+	return ( this->m_pBlob != NULL );
+}
+
+
+int CBlob::getSize(void)
+{
+	VALIDATE_BLOB(0);
+	return sqlite3_blob_bytes(this->m_pBlob);
+}
+
+
+int CBlob::read(void* buffer, int length, int offset)
+{
+	VALIDATE_BLOB(SQLITE_ERROR);
+	return sqlite3_blob_read(this->m_pBlob, buffer, length, offset);
+}
+
+int CBlob::write(const void* data, int length, int offset)
+{
+	VALIDATE_BLOB(SQLITE_ERROR);
+	int retcode = sqlite3_blob_write(this->m_pBlob, data, length, offset);
+	CQueryCache* pCache = this->m_pOwner ? this->m_pOwner->getResultCache() : NULL;
+	if( retcode == SQLITE_OK && pCache ) pCache->tableWritten(this->m_pszTable ? this->m_pszTable : "*");
+	return retcode;
+}
+
+
+int CBlob::reopen(sqlite3_int64 rowid)
+{
+	VALIDATE_BLOB(SQLITE_ERROR);
+	return sqlite3_blob_reopen(this->m_pBlob, rowid);
+}
+
+
+char* CBlob::getBuffer(int size)
+{
+
+	if( size > this->m_iBufferSize ) {
+
+		if( this->m_pBuffer ) {
+			delete[] this->m_pBuffer;
+		}
+
+		this->m_pBuffer = new char[size];
+		this->m_iBufferSize = this->m_pBuffer ? size : 0;
+
+	}
+
+	return this->m_pBuffer;
+
+}
@@ -0,0 +1,240 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "checkpoint.h"
+
+// Longest the thread sleeps before looking at m_bStopThread again
+#define CHECKPOINT_SLEEP_SLICE 50
+
+// A WAL file is a 32 byte header followed by frames of a 24 byte header plus one page
+#define WAL_HEADER_SIZE 32
+#define WAL_FRAME_HEADER_SIZE 24
+
+CCheckpointer::CCheckpointer(sqlite3* connection, int pageSize, int intervalMs, int idleMs)
+{
+	this->m_pConnection = connection;
+	this->m_iPageSize = pageSize;
+	this->m_iIntervalMs = ( intervalMs > 0 ) ? intervalMs : 1;
+	this->m_iIdleMs = idleMs;
+	this->m_bStopThread = false;
+	this->m_bDirty = false;
+	this->m_dLastCommit = GetTimeMilliseconds();
+	this->m_iWalFrames = 0;
+	this->m_iFramesBehind = 0;
+	this->m_iLastResult = SQLITE_OK;
+	this->m_dLastDuration = 0.0;
+	this->m_dMaxDuration = 0.0;
+	this->m_iNumCheckpoints = 0;
+	this->m_iNumTruncates = 0;
+}
+
+CCheckpointer::~CCheckpointer(void)
+{
+	this->stop();
+	if( this->m_pConnection ) {
+		sqlite3_close(this->m_pConnection);
+		this->m_pConnection = NULL;
+	}
+}
+
+
+int CCheckpointer::create(CCheckpointer** checkpointer, const char* fileName, int intervalMs, int idleMs)
+{
+
+	if( !checkpointer || !fileName || !*fileName ) return SQLITE_ERROR;
+
+	*checkpointer = NULL;
+
+	if( sqlite3_threadsafe() == 0 ) return SQLITE_MISUSE;
+
+	sqlite3* pConnection = NULL;
+	int retcode = sqlite3_open_v2(fileName, &pConnection, SQLITE_OPEN_READWRITE | SQLITE_OPEN_FULLMUTEX, NULL);
+
+	if( retcode != SQLITE_OK ) {
+		sqlite3_close(pConnection);
+		return retcode;
+	}
+
+	// Only the background thread ever waits on this
+	sqlite3_busy_timeout(pConnection, 100);
+
+	int pageSize = 0;
+	sqlite3_stmt* pStmt = NULL;
+
+	if( sqlite3_prepare_v2(pConnection, "PRAGMA page_size;", -1, &pStmt, NULL) == SQLITE_OK && sqlite3_step(pStmt) == SQLITE_ROW ) {
+		pageSize = sqlite3_column_int(pStmt, 0);
+	}
+	sqlite3_finalize(pStmt);
+
+	// The connection only opens the WAL once it has read something, until then a checkpoint reports -1 frames
+	sqlite3_exec(pConnection, "SELECT 1 FROM sqlite_master LIMIT 1;", NULL, NULL, NULL);
+
+	*checkpointer = new CCheckpointer(pConnection, pageSize, intervalMs, idleMs);
+	return SQLITE_OK;
+
+}
+
+
+int CCheckpointer::start(void)
+{
+	if( !this->m_pConnection ) return SQLITE_ERROR;
+	if( this->m_Thread.isRunning() ) return SQLITE_MISUSE;
+	this->m_bStopThread = false;
+	return this->m_Thread.start(CCheckpointer::threadMain, this) ? SQLITE_OK : SQLITE_ERROR;
+}
+
+void CCheckpointer::stop(void)
+{
+	this->m_bStopThread = true;
+	this->m_Thread.join();
+}
+
+bool CCheckpointer::isRunning(void)
+{
+	return this->m_Thread.isRunning();
+}
+
+
+// Called from the wal hook on the game thread after every commit
+void CCheckpointer::noteCommit(int walFrames)
+{
+	CAutoLock lock(&this->m_Mutex);
+	this->m_bDirty = true;
+	this->m_dLastCommit = GetTimeMilliseconds();
+	// The WAL starts over from the first frame once a checkpoint has caught up completely
+	if( walFrames < this->m_iWalFrames ) {
+		this->m_iFramesBehind = walFrames;
+	} else {
+		this->m_iFramesBehind += walFrames - this->m_iWalFrames;
+	}
+	this->m_iWalFrames = walFrames;
+}
+
+
+void CCheckpointer::checkpoint(bool idle)
+{
+
+	// PASSIVE never waits on readers or writers, TRUNCATE also resets the WAL file but is only worth it while nothing is writing
+	int mode = idle ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_PASSIVE;
+
+	int logFrames = 0;
+	int checkpointedFrames = 0;
+
+	double started = GetTimeMilliseconds();
+	int retcode = sqlite3_wal_checkpoint_v2(this->m_pConnection, "main", mode, &logFrames, &checkpointedFrames);
+	double duration = GetTimeMilliseconds() - started;
+
+	CAutoLock lock(&this->m_Mutex);
+
+	this->m_iLastResult = retcode;
+	this->m_dLastDuration = duration;
+	if( duration > this->m_dMaxDuration ) this->m_dMaxDuration = duration;
+	this->m_iNumCheckpoints++;
+
+	if( retcode == SQLITE_OK ) {
+		if( mode == SQLITE_CHECKPOINT_TRUNCATE ) this->m_iNumTruncates++;
+		this->m_iWalFrames = logFrames;
+		this->m_iFramesBehind = ( logFrames > checkpointedFrames ) ? logFrames - checkpointedFrames : 0;
+	}
+
+}
+
+void CCheckpointer::threadMain(void* usrPtr)
+{
+
+	CCheckpointer* pCheckpointer = (CCheckpointer*)usrPtr;
+
+	while( !pCheckpointer->m_bStopThread ) {
+
+		for( int slept = 0; slept < pCheckpointer->m_iIntervalMs && !pCheckpointer->m_bStopThread; slept += CHECKPOINT_SLEEP_SLICE ) {
+			int remaining = pCheckpointer->m_iIntervalMs - slept;
+			ThreadSleep( remaining < CHECKPOINT_SLEEP_SLICE ? remaining : CHECKPOINT_SLEEP_SLICE );
+		}
+
+		if( pCheckpointer->m_bStopThread ) break;
+
+		pCheckpointer->m_Mutex.lock();
+		bool dirty = pCheckpointer->m_bDirty;
+		bool idle = ( pCheckpointer->m_iIdleMs > 0 && GetTimeMilliseconds() - pCheckpointer->m_dLastCommit >= pCheckpointer->m_iIdleMs );
+		bool pending = ( pCheckpointer->m_iWalFrames > 0 );
+		pCheckpointer->m_bDirty = false;
+		pCheckpointer->m_Mutex.unlock();
+
+		// Once idle a WAL that has been fully copied back still gets truncated, after that there is nothing to do until the next commit
+		if( dirty || ( idle && pending ) ) {
+			pCheckpointer->checkpoint(idle);
+		}
+
+	}
+
+}
+
+
+int CCheckpointer::getWalFrames(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_iWalFrames;
+}
+
+// Estimated from the frame count, the file itself is only shrunk by a TRUNCATE checkpoint
+sqlite3_int64 CCheckpointer::getWalSize(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	if( this->m_iWalFrames < 1 ) return 0;
+	return WAL_HEADER_SIZE + (sqlite3_int64)this->m_iWalFrames * ( WAL_FRAME_HEADER_SIZE + this->m_iPageSize );
+}
+
+// Frames in the WAL that have not been copied back into the database yet
+int CCheckpointer::getFramesBehind(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_iFramesBehind;
+}
+
+int CCheckpointer::getLastResult(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_iLastResult;
+}
+
+double CCheckpointer::getLastDuration(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_dLastDuration;
+}
+
+double CCheckpointer::getMaxDuration(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_dMaxDuration;
+}
+
+int CCheckpointer::getNumCheckpoints(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_iNumCheckpoints;
+}
+
+int CCheckpointer::getNumTruncates(void)
+{
+	CAutoLock lock(&this->m_Mutex);
+	return this->m_iNumTruncates;
+}
@@ -0,0 +1,415 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "compress.h"
+#include "thread.h"
+
+#ifdef SQLITE_INNOCUOUS
+#define COMPRESS_FUNCTION_FLAGS ( SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS )
+#else
+#define COMPRESS_FUNCTION_FLAGS ( SQLITE_UTF8 | SQLITE_DETERMINISTIC )
+#endif
+
+#define LZ_MIN_MATCH		4
+#define LZ_MAX_OFFSET		65535
+#define LZ_HASH_BITS		12
+#define LZ_LAST_LITERALS	5	// the block always ends in at least this many literals
+#define LZ_MATCH_LIMIT		12	// no match may start within this many bytes of the end
+
+static CompressionStats s_Stats;
+static CMutex s_StatsMutex;
+
+//-----------------------------------------------------------------------------
+// Block codec
+//-----------------------------------------------------------------------------
+
+static inline unsigned int ReadU32(const unsigned char* p)
+{
+	unsigned int value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline int HashU32(unsigned int value)
+{
+	return (int)( ( value * 2654435761U ) >> ( 32 - LZ_HASH_BITS ) );
+}
+
+// Lengths past the 4 bits in the token continue in bytes of 255
+static inline unsigned char* WriteLength(unsigned char* op, int length)
+{
+	while( length >= 255 ) {
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = (unsigned char)length;
+	return op;
+}
+
+// Writes the literals, then the match if there is one, returns NULL if they do not fit before opEnd
+static unsigned char* WriteSequence(unsigned char* op, unsigned char* opEnd, const unsigned char* literals, int numLiterals, int offset, int matchLength)
+{
+
+	if( op + 1 + numLiterals / 255 + 1 + numLiterals + 2 + matchLength / 255 + 1 > opEnd ) return NULL;
+
+	int matchCode = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+	unsigned char* pToken = op++;
+
+	*pToken = (unsigned char)( ( ( numLiterals < 15 ? numLiterals : 15 ) << 4 ) | ( matchCode < 15 ? matchCode : 15 ) );
+
+	if( numLiterals >= 15 ) op = WriteLength(op, numLiterals - 15);
+	memcpy(op, literals, numLiterals);
+	op += numLiterals;
+
+	if( matchLength ) {
+		*op++ = (unsigned char)( offset & 0xFF );
+		*op++ = (unsigned char)( offset >> 8 );
+		if( matchCode >= 15 ) op = WriteLength(op, matchCode - 15);
+	}
+
+	return op;
+
+}
+
+// Returns the compressed size, or 0 if it would not be smaller than capacity
+static int CompressBlock(const unsigned char* src, int length, unsigned char* dst, int capacity)
+{
+
+	int table[1 << LZ_HASH_BITS];
+	memset(table, 0, sizeof(table));
+
+	unsigned char* op = dst;
+	unsigned char* opEnd = dst + capacity;
+
+	int anchor = 0;
+	int ip = 0;
+	int limit = length - LZ_MATCH_LIMIT;
+	int misses = 0;
+
+	while( ip < limit ) {
+
+		unsigned int sequence = ReadU32(src + ip);
+		int hash = HashU32(sequence);
+
+		// Positions are stored one up so zero can mean empty
+		int ref = table[hash] - 1;
+		table[hash] = ip + 1;
+
+		if( ref < 0 || ip - ref > LZ_MAX_OFFSET || ReadU32(src + ref) != sequence ) {
+			// Incompressible runs are skipped over faster the longer they go on
+			ip += 1 + ( misses++ >> 6 );
+			continue;
+		}
+
+		int matchLength = LZ_MIN_MATCH;
+		int maxLength = length - LZ_LAST_LITERALS - ip;
+		while( matchLength < maxLength && src[ref + matchLength] == src[ip + matchLength] ) matchLength++;
+
+		op = WriteSequence(op, opEnd, src + anchor, ip - anchor, ip - ref, matchLength);
+		if( !op ) return 0;
+
+		ip += matchLength;
+		anchor = ip;
+		misses = 0;
+
+	}
+
+	op = WriteSequence(op, opEnd, src + anchor, length - anchor, 0, 0);
+	if( !op ) return 0;
+
+	return (int)( op - dst );
+
+}
+
+// Returns false unless the block decodes to exactly length bytes
+static bool DecompressBlock(const unsigned char* src, int srcLength, unsigned char* dst, int length)
+{
+
+	const unsigned char* ip = src;
+	const unsigned char* ipEnd = src + srcLength;
+	unsigned char* op = dst;
+	unsigned char* opEnd = dst + length;
+
+	while( ip < ipEnd ) {
+
+		int token = *ip++;
+
+		// Lengths are checked against what is left as they grow, so a long run of 255s can't overflow them
+		int numLiterals = token >> 4;
+		if( numLiterals == 15 ) {
+			int extra = 255;
+			while( extra == 255 ) {
+				if( ip >= ipEnd ) return false;
+				extra = *ip++;
+				numLiterals += extra;
+				if( numLiterals > ipEnd - ip ) return false;
+			}
+		}
+
+		if( numLiterals > ipEnd - ip || numLiterals > opEnd - op ) return false;
+		memcpy(op, ip, numLiterals);
+		ip += numLiterals;
+		op += numLiterals;
+
+		// The last sequence has no match
+		if( ip == ipEnd ) break;
+
+		if( ipEnd - ip < 2 ) return false;
+		int offset = ip[0] | ( ip[1] << 8 );
+		ip += 2;
+
+		if( offset == 0 || offset > op - dst ) return false;
+
+		int matchLength = ( token & 0x0F ) + LZ_MIN_MATCH;
+		if( ( token & 0x0F ) == 15 ) {
+			int extra = 255;
+			while( extra == 255 ) {
+				if( ip >= ipEnd ) return false;
+				extra = *ip++;
+				matchLength += extra;
+				if( matchLength > opEnd - op ) return false;
+			}
+		}
+
+		if( matchLength > opEnd - op ) return false;
+
+		// Matches may overlap what they write, so they are copied a byte at a time
+		const unsigned char* ref = op - offset;
+		for( int i = 0; i < matchLength; i++ ) op[i] = ref[i];
+		op += matchLength;
+
+	}
+
+	return ( op == opEnd );
+
+}
+
+//-----------------------------------------------------------------------------
+// Value format
+//-----------------------------------------------------------------------------
+
+static void AddStats(bool compressed, sqlite3_int64 bytesIn, sqlite3_int64 bytesOut, double ms)
+{
+
+	CAutoLock lock(&s_StatsMutex);
+
+	if( compressed ) {
+		s_Stats.iCompressed++;
+		s_Stats.iBytesIn += bytesIn;
+		s_Stats.iBytesOut += bytesOut;
+		s_Stats.dCompressMs += ms;
+	} else {
+		s_Stats.iDecompressed++;
+		s_Stats.dDecompressMs += ms;
+	}
+
+}
+
+int CompressBound(int length)
+{
+	return COMPRESS_MAX_HEADER + length;
+}
+
+int CompressValue(const void* data, int length, bool isText, unsigned char* out)
+{
+
+	double started = GetTimeMilliseconds();
+
+	unsigned char* op = out + 1;
+
+	unsigned int size = (unsigned int)length;
+	while( size >= 0x80 ) {
+		*op++ = (unsigned char)( 0x80 | ( size & 0x7F ) );
+		size >>= 7;
+	}
+	*op++ = (unsigned char)size;
+
+	int headerLength = (int)( op - out );
+	int payloadLength = CompressBlock((const unsigned char*)data, length, op, length);
+
+	out[0] = COMPRESS_MAGIC | ( isText ? COMPRESS_FLAG_TEXT : 0 );
+
+	if( payloadLength > 0 ) {
+		out[0] |= COMPRESS_FLAG_LZ;
+	} else {
+		memcpy(op, data, length);
+		payloadLength = length;
+	}
+
+	AddStats(true, length, headerLength + payloadLength, GetTimeMilliseconds() - started);
+
+	return headerLength + payloadLength;
+
+}
+
+// Returns the header length, or 0 if data does not start with one
+static int ReadHeader(const unsigned char* data, int length, int* originalLength, int* flags)
+{
+
+	if( length < 2 || ( data[0] & 0xF0 ) != COMPRESS_MAGIC ) return 0;
+
+	unsigned int size = 0;
+	int i = 1;
+
+	for( int shift = 0; ; shift += 7 ) {
+		if( i >= length || i >= COMPRESS_MAX_HEADER ) return 0;
+		size |= (unsigned int)( data[i] & 0x7F ) << shift;
+		if( !( data[i++] & 0x80 ) ) break;
+	}
+
+	if( size > 0x7FFFFFFF ) return 0;
+
+	// A token can not expand to more than 255 bytes per input byte, which stops a forged size from allocating gigabytes
+	sqlite3_int64 payloadLength = length - i;
+	if( ( data[0] & COMPRESS_FLAG_LZ ) ? (sqlite3_int64)size > payloadLength * 255 : (sqlite3_int64)size != payloadLength ) return 0;
+
+	*originalLength = (int)size;
+	*flags = data[0] & 0x0F;
+	return i;
+
+}
+
+bool CompressedInfo(const void* data, int length, int* originalLength, bool* isText)
+{
+	int flags = 0;
+	if( !data || !ReadHeader((const unsigned char*)data, length, originalLength, &flags) ) return false;
+	if( isText ) *isText = ( flags & COMPRESS_FLAG_TEXT ) != 0;
+	return true;
+}
+
+bool DecompressValue(const void* data, int length, unsigned char* out)
+{
+
+	int originalLength = 0;
+	int flags = 0;
+	int headerLength = ReadHeader((const unsigned char*)data, length, &originalLength, &flags);
+
+	if( !headerLength ) return false;
+
+	const unsigned char* pPayload = (const unsigned char*)data + headerLength;
+	int payloadLength = length - headerLength;
+
+	double started = GetTimeMilliseconds();
+	bool valid = false;
+
+	if( flags & COMPRESS_FLAG_LZ ) {
+		valid = DecompressBlock(pPayload, payloadLength, out, originalLength);
+	} else if( payloadLength == originalLength ) {
+		memcpy(out, pPayload, payloadLength);
+		valid = true;
+	}
+
+	AddStats(false, 0, 0, GetTimeMilliseconds() - started);
+
+	return valid;
+
+}
+
+//-----------------------------------------------------------------------------
+// SQL functions
+//-----------------------------------------------------------------------------
+
+
+static void SqlCompress(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+
+	int type = sqlite3_value_type(argv[0]);
+
+	if( type != SQLITE_TEXT && type != SQLITE_BLOB ) {
+		sqlite3_result_value(context, argv[0]);
+		return;
+	}
+
+	const void* pData = ( type == SQLITE_TEXT ) ? (const void*)sqlite3_value_text(argv[0]) : sqlite3_value_blob(argv[0]);
+	int length = sqlite3_value_bytes(argv[0]);
+
+	unsigned char* pOut = (unsigned char*)sqlite3_malloc(CompressBound(length));
+	if( !pOut ) {
+		sqlite3_result_error_nomem(context);
+		return;
+	}
+
+	int outLength = CompressValue(pData, length, type == SQLITE_TEXT, pOut);
+	sqlite3_result_blob(context, pOut, outLength, sqlite3_free);
+
+}
+
+static void SqlDecompress(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+
+	if( sqlite3_value_type(argv[0]) != SQLITE_BLOB ) {
+		sqlite3_result_value(context, argv[0]);
+		return;
+	}
+
+	const void* pData = sqlite3_value_blob(argv[0]);
+	int length = sqlite3_value_bytes(argv[0]);
+
+	int originalLength = 0;
+	bool isText = false;
+
+	if( !CompressedInfo(pData, length, &originalLength, &isText) ) {
+		sqlite3_result_value(context, argv[0]);
+		return;
+	}
+
+	unsigned char* pOut = (unsigned char*)sqlite3_malloc(originalLength > 0 ? originalLength : 1);
+	if( !pOut ) {
+		sqlite3_result_error_nomem(context);
+		return;
+	}
+
+	// Corrupt values come back untouched, the same as the Lua side decoders do
+	if( !DecompressValue(pData, length, pOut) ) {
+		sqlite3_free(pOut);
+		sqlite3_result_value(context, argv[0]);
+		return;
+	}
+
+	if( isText ) {
+		sqlite3_result_text(context, (const char*)pOut, originalLength, sqlite3_free);
+	} else {
+		sqlite3_result_blob(context, pOut, originalLength, sqlite3_free);
+	}
+
+}
+
+int RegisterCompression(sqlite3* db)
+{
+
+	if( !db ) return SQLITE_ERROR;
+
+	int retcode = sqlite3_create_function_v2(db, "compress", 1, COMPRESS_FUNCTION_FLAGS, NULL, SqlCompress, NULL, NULL, NULL);
+	if( retcode != SQLITE_OK ) return retcode;
+
+	return sqlite3_create_function_v2(db, "decompress", 1, COMPRESS_FUNCTION_FLAGS, NULL, SqlDecompress, NULL, NULL, NULL);
+
+}
+
+void GetCompressionStats(CompressionStats* stats, bool reset)
+{
+
+	CAutoLock lock(&s_StatsMutex);
+
+	if( stats ) *stats = s_Stats;
+	if( reset ) memset(&s_Stats, 0, sizeof(s_Stats));
+
+}
@@ -0,0 +1,186 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+static GlobalConfig s_Config;
+
+static void* s_pPageCache = NULL;
+static void* s_pHeap = NULL;
+
+GlobalConfig::GlobalConfig(void)
+{
+	this->iThreading = 0;
+	this->iMemStatus = -1;
+	this->iPageCacheSize = 0;
+	this->iPageCacheCount = 0;
+	this->iLookasideSize = 0;
+	this->iLookasideCount = 0;
+	this->iHeapMB = 0;
+	this->iHeapMinAlloc = 0;
+	this->iThreadingResult = SQLITE_OK;
+	this->iMemStatusResult = SQLITE_OK;
+	this->iPageCacheResult = SQLITE_OK;
+	this->iLookasideResult = SQLITE_OK;
+	this->iHeapResult = SQLITE_OK;
+}
+
+// One "key value" pair per line, anything after // or # is ignored
+bool ReadGlobalConfig(const char* fileName, GlobalConfig* config)
+{
+
+	FILE* pFile = fopen(fileName, "r");
+	if( !pFile ) return false;
+
+	char line[256];
+
+	while( fgets(line, sizeof(line), pFile) ) {
+
+		char* pComment = strstr(line, "//");
+		if( pComment ) *pComment = '\0';
+		pComment = strchr(line, '#');
+		if( pComment ) *pComment = '\0';
+
+		char key[64];
+		char value[64];
+
+		if( sscanf(line, "%63s %63s", key, value) != 2 ) continue;
+
+		if( stricmp(key, "threading") == 0 ) {
+			if( stricmp(value, "single") == 0 ) {
+				config->iThreading = SQLITE_CONFIG_SINGLETHREAD;
+			} else if( stricmp(value, "multi") == 0 ) {
+				config->iThreading = SQLITE_CONFIG_MULTITHREAD;
+			} else if( stricmp(value, "serialized") == 0 ) {
+				config->iThreading = SQLITE_CONFIG_SERIALIZED;
+			} else {
+				Msg("gm_sqlite3: unknown threading mode '%s'\n", value);
+			}
+		} else if( stricmp(key, "memstatus") == 0 ) {
+			config->iMemStatus = atoi(value) ? 1 : 0;
+		} else if( stricmp(key, "pagecache_size") == 0 ) {
+			config->iPageCacheSize = atoi(value);
+		} else if( stricmp(key, "pagecache_count") == 0 ) {
+			config->iPageCacheCount = atoi(value);
+		} else if( stricmp(key, "lookaside_size") == 0 ) {
+			config->iLookasideSize = atoi(value);
+		} else if( stricmp(key, "lookaside_count") == 0 ) {
+			config->iLookasideCount = atoi(value);
+		} else if( stricmp(key, "heap_mb") == 0 ) {
+			config->iHeapMB = atoi(value);
+			if( config->iHeapMB < 0 ) {
+				Msg("gm_sqlite3: heap_mb can't be negative\n");
+				config->iHeapMB = 0;
+			}
+		} else if( stricmp(key, "heap_min_alloc") == 0 ) {
+			config->iHeapMinAlloc = atoi(value);
+		} else {
+			Msg("gm_sqlite3: unknown setting '%s'\n", key);
+		}
+
+	}
+
+	fclose(pFile);
+	return true;
+
+}
+
+void ApplyGlobalConfig(GlobalConfig* config)
+{
+
+	if( config->iThreading ) {
+		config->iThreadingResult = sqlite3_config(config->iThreading);
+	}
+
+	// Turning this off skips a mutex on every allocation, but the memory statistics will read zero
+	if( config->iMemStatus >= 0 ) {
+		config->iMemStatusResult = sqlite3_config(SQLITE_CONFIG_MEMSTATUS, config->iMemStatus);
+	}
+
+	if( config->iPageCacheSize > 0 && config->iPageCacheCount > 0 ) {
+		s_pPageCache = malloc((size_t)config->iPageCacheSize * config->iPageCacheCount);
+		if( s_pPageCache ) {
+			config->iPageCacheResult = sqlite3_config(SQLITE_CONFIG_PAGECACHE, s_pPageCache, config->iPageCacheSize, config->iPageCacheCount);
+		} else {
+			config->iPageCacheResult = SQLITE_NOMEM;
+		}
+	}
+
+	if( config->iLookasideSize > 0 && config->iLookasideCount > 0 ) {
+		config->iLookasideResult = sqlite3_config(SQLITE_CONFIG_LOOKASIDE, config->iLookasideSize, config->iLookasideCount);
+	}
+
+	// Only works when SQLite was built with SQLITE_ENABLE_MEMSYS5, otherwise the default allocator stays
+	// SQLITE_CONFIG_HEAP takes the size as an int, so the arena has to stay under 2 GiB
+	if( config->iHeapMB > 0 ) {
+		sqlite3_int64 size = (sqlite3_int64)config->iHeapMB * 1024 * 1024;
+		if( size > INT_MAX ) {
+			config->iHeapResult = SQLITE_RANGE;
+		} else {
+			s_pHeap = malloc((size_t)size);
+			if( s_pHeap ) {
+				config->iHeapResult = sqlite3_config(SQLITE_CONFIG_HEAP, s_pHeap, (int)size, config->iHeapMinAlloc > 0 ? config->iHeapMinAlloc : 64);
+			} else {
+				config->iHeapResult = SQLITE_NOMEM;
+			}
+		}
+	}
+
+	if( config->iThreadingResult != SQLITE_OK ) Msg("gm_sqlite3: failed to set threading mode (%d)\n", config->iThreadingResult);
+	if( config->iMemStatusResult != SQLITE_OK ) Msg("gm_sqlite3: failed to set memstatus (%d)\n", config->iMemStatusResult);
+	if( config->iPageCacheResult != SQLITE_OK ) Msg("gm_sqlite3: failed to set up page cache (%d)\n", config->iPageCacheResult);
+	if( config->iLookasideResult != SQLITE_OK ) Msg("gm_sqlite3: failed to set up lookaside (%d)\n", config->iLookasideResult);
+	if( config->iHeapResult != SQLITE_OK ) Msg("gm_sqlite3: failed to set up heap (%d)\n", config->iHeapResult);
+
+	// Buffers SQLite refused aren't needed
+	if( config->iPageCacheResult != SQLITE_OK && s_pPageCache ) {
+		free(s_pPageCache);
+		s_pPageCache = NULL;
+	}
+	if( config->iHeapResult != SQLITE_OK && s_pHeap ) {
+		free(s_pHeap);
+		s_pHeap = NULL;
+	}
+
+	s_Config = *config;
+
+}
+
+void ReleaseGlobalConfig(void)
+{
+	if( s_pPageCache ) {
+		free(s_pPageCache);
+		s_pPageCache = NULL;
+	}
+	if( s_pHeap ) {
+		free(s_pHeap);
+		s_pHeap = NULL;
+	}
+}
+
+const GlobalConfig* GetGlobalConfig(void)
+{
+	return &s_Config;
+}
@@ -1,136 +1,1757 @@
-/*
-
-    Gm_sqlite3 the improved sqlite library for Garry's Mod
-    Copyright (C) 2010 James John Kelly Jr
-
-	This library is free software; you can redistribute it and/or
-	modify it under the terms of the GNU Lesser General Public
-	License as published by the Free Software Foundation; either
-	version 2.1 of the License, or (at your option) any later version.
-
-	This library is distributed in the hope that it will be useful,
-	but WITHOUT ANY WARRANTY; without even the implied warranty of
-	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-	Lesser General Public License for more details.
-
-	You should have received a copy of the GNU Lesser General Public
-	License along with this library; if not, write to the Free Software
-	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
-
-*/
-
-#include "database.h"
-#include "statement.h"
-
-#define VALIDATE_DATABASE(ret) if( !this->m_pDatabase ) { return ret; }
-
-CDatabase::CDatabase()
-{
-	Msg("CDatabase\n");
-	this->m_pDatabase = NULL;
-}
-
-CDatabase::~CDatabase()
-{
-	this->close();
-}
-
-
-sqlite3* CDatabase::getDatabase(void)
-{
-	return this->m_pDatabase;
-}
-
-
-int CDatabase::open(const char* dbName, int flags, const char* zVfs) {
-	if( this->m_pDatabase ) {
-		return SQLITE_ERROR;
-	}
-	return sqlite3_open_v2(dbName, &this->m_pDatabase, flags, zVfs);
-}
-
-int CDatabase::close(void)
-{
-	VALIDATE_DATABASE(SQLITE_ERROR);
-	int retcode = sqlite3_close(this->m_pDatabase);
-	this->m_pDatabase = NULL;
-	return retcode;
-}
-
-
-bool CDatabase::isOpen(void)
-{
-	return ( this->m_pDatabase != NULL );
-}
-
-
-int CDatabase::setExtendedErrors(bool onoff)
-{
-	VALIDATE_DATABASE(SQLITE_ERROR);
-	return sqlite3_extended_result_codes(this->m_pDatabase, onoff);
-}
-
-
-int CDatabase::getErrorCode(void)
-{
-	VALIDATE_DATABASE(SQLITE_ERROR);
-	return sqlite3_errcode(this->m_pDatabase);
-}
-
-const char* CDatabase::getErrorMessage(void)
-{
-	VALIDATE_DATABASE(NULL);
-	return sqlite3_errmsg(this->m_pDatabase);
-}
-
-
-sqlite3_int64 CDatabase::getLastInsertId(void)
-{
-	VALIDATE_DATABASE(0);
-	return sqlite3_last_insert_rowid(this->m_pDatabase);
-}
-
-
-int CDatabase::getChanges(void)
-{
-	VALIDATE_DATABASE(0);
-	return sqlite3_changes(this->m_pDatabase);
-}
-
-int CDatabase::getTotalChanges(void)
-{
-	VALIDATE_DATABASE(0);
-	return sqlite3_total_changes(this->m_pDatabase);
-}
-
-
-int CDatabase::execute(const char* sql, sqlite3_callback callback, void* usrPtr)
-{
-	VALIDATE_DATABASE(SQLITE_ERROR);
-	return sqlite3_exec(this->m_pDatabase, sql, callback, usrPtr, NULL);
-}
-
-int CDatabase::prepare(CStatement** stmt, const char* sql)
-{
-
-	VALIDATE_DATABASE(NULL);
-
-	if( !stmt ) return SQLITE_ERROR;
-
-	if( *stmt ) {
-		(*stmt)->finalize();
-		delete (*stmt);
-	}
-
-	*stmt = NULL;
-	sqlite3_stmt* pStmt = NULL;
-
-	int retcode = sqlite3_prepare_v2(this->m_pDatabase, sql, -1, &pStmt, NULL);
-
-	if( retcode == SQLITE_OK ) {
-		*stmt = new CStatement(retcode, pStmt);
-	}
-
-	return retcode;
-
-}
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "database.h"
+#include "statement.h"
+#include "blob.h"
+#include "backup.h"
+#include "checkpoint.h"
+#include "function.h"
+#include "natives.h"
+#include "compress.h"
+#include "array.h"
+#include "querycache.h"
+#include "thread.h"
+#include <new>
+#include <ctype.h>
+
+#define VALIDATE_DATABASE(ret) if( !this->m_pDatabase ) { return ret; }
+
+// Delay before retrying a deferred write, doubled after every busy attempt
+#define DEFERRED_BACKOFF_MIN 5
+#define DEFERRED_BACKOFF_MAX 1000
+
+// Most deferred writes committed together in one BEGIN IMMEDIATE transaction
+#define DEFERRED_BATCH_MAX 256
+
+// Sleep of the backoff busy handler, doubled on every call for the same lock and then jittered
+#define BUSY_BACKOFF_MIN 1
+#define BUSY_BACKOFF_MAX 100
+
+// How many pages of the in-memory database are written back per tick
+#define SNAPSHOT_PAGES_PER_STEP 256
+
+// Milliseconds between automatic cache releases, the cache needs time to refill before another one can free anything
+#define MEMORY_RELEASE_INTERVAL 1000
+
+//-----------------------------------------------------------------------------
+// DatabaseOptions
+//-----------------------------------------------------------------------------
+
+static const char* s_pszJournalModes[] = { "delete", "truncate", "persist", "memory", "wal", "off", NULL };
+static const char* s_pszSynchronousModes[] = { "off", "normal", "full", "extra", NULL };
+static const char* s_pszTempStores[] = { "default", "file", "memory", NULL };
+
+// Pragma values end up in SQL text, so only known keywords are let through
+static bool IsOneOf(const char* value, const char** list)
+{
+	for( int i = 0; list[i]; i++ ) {
+		if( stricmp(value, list[i]) == 0 ) return true;
+	}
+	return false;
+}
+
+DatabaseOptions::DatabaseOptions(void)
+{
+	this->pszJournal = NULL;
+	this->pszSynchronous = NULL;
+	this->pszTempStore = NULL;
+	this->iCacheMB = -1;
+	this->iMmapMB = -1;
+	this->iBusyTimeout = -1;
+	this->bBusyBackoff = false;
+	this->bBatch = false;
+	this->iMemoryLimitMB = -1;
+	this->bImmutable = false;
+	this->bNoLock = false;
+	this->bMemory = false;
+	this->dSnapshotInterval = 0.0;
+}
+
+bool DatabaseOptions::setPreset(const char* name, int* flags)
+{
+
+	if( stricmp(name, "throughput") == 0 ) {
+		this->pszJournal = "wal";
+		this->pszSynchronous = "normal";
+		this->pszTempStore = "memory";
+		this->iCacheMB = 64;
+		this->iMmapMB = 256;
+		this->iBusyTimeout = 0;
+	} else if( stricmp(name, "durable") == 0 ) {
+		this->pszJournal = "wal";
+		this->pszSynchronous = "full";
+		this->iCacheMB = 16;
+		this->iBusyTimeout = 0;
+	} else if( stricmp(name, "readonly") == 0 ) {
+		this->pszTempStore = "memory";
+		this->iCacheMB = 64;
+		this->iMmapMB = 256;
+		if( flags ) *flags = SQLITE_OPEN_READONLY;
+	} else if( stricmp(name, "shared") == 0 ) {
+		// Several servers on one host writing the same file, WAL keeps readers out of the writers' way
+		this->pszJournal = "wal";
+		this->pszSynchronous = "normal";
+		this->iCacheMB = 16;
+		this->iBusyTimeout = 5000;
+		this->bBusyBackoff = true;
+		this->bBatch = true;
+	} else {
+		return false;
+	}
+
+	return true;
+
+}
+
+// Builds a file: URI so immutable and nolock can be passed along
+static bool BuildUri(const char* fileName, const DatabaseOptions& options, char* uri, int length)
+{
+
+	int pos = 0;
+
+#define URI_APPEND(ch) if( pos >= length - 1 ) { return false; } uri[pos++] = (ch);
+
+	const char* prefix = "file:";
+#if _WIN32
+	// Drive letters need an empty authority
+	if( fileName[0] && fileName[1] == ':' ) prefix = "file:///";
+#endif
+
+	for( const char* p = prefix; *p; p++ ) {
+		URI_APPEND(*p);
+	}
+
+	static const char* hex = "0123456789ABCDEF";
+
+	for( const char* p = fileName; *p; p++ ) {
+		if( *p == '?' || *p == '#' || *p == '%' ) {
+			URI_APPEND('%');
+			URI_APPEND(hex[(*p >> 4) & 0xF]);
+			URI_APPEND(hex[*p & 0xF]);
+		} else if( *p == '\\' ) {
+			URI_APPEND('/');
+		} else {
+			URI_APPEND(*p);
+		}
+	}
+
+	const char* params[2] = { options.bImmutable ? "immutable=1" : NULL, options.bNoLock ? "nolock=1" : NULL };
+	char separator = '?';
+
+	for( int i = 0; i < 2; i++ ) {
+		if( !params[i] ) continue;
+		URI_APPEND(separator);
+		for( const char* p = params[i]; *p; p++ ) {
+			URI_APPEND(*p);
+		}
+		separator = '&';
+	}
+
+#undef URI_APPEND
+
+	uri[pos] = '\0';
+	return true;
+
+}
+
+//-----------------------------------------------------------------------------
+// CDatabase
+//-----------------------------------------------------------------------------
+
+CDatabase* CDatabase::s_pFirstOpen = NULL;
+unsigned int CDatabase::s_iThinkTick = 0;
+
+CPool CDatabase::s_Pool(sizeof(CDatabase), 16);
+
+void* CDatabase::operator new(size_t size)
+{
+	void* ptr = ( size <= s_Pool.getBlockSize() ) ? s_Pool.alloc() : ::operator new(size);
+	if( !ptr ) throw std::bad_alloc();
+	return ptr;
+}
+
+void CDatabase::operator delete(void* ptr, size_t size)
+{
+	if( size <= s_Pool.getBlockSize() ) {
+		s_Pool.free(ptr);
+	} else {
+		::operator delete(ptr);
+	}
+}
+
+CPool* CDatabase::getPool(void)
+{
+	return &s_Pool;
+}
+
+CDatabase::CDatabase()
+{
+	Msg("CDatabase\n");
+	this->m_pDatabase = NULL;
+	this->m_pPrevOpen = NULL;
+	this->m_pNextOpen = NULL;
+	this->m_iThinkTick = 0;
+	this->m_bThinking = false;
+	this->m_pFirstStatement = NULL;
+	this->m_pFirstBlob = NULL;
+	this->m_pCheckpointer = NULL;
+	this->m_pFirstDeferred = NULL;
+	this->m_pLastDeferred = NULL;
+	this->m_iNumQueued = 0;
+	this->m_iBusyTimeout = 0;
+	this->m_dDeferredTimeout = 30000.0;
+	this->m_iNumBusy = 0;
+	this->m_iNumDeferred = 0;
+	this->m_iNumRetried = 0;
+	this->m_iNumAbandoned = 0;
+	this->m_dRetryLatencyTotal = 0.0;
+	this->m_dRetryLatencyMax = 0.0;
+	this->m_pQueueRef = NULL;
+	this->m_bBusyBackoff = false;
+	this->m_bBatching = false;
+	this->m_dBusyStarted = 0.0;
+	this->m_iNumBusyWaits = 0;
+	this->m_iNumLockTimeouts = 0;
+	this->m_dLockWaitTotal = 0.0;
+	this->m_dLockWaitMax = 0.0;
+	this->m_iNumBatches = 0;
+	this->m_iNumBatched = 0;
+	this->m_iNumStatements = 0;
+	this->m_iNumLeakedStatements = 0;
+	this->m_iNumClosedStatements = 0;
+	this->m_pszSnapshotFile = NULL;
+	this->m_dSnapshotInterval = 0.0;
+	this->m_pSnapshot = NULL;
+	this->m_dSnapshotStarted = 0.0;
+	this->m_dLastSnapshot = 0.0;
+	this->m_dLastSnapshotAttempt = 0.0;
+	this->m_dLastSnapshotDuration = 0.0;
+	this->m_iSnapshotChanges = 0;
+	this->m_iSnapshotStartChanges = 0;
+	this->m_iSnapshotVersion = 0;
+	this->m_iSnapshotStartVersion = 0;
+	this->m_iSnapshotResult = SQLITE_OK;
+	this->m_iNumSnapshots = 0;
+	this->m_iNumSnapshotFailures = 0;
+	this->m_iMemoryLimit = 0;
+	this->m_iBytesReclaimed = 0;
+	this->m_iNumEvictions = 0;
+	this->m_iNumReleases = 0;
+	this->m_dLastRelease = 0.0;
+	this->m_pResultCache = NULL;
+	this->m_iNumIncoming = 0;
+	this->m_pSearch = NULL;
+	this->m_pszSearchSql = NULL;
+}
+
+CDatabase::~CDatabase()
+{
+	this->close();
+}
+
+
+void CDatabase::link(void)
+{
+	this->m_pPrevOpen = NULL;
+	this->m_pNextOpen = s_pFirstOpen;
+	if( s_pFirstOpen ) s_pFirstOpen->m_pPrevOpen = this;
+	s_pFirstOpen = this;
+}
+
+void CDatabase::unlink(void)
+{
+	if( this->m_pPrevOpen ) {
+		this->m_pPrevOpen->m_pNextOpen = this->m_pNextOpen;
+	} else if( s_pFirstOpen == this ) {
+		s_pFirstOpen = this->m_pNextOpen;
+	}
+	if( this->m_pNextOpen ) this->m_pNextOpen->m_pPrevOpen = this->m_pPrevOpen;
+	this->m_pPrevOpen = NULL;
+	this->m_pNextOpen = NULL;
+}
+
+
+void CDatabase::trackStatement(CStatement* stmt)
+{
+	stmt->m_pOwner = this;
+	stmt->m_pPrevLive = NULL;
+	stmt->m_pNextLive = this->m_pFirstStatement;
+	if( this->m_pFirstStatement ) this->m_pFirstStatement->m_pPrevLive = stmt;
+	this->m_pFirstStatement = stmt;
+	this->m_iNumStatements++;
+}
+
+void CDatabase::untrackStatement(CStatement* stmt)
+{
+	if( stmt->m_pOwner != this ) return;
+	if( stmt->m_pPrevLive ) {
+		stmt->m_pPrevLive->m_pNextLive = stmt->m_pNextLive;
+	} else {
+		this->m_pFirstStatement = stmt->m_pNextLive;
+	}
+	if( stmt->m_pNextLive ) stmt->m_pNextLive->m_pPrevLive = stmt->m_pPrevLive;
+	stmt->m_pOwner = NULL;
+	stmt->m_pPrevLive = NULL;
+	stmt->m_pNextLive = NULL;
+	this->m_iNumStatements--;
+}
+
+void CDatabase::trackBlob(CBlob* blob)
+{
+	blob->m_pOwner = this;
+	blob->m_pPrevBlob = NULL;
+	blob->m_pNextBlob = this->m_pFirstBlob;
+	if( this->m_pFirstBlob ) this->m_pFirstBlob->m_pPrevBlob = blob;
+	this->m_pFirstBlob = blob;
+}
+
+void CDatabase::untrackBlob(CBlob* blob)
+{
+	if( blob->m_pOwner != this ) return;
+	if( blob->m_pPrevBlob ) {
+		blob->m_pPrevBlob->m_pNextBlob = blob->m_pNextBlob;
+	} else {
+		this->m_pFirstBlob = blob->m_pNextBlob;
+	}
+	if( blob->m_pNextBlob ) blob->m_pNextBlob->m_pPrevBlob = blob->m_pPrevBlob;
+	blob->m_pOwner = NULL;
+	blob->m_pPrevBlob = NULL;
+	blob->m_pNextBlob = NULL;
+}
+
+// The Lua objects stay around until they are collected, they just stop working
+void CDatabase::finalizeStatements(void)
+{
+	while( this->m_pFirstStatement ) {
+		this->m_pFirstStatement->finalize();
+		this->m_iNumClosedStatements++;
+	}
+}
+
+
+sqlite3* CDatabase::getDatabase(void)
+{
+	return this->m_pDatabase;
+}
+
+
+int CDatabase::open(const char* dbName, int flags, const char* zVfs) {
+	if( this->m_pDatabase ) {
+		return SQLITE_ERROR;
+	}
+	int retcode = sqlite3_open_v2(dbName, &this->m_pDatabase, flags, zVfs);
+	if( this->m_pDatabase ) this->link();
+	if( retcode != SQLITE_OK ) return retcode;
+	retcode = RegisterNatives(this->m_pDatabase);
+	if( retcode == SQLITE_OK ) retcode = RegisterCompression(this->m_pDatabase);
+	if( retcode == SQLITE_OK ) retcode = RegisterArray(this->m_pDatabase);
+	if( retcode != SQLITE_OK ) this->close();
+	return retcode;
+}
+
+int CDatabase::open(const char* dbName, int flags, const DatabaseOptions& options)
+{
+
+	if( this->m_pDatabase ) {
+		return SQLITE_ERROR;
+	}
+
+	if( ( options.pszJournal && !IsOneOf(options.pszJournal, s_pszJournalModes) ) ||
+		( options.pszSynchronous && !IsOneOf(options.pszSynchronous, s_pszSynchronousModes) ) ||
+		( options.pszTempStore && !IsOneOf(options.pszTempStore, s_pszTempStores) ) ) {
+		return SQLITE_MISUSE;
+	}
+
+	int retcode = SQLITE_OK;
+
+	if( options.bMemory ) {
+
+		retcode = this->openInMemory(dbName, flags, options.dSnapshotInterval);
+
+	} else if( ( options.bImmutable || options.bNoLock ) && stricmp(dbName, ":memory:") != 0 ) {
+
+		char uri[MAX_PATH * 3 + 32];
+		if( !BuildUri(dbName, options, uri, sizeof(uri)) ) {
+			return SQLITE_CANTOPEN;
+		}
+		retcode = this->open(uri, flags | SQLITE_OPEN_URI, NULL);
+
+	} else {
+
+		retcode = this->open(dbName, flags, NULL);
+
+	}
+
+	// A connection without the settings that were asked for is not handed out
+	if( retcode == SQLITE_OK ) {
+		retcode = this->applyOptions(options);
+		if( retcode != SQLITE_OK ) this->close();
+	}
+
+	return retcode;
+
+}
+
+int CDatabase::applyOptions(const DatabaseOptions& options)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	char sql[128];
+	int retcode = SQLITE_OK;
+
+	if( options.iBusyTimeout >= 0 ) {
+		retcode = this->setBusyTimeout(options.iBusyTimeout);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	if( options.bBusyBackoff ) {
+		retcode = this->setBusyBackoff(true);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	if( options.bBatch ) {
+		this->setBatching(true);
+	}
+
+	if( options.pszJournal ) {
+		sqlite3_snprintf(sizeof(sql), sql, "PRAGMA journal_mode=%s;", options.pszJournal);
+		retcode = this->execute(sql);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	if( options.pszSynchronous ) {
+		sqlite3_snprintf(sizeof(sql), sql, "PRAGMA synchronous=%s;", options.pszSynchronous);
+		retcode = this->execute(sql);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	if( options.pszTempStore ) {
+		sqlite3_snprintf(sizeof(sql), sql, "PRAGMA temp_store=%s;", options.pszTempStore);
+		retcode = this->execute(sql);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	// A negative cache_size is in KiB rather than pages
+	if( options.iCacheMB >= 0 ) {
+		sqlite3_snprintf(sizeof(sql), sql, "PRAGMA cache_size=-%d;", options.iCacheMB * 1024);
+		retcode = this->execute(sql);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	if( options.iMmapMB >= 0 ) {
+		sqlite3_snprintf(sizeof(sql), sql, "PRAGMA mmap_size=%lld;", (sqlite3_int64)options.iMmapMB * 1024 * 1024);
+		retcode = this->execute(sql);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	if( options.iMemoryLimitMB >= 0 ) {
+		this->setMemoryLimit((sqlite3_int64)options.iMemoryLimitMB * 1024 * 1024);
+	}
+
+	return retcode;
+
+}
+
+int CDatabase::close(void)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	// The last changes only reach the disk through a final snapshot, if that fails they are lost with the connection
+	int snapshotResult = SQLITE_OK;
+	if( this->m_pszSnapshotFile ) {
+		snapshotResult = this->snapshot();
+		if( snapshotResult != SQLITE_OK ) {
+			Msg("gm_sqlite3: final snapshot to '%s' failed (%d), %d changes were not written\n", this->m_pszSnapshotFile, snapshotResult, this->getSnapshotChanges());
+		}
+		free(this->m_pszSnapshotFile);
+		this->m_pszSnapshotFile = NULL;
+	}
+
+	this->unlink();
+	this->stopCheckpointer();
+	this->abandonDeferred(SQLITE_ABORT);
+	if( !this->m_bThinking ) this->releaseQueue();
+	this->dropSearch();
+	this->finalizeStatements();
+	this->setResultCache(0, 0.0);
+
+	CBackup::forgetDestination(this);
+	this->m_iNumIncoming = 0;
+
+	// Blobs keep the connection usable until they are closed, they only stop reporting their writes
+	while( this->m_pFirstBlob ) {
+		this->untrackBlob(this->m_pFirstBlob);
+	}
+
+	// Blobs and backups may still be open, sqlite3_close_v2 keeps the connection around until they are finished
+	int retcode = sqlite3_close_v2(this->m_pDatabase);
+	if( retcode == SQLITE_OK ) {
+		this->m_pDatabase = NULL;
+	}
+	return ( retcode == SQLITE_OK ) ? snapshotResult : retcode;
+
+}
+
+
+bool CDatabase::isOpen(void)
+{
+	return ( this->m_pDatabase != NULL );
+}
+
+
+int CDatabase::setExtendedErrors(bool onoff)
+{
+	VALIDATE_DATABASE(SQLITE_ERROR);
+	return sqlite3_extended_result_codes(this->m_pDatabase, onoff);
+}
+
+
+// Remembered so deferred writes can switch the timeout off around their attempts and put it back afterwards
+int CDatabase::setBusyTimeout(int milliseconds)
+{
+	VALIDATE_DATABASE(SQLITE_ERROR);
+	this->m_iBusyTimeout = ( milliseconds > 0 ) ? milliseconds : 0;
+	this->restoreBusyHandler();
+	return SQLITE_OK;
+}
+
+// Instead of SQLite's fixed sleeps, waits for a lock with a doubling and randomly jittered delay until the busy timeout
+// runs out. Processes that ran into the same lock then do not all wake up and retry at the same moment.
+// Fails with SQLITE_MISUSE while there is no busy timeout, the backoff would have nothing to wait for.
+int CDatabase::setBusyBackoff(bool onoff)
+{
+	VALIDATE_DATABASE(SQLITE_ERROR);
+	this->syncBusyTimeout();
+	if( onoff && this->m_iBusyTimeout <= 0 ) return SQLITE_MISUSE;
+	this->m_bBusyBackoff = onoff;
+	this->restoreBusyHandler();
+	return SQLITE_OK;
+}
+
+void CDatabase::restoreBusyHandler(void)
+{
+	if( this->m_bBusyBackoff && this->m_iBusyTimeout > 0 ) {
+		sqlite3_busy_handler(this->m_pDatabase, CDatabase::busyHandler, this);
+	} else {
+		sqlite3_busy_timeout(this->m_pDatabase, this->m_iBusyTimeout);
+	}
+}
+
+int CDatabase::busyHandler(void* usrPtr, int count)
+{
+
+	CDatabase* pDatabase = (CDatabase*)usrPtr;
+	double now = GetTimeMilliseconds();
+
+	// count starts over at 0 for every lock that turns out to be busy
+	if( count == 0 ) {
+		pDatabase->m_dBusyStarted = now;
+		pDatabase->m_iNumBusyWaits++;
+	}
+
+	if( now - pDatabase->m_dBusyStarted >= pDatabase->m_iBusyTimeout ) {
+		pDatabase->m_iNumLockTimeouts++;
+		return 0;
+	}
+
+	int delay = BUSY_BACKOFF_MIN << ( count < 7 ? count : 7 );
+	if( delay > BUSY_BACKOFF_MAX ) delay = BUSY_BACKOFF_MAX;
+
+	// Somewhere between half and all of the delay, sqlite3_randomness is seeded differently in every process
+	unsigned int random = 0;
+	sqlite3_randomness(sizeof(random), &random);
+	delay = delay / 2 + (int)( random % (unsigned int)( delay - delay / 2 + 1 ) );
+
+	ThreadSleep(delay);
+
+	double after = GetTimeMilliseconds();
+	pDatabase->m_dLockWaitTotal += after - now;
+	if( after - pDatabase->m_dBusyStarted > pDatabase->m_dLockWaitMax ) pDatabase->m_dLockWaitMax = after - pDatabase->m_dBusyStarted;
+
+	return 1;
+
+}
+
+
+int CDatabase::getErrorCode(void)
+{
+	VALIDATE_DATABASE(SQLITE_ERROR);
+	return sqlite3_errcode(this->m_pDatabase);
+}
+
+const char* CDatabase::getErrorMessage(void)
+{
+	VALIDATE_DATABASE(NULL);
+	return sqlite3_errmsg(this->m_pDatabase);
+}
+
+
+sqlite3_int64 CDatabase::getLastInsertId(void)
+{
+	VALIDATE_DATABASE(0);
+	return sqlite3_last_insert_rowid(this->m_pDatabase);
+}
+
+
+int CDatabase::getChanges(void)
+{
+	VALIDATE_DATABASE(0);
+	return sqlite3_changes(this->m_pDatabase);
+}
+
+int CDatabase::getTotalChanges(void)
+{
+	VALIDATE_DATABASE(0);
+	return sqlite3_total_changes(this->m_pDatabase);
+}
+
+
+int CDatabase::getStatus(int op, int* current, int* highwater, bool reset)
+{
+	VALIDATE_DATABASE(SQLITE_ERROR);
+	return sqlite3_db_status(this->m_pDatabase, op, current, highwater, reset ? 1 : 0);
+}
+
+
+// Frees as much of the page cache as sqlite3_db_release_memory can, reclaimed is measured from SQLITE_DBSTATUS_CACHE_USED
+int CDatabase::releaseMemory(int* reclaimed)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	int before = 0;
+	int after = 0;
+	int highwater = 0;
+
+	sqlite3_db_status(this->m_pDatabase, SQLITE_DBSTATUS_CACHE_USED, &before, &highwater, 0);
+
+	int retcode = sqlite3_db_release_memory(this->m_pDatabase);
+
+	sqlite3_db_status(this->m_pDatabase, SQLITE_DBSTATUS_CACHE_USED, &after, &highwater, 0);
+
+	int freed = ( before > after ) ? before - after : 0;
+
+	this->m_iBytesReclaimed += freed;
+	this->m_iNumReleases++;
+
+	if( reclaimed ) *reclaimed = freed;
+
+	return retcode;
+
+}
+
+// 0 turns the automatic release off
+void CDatabase::setMemoryLimit(sqlite3_int64 bytes)
+{
+	this->m_iMemoryLimit = ( bytes > 0 ) ? bytes : 0;
+}
+
+sqlite3_int64 CDatabase::getMemoryLimit(void)
+{
+	return this->m_iMemoryLimit;
+}
+
+sqlite3_int64 CDatabase::getBytesReclaimed(void)
+{
+	return this->m_iBytesReclaimed;
+}
+
+int CDatabase::getNumEvictions(void)
+{
+	return this->m_iNumEvictions;
+}
+
+int CDatabase::getNumReleases(void)
+{
+	return this->m_iNumReleases;
+}
+
+
+int CDatabase::execute(const char* sql, sqlite3_callback callback, void* usrPtr)
+{
+	VALIDATE_DATABASE(SQLITE_ERROR);
+	return sqlite3_exec(this->m_pDatabase, sql, callback, usrPtr, NULL);
+}
+
+// SQLite owns function from here on and deletes it when it is replaced, the database closes or registering fails
+int CDatabase::createFunction(const char* name, int numArgs, int flags, CFunction* function)
+{
+
+	if( !this->m_pDatabase || !function ) {
+		delete function;
+		return SQLITE_ERROR;
+	}
+
+	int retcode = SQLITE_OK;
+
+	if( function->isAggregate() ) {
+		retcode = sqlite3_create_function_v2(this->m_pDatabase, name, numArgs, SQLITE_UTF8 | flags, function,
+			NULL, CFunction::xStep, CFunction::xFinal, CFunction::xDestroy);
+	} else {
+		retcode = sqlite3_create_function_v2(this->m_pDatabase, name, numArgs, SQLITE_UTF8 | flags, function,
+			CFunction::xFunc, NULL, NULL, CFunction::xDestroy);
+	}
+
+	if( retcode == SQLITE_OK && this->m_pResultCache ) this->m_pResultCache->functionsChanged();
+
+	return retcode;
+
+}
+
+// Creates an FTS5 table unless it already exists, fails with SQLITE_ERROR when SQLite was built without FTS5.
+// tokenizer is passed through as is, for example "porter unicode61" or "trigram".
+int CDatabase::createTextIndex(const char* name, const char** columns, int numColumns, const char* tokenizer)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( !name || !columns || numColumns < 1 ) return SQLITE_MISUSE;
+
+	char* pszColumns = NULL;
+
+	for( int i = 0; i < numColumns; i++ ) {
+		char* pszNext = sqlite3_mprintf("%z%s\"%w\"", pszColumns, i ? ", " : "", columns[i]);
+		if( !pszNext ) return SQLITE_NOMEM;
+		pszColumns = pszNext;
+	}
+
+	char* pszSql = NULL;
+
+	if( tokenizer && *tokenizer ) {
+		pszSql = sqlite3_mprintf("CREATE VIRTUAL TABLE IF NOT EXISTS \"%w\" USING fts5(%s, tokenize=%Q);", name, pszColumns, tokenizer);
+	} else {
+		pszSql = sqlite3_mprintf("CREATE VIRTUAL TABLE IF NOT EXISTS \"%w\" USING fts5(%s);", name, pszColumns);
+	}
+
+	sqlite3_free(pszColumns);
+
+	if( !pszSql ) return SQLITE_NOMEM;
+
+	int retcode = this->execute(pszSql);
+	sqlite3_free(pszSql);
+
+	return retcode;
+
+}
+
+// The statement takes the MATCH query as ?1 and the row limit as ?2 and returns rowid, the bm25 score
+// (lower is better), a snippet of the best matching column with the hits wrapped in open and close, then every column.
+// It belongs to the database and is handed out again for the next search with the same options, reset it when done.
+int CDatabase::prepareSearch(CStatement** stmt, const char* name, const char* open, const char* close, const char* ellipsis, int tokens)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( !name ) return SQLITE_MISUSE;
+
+	// snippet only takes between 1 and 64 tokens
+	if( tokens < 1 ) tokens = 1;
+	if( tokens > 64 ) tokens = 64;
+
+	char* pszSql = sqlite3_mprintf(
+		"SELECT rowid, bm25(\"%w\"), snippet(\"%w\", -1, %Q, %Q, %Q, %d), * FROM \"%w\" WHERE \"%w\" MATCH ?1 ORDER BY rank LIMIT ?2;",
+		name, name, open ? open : "", close ? close : "", ellipsis ? ellipsis : "", tokens, name, name);
+
+	if( !pszSql ) return SQLITE_NOMEM;
+
+	if( this->m_pSearch && strcmp(this->m_pszSearchSql, pszSql) == 0 ) {
+		sqlite3_free(pszSql);
+		this->m_pSearch->reset();
+		this->m_pSearch->clearBindings();
+		*stmt = this->m_pSearch;
+		return SQLITE_OK;
+	}
+
+	this->dropSearch();
+
+	int retcode = this->prepare(&this->m_pSearch, pszSql);
+
+	if( this->m_pSearch ) {
+		this->m_pszSearchSql = pszSql;
+	} else {
+		sqlite3_free(pszSql);
+	}
+
+	*stmt = this->m_pSearch;
+	return retcode;
+
+}
+
+void CDatabase::dropSearch(void)
+{
+	if( this->m_pSearch ) {
+		this->m_pSearch->finalize();
+		delete this->m_pSearch;
+		this->m_pSearch = NULL;
+	}
+	sqlite3_free(this->m_pszSearchSql);
+	this->m_pszSearchSql = NULL;
+}
+
+// Deferred writes run inside a savepoint, which BEGIN, COMMIT and the like would break out of
+static bool ControlsTransaction(const char* sql)
+{
+
+	static const char* pszKeywords[] = { "begin", "commit", "end", "rollback", "savepoint", "release", NULL };
+
+	const char* p = sql;
+
+	while( *p ) {
+
+		// Whitespace and comments in front of the statement
+		if( isspace((unsigned char)*p) || *p == ';' ) {
+			p++;
+			continue;
+		}
+		if( p[0] == '-' && p[1] == '-' ) {
+			while( *p && *p != '\n' ) p++;
+			continue;
+		}
+		if( p[0] == '/' && p[1] == '*' ) {
+			const char* pEnd = strstr(p + 2, "*/");
+			p = pEnd ? pEnd + 2 : p + strlen(p);
+			continue;
+		}
+
+		for( int i = 0; pszKeywords[i]; i++ ) {
+			size_t length = strlen(pszKeywords[i]);
+			if( strnicmp(p, pszKeywords[i], length) == 0 && !isalnum((unsigned char)p[length]) && p[length] != '_' ) {
+				return true;
+			}
+		}
+
+		// The statement ends at the first semicolon sqlite3_complete agrees with, which skips the ones in strings and triggers
+		const char* pEnd = p;
+		for( ;; ) {
+			pEnd = strchr(pEnd, ';');
+			if( !pEnd ) return false;
+			pEnd++;
+			char* pszStatement = sqlite3_mprintf("%.*s", (int)( pEnd - p ), p);
+			int complete = pszStatement ? sqlite3_complete(pszStatement) : 1;
+			sqlite3_free(pszStatement);
+			if( complete ) break;
+		}
+		p = pEnd;
+
+	}
+
+	return false;
+
+}
+
+// Switches a busy_timeout a script set with PRAGMA over to m_iBusyTimeout, so restoreBusyHandler puts that one back.
+// With the backoff handler installed the pragma reads 0, which only means the handler is still in place.
+void CDatabase::syncBusyTimeout(void)
+{
+
+	sqlite3_stmt* pStmt = NULL;
+
+	if( sqlite3_prepare_v2(this->m_pDatabase, "PRAGMA busy_timeout;", -1, &pStmt, NULL) == SQLITE_OK && sqlite3_step(pStmt) == SQLITE_ROW ) {
+		int timeout = sqlite3_column_int(pStmt, 0);
+		if( timeout > 0 || !this->m_bBusyBackoff ) this->m_iBusyTimeout = timeout;
+	}
+
+	sqlite3_finalize(pStmt);
+
+}
+
+// A single attempt that never waits on the busy handler. The sql runs in a savepoint, so an attempt that runs into
+// SQLITE_BUSY half way leaves nothing behind and the retry starts over from a clean state, even for several statements.
+// savepoint is false only for the transaction control of flushBatch.
+int CDatabase::tryExecute(const char* sql, bool savepoint)
+{
+
+	bool inTransaction = ( sqlite3_get_autocommit(this->m_pDatabase) == 0 );
+
+	this->syncBusyTimeout();
+	sqlite3_busy_handler(this->m_pDatabase, NULL, NULL);
+
+	int retcode = SQLITE_OK;
+
+	if( savepoint ) {
+
+		retcode = sqlite3_exec(this->m_pDatabase, "SAVEPOINT deferred_attempt;", NULL, NULL, NULL);
+
+		if( retcode == SQLITE_OK ) {
+
+			retcode = sqlite3_exec(this->m_pDatabase, sql, NULL, NULL, NULL);
+
+			// Outside a transaction the release is the commit, which can be busy as well
+			if( retcode == SQLITE_OK ) {
+				retcode = sqlite3_exec(this->m_pDatabase, "RELEASE deferred_attempt;", NULL, NULL, NULL);
+			}
+
+			if( retcode != SQLITE_OK ) {
+				if( inTransaction ) {
+					sqlite3_exec(this->m_pDatabase, "ROLLBACK TO deferred_attempt; RELEASE deferred_attempt;", NULL, NULL, NULL);
+				} else if( sqlite3_get_autocommit(this->m_pDatabase) == 0 ) {
+					sqlite3_exec(this->m_pDatabase, "ROLLBACK;", NULL, NULL, NULL);
+				}
+			}
+
+		}
+
+	} else {
+
+		retcode = sqlite3_exec(this->m_pDatabase, sql, NULL, NULL, NULL);
+
+	}
+
+	this->restoreBusyHandler();
+
+	if( ( retcode & 0xFF ) == SQLITE_BUSY ) {
+		this->m_iNumBusy++;
+	}
+
+	return retcode;
+
+}
+
+// Runs sql right away if nothing is queued ahead of it, otherwise or when it gets SQLITE_BUSY it is parked and retried from think.
+// Returns SQLITE_BUSY when the write was parked, the callback fires either way once it is finished.
+// With batching on everything is queued for the next think and SQLITE_OK is returned.
+// Inside an open transaction the sql is just executed, retrying it later would take it out of that transaction.
+// sql that begins or ends a transaction itself fails with SQLITE_MISUSE, see ControlsTransaction.
+int CDatabase::executeDeferred(const char* sql, DeferredCallback callback, void* usrPtr)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( !sql ) return SQLITE_MISUSE;
+
+	if( ControlsTransaction(sql) ) {
+		if( callback ) callback(usrPtr, SQLITE_MISUSE, 0.0);
+		return SQLITE_MISUSE;
+	}
+
+	double now = GetTimeMilliseconds();
+
+	// Batched writes always wait for the next think, so they can be committed together
+	if( !this->m_pFirstDeferred && !( this->m_bBatching && sqlite3_get_autocommit(this->m_pDatabase) != 0 ) ) {
+
+		int retcode = ( sqlite3_get_autocommit(this->m_pDatabase) == 0 ) ? this->execute(sql) : this->tryExecute(sql);
+
+		if( ( retcode & 0xFF ) != SQLITE_BUSY || sqlite3_get_autocommit(this->m_pDatabase) == 0 ) {
+			if( callback ) callback(usrPtr, retcode, 0.0);
+			return retcode;
+		}
+
+	}
+
+	DeferredWrite* pWrite = new DeferredWrite;
+	pWrite->pszSql = strdup(sql);
+	pWrite->pCallback = callback;
+	pWrite->pUsrPtr = usrPtr;
+	pWrite->dQueued = now;
+	pWrite->dNextAttempt = ( this->m_pFirstDeferred || this->m_bBatching ) ? now : now + DEFERRED_BACKOFF_MIN;
+	pWrite->iAttempts = ( this->m_pFirstDeferred || this->m_bBatching ) ? 0 : 1;
+	pWrite->iResult = SQLITE_OK;
+	pWrite->pNext = NULL;
+
+	if( this->m_pLastDeferred ) {
+		this->m_pLastDeferred->pNext = pWrite;
+	} else {
+		this->m_pFirstDeferred = pWrite;
+	}
+	this->m_pLastDeferred = pWrite;
+
+	this->m_iNumQueued++;
+	this->m_iNumDeferred++;
+
+	return this->m_bBatching ? SQLITE_OK : SQLITE_BUSY;
+
+}
+
+void CDatabase::finishDeferred(DeferredWrite* write, int retcode, double latency)
+{
+	if( write->pCallback ) write->pCallback(write->pUsrPtr, retcode, latency);
+	free(write->pszSql);
+	delete write;
+}
+
+// Writes go through strictly in the order they were queued, so a busy head holds up everything behind it
+void CDatabase::pumpDeferred(void)
+{
+
+	// Scripts holding a transaction open get their writes run once they are done, as with flushBatch
+	if( !this->m_pDatabase || sqlite3_get_autocommit(this->m_pDatabase) == 0 ) return;
+
+	double now = GetTimeMilliseconds();
+
+	while( this->m_pDatabase && this->m_pFirstDeferred && this->m_pFirstDeferred->dNextAttempt <= now ) {
+
+		DeferredWrite* pWrite = this->m_pFirstDeferred;
+
+		int retcode = this->tryExecute(pWrite->pszSql);
+		double latency = GetTimeMilliseconds() - pWrite->dQueued;
+
+		if( ( retcode & 0xFF ) == SQLITE_BUSY && latency < this->m_dDeferredTimeout ) {
+			this->backoffDeferred(pWrite, now);
+			break;
+		}
+
+		// Unlinked before the callback runs, it may well queue another write
+		this->m_pFirstDeferred = pWrite->pNext;
+		if( !this->m_pFirstDeferred ) this->m_pLastDeferred = NULL;
+		this->m_iNumQueued--;
+
+		if( ( retcode & 0xFF ) == SQLITE_BUSY ) {
+			this->m_iNumAbandoned++;
+		} else {
+			this->m_iNumRetried++;
+			this->m_dRetryLatencyTotal += latency;
+			if( latency > this->m_dRetryLatencyMax ) this->m_dRetryLatencyMax = latency;
+		}
+
+		this->finishDeferred(pWrite, retcode, latency);
+
+	}
+
+}
+
+void CDatabase::backoffDeferred(DeferredWrite* write, double now)
+{
+	int delay = DEFERRED_BACKOFF_MIN << ( write->iAttempts < 8 ? write->iAttempts : 8 );
+	write->dNextAttempt = now + ( delay < DEFERRED_BACKOFF_MAX ? delay : DEFERRED_BACKOFF_MAX );
+	write->iAttempts++;
+}
+
+// Commits everything queued in one BEGIN IMMEDIATE transaction, so the write lock is taken once per tick rather than
+// once per write. Every write runs in its own savepoint, one that fails is rolled back without taking the others with it.
+void CDatabase::flushBatch(void)
+{
+
+	double now = GetTimeMilliseconds();
+
+	if( !this->m_pFirstDeferred || this->m_pFirstDeferred->dNextAttempt > now ) return;
+
+	// Scripts holding a transaction open get their writes committed once they are done
+	if( sqlite3_get_autocommit(this->m_pDatabase) == 0 ) return;
+
+	int retcode = this->tryExecute("BEGIN IMMEDIATE;", false);
+
+	if( retcode != SQLITE_OK ) {
+		this->failBatch(retcode, now);
+		return;
+	}
+
+	int count = 0;
+
+	for( DeferredWrite* pWrite = this->m_pFirstDeferred; pWrite && count < DEFERRED_BATCH_MAX; pWrite = pWrite->pNext, count++ ) {
+		sqlite3_exec(this->m_pDatabase, "SAVEPOINT deferred;", NULL, NULL, NULL);
+		pWrite->iResult = sqlite3_exec(this->m_pDatabase, pWrite->pszSql, NULL, NULL, NULL);
+		if( pWrite->iResult != SQLITE_OK ) {
+			sqlite3_exec(this->m_pDatabase, "ROLLBACK TO deferred;", NULL, NULL, NULL);
+		}
+		sqlite3_exec(this->m_pDatabase, "RELEASE deferred;", NULL, NULL, NULL);
+	}
+
+	// Readers can still hold up the commit in rollback journal mode, so it doesn't wait on them either
+	retcode = this->tryExecute("COMMIT;", false);
+
+	if( retcode != SQLITE_OK ) {
+		sqlite3_exec(this->m_pDatabase, "ROLLBACK;", NULL, NULL, NULL);
+		this->failBatch(retcode, now);
+		return;
+	}
+
+	this->m_iNumBatches++;
+	this->m_iNumBatched += count;
+
+	double finished = GetTimeMilliseconds();
+
+	for( ; count > 0 && this->m_pDatabase && this->m_pFirstDeferred; count-- ) {
+
+		DeferredWrite* pWrite = this->m_pFirstDeferred;
+
+		this->m_pFirstDeferred = pWrite->pNext;
+		if( !this->m_pFirstDeferred ) this->m_pLastDeferred = NULL;
+		this->m_iNumQueued--;
+
+		double latency = finished - pWrite->dQueued;
+
+		this->m_iNumRetried++;
+		this->m_dRetryLatencyTotal += latency;
+		if( latency > this->m_dRetryLatencyMax ) this->m_dRetryLatencyMax = latency;
+
+		this->finishDeferred(pWrite, pWrite->iResult, latency);
+
+	}
+
+}
+
+// A busy batch is tried again until its oldest write times out, any other error fails everything queued with it
+void CDatabase::failBatch(int retcode, double now)
+{
+	if( ( retcode & 0xFF ) == SQLITE_BUSY && now - this->m_pFirstDeferred->dQueued < this->m_dDeferredTimeout ) {
+		this->backoffDeferred(this->m_pFirstDeferred, now);
+		return;
+	}
+	this->abandonDeferred(retcode);
+}
+
+void CDatabase::abandonDeferred(int retcode)
+{
+	double now = GetTimeMilliseconds();
+	while( this->m_pFirstDeferred ) {
+		DeferredWrite* pWrite = this->m_pFirstDeferred;
+		this->m_pFirstDeferred = pWrite->pNext;
+		if( !this->m_pFirstDeferred ) this->m_pLastDeferred = NULL;
+		this->m_iNumQueued--;
+		this->m_iNumAbandoned++;
+		this->finishDeferred(pWrite, retcode, now - pWrite->dQueued);
+	}
+}
+
+// Holds a reference to self until the queue is empty. The userdata's __gc can therefore never find writes queued,
+// and no callback runs from inside a garbage collection.
+void CDatabase::holdQueue(ILuaObject* self)
+{
+	if( this->m_pQueueRef || !this->m_pFirstDeferred ) {
+		SAFE_UNREF(self);
+		return;
+	}
+	this->m_pQueueRef = self;
+}
+
+void CDatabase::releaseQueue(void)
+{
+	SAFE_UNREF(this->m_pQueueRef);
+}
+
+// How long a parked write keeps being retried before its callback gets SQLITE_BUSY
+void CDatabase::setDeferredTimeout(double milliseconds)
+{
+	this->m_dDeferredTimeout = milliseconds;
+}
+
+// Queued writes are held until the next think and then committed together, see flushBatch
+void CDatabase::setBatching(bool onoff)
+{
+	this->m_bBatching = onoff;
+}
+
+int CDatabase::getNumQueued(void)
+{
+	return this->m_iNumQueued;
+}
+
+// Every SQLITE_BUSY a deferred attempt ran into
+int CDatabase::getNumBusy(void)
+{
+	return this->m_iNumBusy;
+}
+
+int CDatabase::getNumDeferred(void)
+{
+	return this->m_iNumDeferred;
+}
+
+int CDatabase::getNumRetried(void)
+{
+	return this->m_iNumRetried;
+}
+
+int CDatabase::getNumAbandoned(void)
+{
+	return this->m_iNumAbandoned;
+}
+
+// From being queued to going through, for the writes that had to be retried
+double CDatabase::getRetryLatencyAverage(void)
+{
+	return ( this->m_iNumRetried > 0 ) ? this->m_dRetryLatencyTotal / this->m_iNumRetried : 0.0;
+}
+
+double CDatabase::getRetryLatencyMax(void)
+{
+	return this->m_dRetryLatencyMax;
+}
+
+// Locks the backoff busy handler had to wait for, including the ones it gave up on
+int CDatabase::getNumBusyWaits(void)
+{
+	return this->m_iNumBusyWaits;
+}
+
+int CDatabase::getNumLockTimeouts(void)
+{
+	return this->m_iNumLockTimeouts;
+}
+
+double CDatabase::getLockWaitTotal(void)
+{
+	return this->m_dLockWaitTotal;
+}
+
+double CDatabase::getLockWaitMax(void)
+{
+	return this->m_dLockWaitMax;
+}
+
+int CDatabase::getNumBatches(void)
+{
+	return this->m_iNumBatches;
+}
+
+int CDatabase::getNumBatched(void)
+{
+	return this->m_iNumBatched;
+}
+
+
+int CDatabase::prepare(CStatement** stmt, const char* sql)
+{
+
+	VALIDATE_DATABASE(NULL);
+
+	if( !stmt ) return SQLITE_ERROR;
+
+	if( *stmt ) {
+		(*stmt)->finalize();
+		delete (*stmt);
+	}
+
+	*stmt = NULL;
+	sqlite3_stmt* pStmt = NULL;
+
+	// The cache learns which tables the statement reads and writes from the authorizer while it compiles
+	if( this->m_pResultCache ) this->m_pResultCache->beginPrepare();
+
+	int retcode = sqlite3_prepare_v2(this->m_pDatabase, sql, -1, &pStmt, NULL);
+
+	StatementCacheInfo* pCacheInfo = this->m_pResultCache ? this->m_pResultCache->endPrepare(pStmt) : NULL;
+
+	if( retcode == SQLITE_OK ) {
+		*stmt = new CStatement(retcode, pStmt, this);
+		(*stmt)->m_pCacheInfo = pCacheInfo;
+	} else {
+		CQueryCache::freeInfo(pCacheInfo);
+	}
+
+	return retcode;
+
+}
+
+// Caches the rows of read-only statements keyed by their SQL and bound parameters, writes through this
+// connection drop every result that read the tables they touch, see CQueryCache
+// maxAge is in milliseconds and 0 keeps results until they are invalidated or evicted, maxBytes 0 turns the cache off
+// The cache installs its own authorizer, update hook and rollback hook on the connection while it is on
+int CDatabase::setResultCache(sqlite3_int64 maxBytes, double maxAge)
+{
+
+	if( maxBytes <= 0 ) {
+
+		if( !this->m_pResultCache ) return SQLITE_OK;
+
+		for( CStatement* pStmt = this->m_pFirstStatement; pStmt; pStmt = pStmt->m_pNextLive ) {
+			CQueryCache::freeInfo(pStmt->m_pCacheInfo);
+			pStmt->m_pCacheInfo = NULL;
+		}
+
+		delete this->m_pResultCache;
+		this->m_pResultCache = NULL;
+
+		return SQLITE_OK;
+
+	}
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( this->m_pResultCache ) {
+		this->m_pResultCache->setLimits(maxBytes, maxAge);
+		return SQLITE_OK;
+	}
+
+	this->m_pResultCache = new CQueryCache(this->m_pDatabase, maxBytes, maxAge);
+	if( this->m_iNumIncoming > 0 ) this->m_pResultCache->setIncoming(true);
+
+	// Statements that were already prepared can still write, the hooks miss WITHOUT ROWID tables among others
+	for( CStatement* pStmt = this->m_pFirstStatement; pStmt; pStmt = pStmt->m_pNextLive ) {
+		pStmt->m_pCacheInfo = this->m_pResultCache->trackWrites(pStmt->m_pStmt);
+	}
+
+	return SQLITE_OK;
+
+}
+
+CQueryCache* CDatabase::getResultCache(void)
+{
+	return this->m_pResultCache;
+}
+
+CStatement* CDatabase::getFirstStatement(void)
+{
+	return this->m_pFirstStatement;
+}
+
+CStatement* CDatabase::getNextStatement(CStatement* stmt)
+{
+	return stmt ? stmt->m_pNextLive : NULL;
+}
+
+int CDatabase::getNumStatements(void)
+{
+	return this->m_iNumStatements;
+}
+
+// Statements the garbage collector had to finalize
+int CDatabase::getNumLeakedStatements(void)
+{
+	return this->m_iNumLeakedStatements;
+}
+
+// Statements finalized because the database was closed under them
+int CDatabase::getNumClosedStatements(void)
+{
+	return this->m_iNumClosedStatements;
+}
+
+
+int CDatabase::openBlob(CBlob** blob, const char* table, const char* column, sqlite3_int64 rowid, bool writable, const char* dbName)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( !blob ) return SQLITE_ERROR;
+
+	*blob = NULL;
+	sqlite3_blob* pBlob = NULL;
+
+	int retcode = sqlite3_blob_open(this->m_pDatabase, dbName, table, column, rowid, writable ? 1 : 0, &pBlob);
+
+	if( retcode == SQLITE_OK ) {
+		// Incremental writes go around the update hook, writable blobs tell the cache about each one themselves
+		*blob = new CBlob(pBlob, this, writable ? table : NULL);
+	} else if( pBlob ) {
+		sqlite3_blob_close(pBlob);
+	}
+
+	return retcode;
+
+}
+
+
+int CDatabase::backupTo(CBackup** backup, const char* fileName, int pagesPerStep)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( !backup ) return SQLITE_ERROR;
+
+	*backup = NULL;
+	sqlite3* pDestination = NULL;
+
+	int retcode = sqlite3_open_v2(fileName, &pDestination, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+
+	if( retcode != SQLITE_OK ) {
+		sqlite3_close(pDestination);
+		return retcode;
+	}
+
+	return CBackup::create(backup, pDestination, "main", this->m_pDatabase, "main", true, pagesPerStep);
+
+}
+
+int CDatabase::backupTo(CBackup** backup, CDatabase* destination, int pagesPerStep)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( !backup || !destination || !destination->isOpen() || destination == this ) return SQLITE_ERROR;
+
+	*backup = NULL;
+
+	int retcode = CBackup::create(backup, destination->getDatabase(), "main", this->m_pDatabase, "main", false, pagesPerStep);
+	if( *backup ) (*backup)->setDestinationDatabase(destination);
+
+	return retcode;
+
+}
+
+void CDatabase::beginIncoming(void)
+{
+	if( this->m_iNumIncoming++ == 0 && this->m_pResultCache ) this->m_pResultCache->setIncoming(true);
+}
+
+void CDatabase::endIncoming(void)
+{
+	if( this->m_iNumIncoming <= 0 ) return;
+	if( --this->m_iNumIncoming == 0 && this->m_pResultCache ) this->m_pResultCache->setIncoming(false);
+}
+
+
+// Loads fileName into a :memory: connection, queries never touch the disk after this.
+// Changes are written back every snapshotInterval seconds (0 for only on close).
+int CDatabase::openInMemory(const char* fileName, int flags, double snapshotInterval)
+{
+
+	if( this->m_pDatabase ) {
+		return SQLITE_ERROR;
+	}
+
+	sqlite3* pFile = NULL;
+	int retcode = sqlite3_open_v2(fileName, &pFile, flags, NULL);
+
+	if( retcode != SQLITE_OK ) {
+		sqlite3_close(pFile);
+		return retcode;
+	}
+
+	retcode = this->open(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+
+	if( retcode == SQLITE_OK ) {
+
+		CBackup* pLoad = NULL;
+		retcode = CBackup::create(&pLoad, this->m_pDatabase, "main", pFile, "main", false, -1);
+
+		if( pLoad ) {
+			retcode = pLoad->step(-1);
+			pLoad->finish();
+			delete pLoad;
+		}
+
+		if( retcode == SQLITE_DONE ) {
+			retcode = SQLITE_OK;
+		}
+
+	}
+
+	sqlite3_close(pFile);
+
+	if( retcode != SQLITE_OK ) {
+		if( this->m_pDatabase ) this->close();
+		return retcode;
+	}
+
+	// Read only files are loaded but never written back
+	if( flags & SQLITE_OPEN_READWRITE ) {
+		this->m_pszSnapshotFile = strdup(fileName);
+	}
+
+	this->m_dSnapshotInterval = snapshotInterval;
+	this->m_dLastSnapshot = GetTimeMilliseconds();
+	this->m_dLastSnapshotAttempt = this->m_dLastSnapshot;
+	this->m_iSnapshotChanges = sqlite3_total_changes(this->m_pDatabase);
+	this->m_iSnapshotVersion = this->getDataVersion();
+
+	return SQLITE_OK;
+
+}
+
+bool CDatabase::isInMemory(void)
+{
+	return ( this->m_pszSnapshotFile != NULL );
+}
+
+
+int CDatabase::startSnapshot(void)
+{
+
+	if( this->m_pSnapshot ) return SQLITE_OK;
+
+	this->m_dLastSnapshotAttempt = GetTimeMilliseconds();
+
+	sqlite3* pFile = NULL;
+	int retcode = sqlite3_open_v2(this->m_pszSnapshotFile, &pFile, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+
+	if( retcode != SQLITE_OK ) {
+		sqlite3_close(pFile);
+		this->m_iSnapshotResult = retcode;
+		this->m_iNumSnapshotFailures++;
+		return retcode;
+	}
+
+	retcode = CBackup::create(&this->m_pSnapshot, pFile, "main", this->m_pDatabase, "main", true, SNAPSHOT_PAGES_PER_STEP);
+
+	// The changes only count as written once the backup is done, see stepSnapshot
+	if( retcode == SQLITE_OK ) {
+		this->m_dSnapshotStarted = this->m_dLastSnapshotAttempt;
+		this->m_iSnapshotStartChanges = sqlite3_total_changes(this->m_pDatabase);
+		this->m_iSnapshotStartVersion = this->getDataVersion();
+	} else {
+		this->m_iSnapshotResult = retcode;
+		this->m_iNumSnapshotFailures++;
+	}
+
+	return retcode;
+
+}
+
+// Writes made through this connection while a snapshot is in progress are carried along by SQLite
+int CDatabase::stepSnapshot(int pages)
+{
+
+	if( !this->m_pSnapshot ) return SQLITE_ERROR;
+
+	int retcode = this->m_pSnapshot->step(pages);
+
+	if( retcode == SQLITE_OK || retcode == SQLITE_BUSY || retcode == SQLITE_LOCKED ) {
+		return retcode;
+	}
+
+	this->m_pSnapshot->finish();
+	delete this->m_pSnapshot;
+	this->m_pSnapshot = NULL;
+
+	if( retcode == SQLITE_DONE ) {
+		double now = GetTimeMilliseconds();
+		this->m_dLastSnapshotDuration = now - this->m_dSnapshotStarted;
+		this->m_dLastSnapshot = now;
+		this->m_iSnapshotChanges = this->m_iSnapshotStartChanges;
+		this->m_iSnapshotVersion = this->m_iSnapshotStartVersion;
+		this->m_iSnapshotResult = SQLITE_OK;
+		this->m_iNumSnapshots++;
+	} else {
+		// The database stays dirty, think tries again after another interval
+		this->m_iSnapshotResult = retcode;
+		this->m_iNumSnapshotFailures++;
+	}
+
+	return retcode;
+
+}
+
+// Blocks until the whole database has been written
+int CDatabase::snapshot(void)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( !this->m_pszSnapshotFile ) return SQLITE_MISUSE;
+
+	int retcode = this->startSnapshot();
+	if( retcode != SQLITE_OK ) return retcode;
+
+	while( ( retcode = this->stepSnapshot(-1) ) == SQLITE_BUSY || retcode == SQLITE_LOCKED ) {
+		ThreadSleep(1);
+	}
+
+	return ( retcode == SQLITE_DONE ) ? SQLITE_OK : retcode;
+
+}
+
+
+// Seconds since the last completed snapshot
+double CDatabase::getSnapshotLag(void)
+{
+	if( !this->m_pszSnapshotFile ) return 0.0;
+	return ( GetTimeMilliseconds() - this->m_dLastSnapshot ) / 1000.0;
+}
+
+// Changes not yet written by a completed snapshot
+int CDatabase::getSnapshotChanges(void)
+{
+	VALIDATE_DATABASE(0);
+	return sqlite3_total_changes(this->m_pDatabase) - this->m_iSnapshotChanges;
+}
+
+// Anything committed since the last completed snapshot, including schema changes that total_changes does not count
+bool CDatabase::isSnapshotDirty(void)
+{
+	VALIDATE_DATABASE(false);
+	return ( this->getSnapshotChanges() > 0 || this->getDataVersion() != this->m_iSnapshotVersion );
+}
+
+// Unlike PRAGMA data_version this also moves for commits made by this connection
+unsigned int CDatabase::getDataVersion(void)
+{
+	unsigned int version = 0;
+	if( sqlite3_file_control(this->m_pDatabase, "main", SQLITE_FCNTL_DATA_VERSION, &version) != SQLITE_OK ) {
+		return 0;
+	}
+	return version;
+}
+
+// Milliseconds the last snapshot took from start to finish
+double CDatabase::getSnapshotDuration(void)
+{
+	return this->m_dLastSnapshotDuration;
+}
+
+int CDatabase::getNumSnapshots(void)
+{
+	return this->m_iNumSnapshots;
+}
+
+int CDatabase::getNumSnapshotFailures(void)
+{
+	return this->m_iNumSnapshotFailures;
+}
+
+// Result of the last snapshot that was started, SQLITE_OK once one completes
+int CDatabase::getSnapshotResult(void)
+{
+	return this->m_iSnapshotResult;
+}
+
+bool CDatabase::isSnapshotting(void)
+{
+	return ( this->m_pSnapshot != NULL );
+}
+
+
+// Runs after every commit in WAL mode, walFrames is the size of the log so far
+int CDatabase::walHook(void* usrPtr, sqlite3* db, const char* dbName, int walFrames)
+{
+	CDatabase* pDatabase = (CDatabase*)usrPtr;
+	if( pDatabase->m_pCheckpointer && stricmp(dbName, "main") == 0 ) {
+		pDatabase->m_pCheckpointer->noteCommit(walFrames);
+	}
+	return SQLITE_OK;
+}
+
+// Moves checkpointing of the main database onto a background connection, which needs the database to be in WAL mode.
+// Every intervalMs the thread runs a PASSIVE checkpoint if anything was committed, once nothing has been committed for
+// idleMs it runs a TRUNCATE checkpoint instead so the WAL file does not stay at its largest size.
+int CDatabase::startCheckpointer(int intervalMs, int idleMs)
+{
+
+	VALIDATE_DATABASE(SQLITE_ERROR);
+
+	if( this->m_pCheckpointer ) return SQLITE_MISUSE;
+
+	const char* pszFileName = sqlite3_db_filename(this->m_pDatabase, "main");
+	if( !pszFileName || !*pszFileName ) return SQLITE_MISUSE;
+
+	sqlite3_stmt* pStmt = NULL;
+	bool wal = false;
+
+	if( sqlite3_prepare_v2(this->m_pDatabase, "PRAGMA journal_mode;", -1, &pStmt, NULL) == SQLITE_OK && sqlite3_step(pStmt) == SQLITE_ROW ) {
+		const char* pszMode = (const char*)sqlite3_column_text(pStmt, 0);
+		wal = ( pszMode && stricmp(pszMode, "wal") == 0 );
+	}
+	sqlite3_finalize(pStmt);
+
+	if( !wal ) return SQLITE_MISUSE;
+
+	int retcode = CCheckpointer::create(&this->m_pCheckpointer, pszFileName, intervalMs, idleMs);
+	if( retcode != SQLITE_OK ) return retcode;
+
+	retcode = this->m_pCheckpointer->start();
+
+	if( retcode != SQLITE_OK ) {
+		delete this->m_pCheckpointer;
+		this->m_pCheckpointer = NULL;
+		return retcode;
+	}
+
+	// sqlite3_wal_autocheckpoint installs a wal hook of its own, so ours has to go in after it
+	sqlite3_wal_autocheckpoint(this->m_pDatabase, 0);
+	sqlite3_wal_hook(this->m_pDatabase, CDatabase::walHook, this);
+
+	return SQLITE_OK;
+
+}
+
+// Hands checkpointing back to SQLite's default of every 1000 pages
+void CDatabase::stopCheckpointer(void)
+{
+
+	if( !this->m_pCheckpointer ) return;
+
+	if( this->m_pDatabase ) {
+		sqlite3_wal_autocheckpoint(this->m_pDatabase, 1000);
+	}
+
+	delete this->m_pCheckpointer;
+	this->m_pCheckpointer = NULL;
+
+}
+
+CCheckpointer* CDatabase::getCheckpointer(void)
+{
+	return this->m_pCheckpointer;
+}
+
+
+// Called once per tick for every open database
+void CDatabase::think(void)
+{
+
+	this->m_bThinking = true;
+
+	if( this->m_pFirstDeferred ) {
+		if( this->m_bBatching ) {
+			this->flushBatch();
+		} else {
+			this->pumpDeferred();
+		}
+	}
+
+	if( this->m_iMemoryLimit > 0 && this->m_pDatabase && sqlite3_memory_used() > this->m_iMemoryLimit ) {
+		double now = GetTimeMilliseconds();
+		if( now - this->m_dLastRelease >= MEMORY_RELEASE_INTERVAL ) {
+			int freed = 0;
+			this->releaseMemory(&freed);
+			this->m_dLastRelease = now;
+			if( freed > 0 ) this->m_iNumEvictions++;
+		}
+	}
+
+	if( this->m_pszSnapshotFile ) {
+
+		if( this->m_pSnapshot ) {
+			this->stepSnapshot(SNAPSHOT_PAGES_PER_STEP);
+		} else if( this->m_dSnapshotInterval > 0.0 && this->isSnapshotDirty()
+			&& ( GetTimeMilliseconds() - this->m_dLastSnapshotAttempt ) / 1000.0 >= this->m_dSnapshotInterval ) {
+			if( this->startSnapshot() == SQLITE_OK ) {
+				this->stepSnapshot(SNAPSHOT_PAGES_PER_STEP);
+			}
+		}
+
+	}
+
+	// Only let go once the callbacks are done with this, dropping the reference can't collect anything by itself
+	this->m_bThinking = false;
+	if( !this->m_pFirstDeferred ) this->releaseQueue();
+
+}
+
+void CDatabase::closeAll(void)
+{
+	while( s_pFirstOpen ) {
+		CDatabase* pDatabase = s_pFirstOpen;
+		while( pDatabase->m_pFirstBlob ) {
+			pDatabase->m_pFirstBlob->close();
+		}
+		pDatabase->close();
+	}
+}
+
+// The list is walked again from the start after every think, whatever the callbacks closed is no longer on it
+void CDatabase::thinkAll(void)
+{
+	s_iThinkTick++;
+	CDatabase* pDatabase = s_pFirstOpen;
+	while( pDatabase ) {
+		if( pDatabase->m_iThinkTick == s_iThinkTick ) {
+			pDatabase = pDatabase->m_pNextOpen;
+			continue;
+		}
+		pDatabase->m_iThinkTick = s_iThinkTick;
+		pDatabase->think();
+		pDatabase = s_pFirstOpen;
+	}
+}
@@ -0,0 +1,219 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "function.h"
+#include "int64.h"
+#include <math.h>
+
+// Doubles beyond this can not be converted to a 64 bit integer
+#define INT64_DOUBLE_LIMIT 9.2e18
+
+CFunction::CFunction(ILuaObject* function)
+{
+	this->m_pFunction = function;
+	this->m_pStep = NULL;
+	this->m_pFinal = NULL;
+}
+
+CFunction::CFunction(ILuaObject* step, ILuaObject* final)
+{
+	this->m_pFunction = NULL;
+	this->m_pStep = step;
+	this->m_pFinal = final;
+}
+
+CFunction::~CFunction(void)
+{
+	SAFE_UNREF(this->m_pFunction);
+	SAFE_UNREF(this->m_pStep);
+	SAFE_UNREF(this->m_pFinal);
+}
+
+
+bool CFunction::isAggregate(void)
+{
+	return ( this->m_pStep != NULL );
+}
+
+
+void CFunction::pushArguments(int argc, sqlite3_value** argv)
+{
+	for( int i = 0; i < argc; i++ ) {
+		switch( sqlite3_value_type(argv[i]) ) {
+		case SQLITE_INTEGER:
+			LuaPushInteger(sqlite3_value_int64(argv[i]));
+			break;
+		case SQLITE_FLOAT:
+			g_pLua->Push((float)sqlite3_value_double(argv[i]));
+			break;
+		case SQLITE_TEXT:
+		case SQLITE_BLOB:
+			// The pointer has to be fetched before the length, see sqlite3_value_bytes
+			{
+				const char* pszValue = (const char*)sqlite3_value_blob(argv[i]);
+				int length = sqlite3_value_bytes(argv[i]);
+				g_pLua->Push(pszValue ? pszValue : "", (unsigned int)length);
+			}
+			break;
+		default:
+			g_pLua->PushNil();
+			break;
+		}
+	}
+}
+
+bool CFunction::setResult(sqlite3_context* context, ILuaObject* result)
+{
+
+	switch( result ? result->GetType() : GLua::TYPE_NIL ) {
+	case GLua::TYPE_NIL:
+		sqlite3_result_null(context);
+		return true;
+	case GLua::TYPE_NUMBER:
+		{
+			// Whole numbers go back as integers so comparisons against INTEGER columns keep working
+			double value = result->GetDouble();
+			if( value == floor(value) && fabs(value) < INT64_DOUBLE_LIMIT ) {
+				sqlite3_result_int64(context, (sqlite3_int64)value);
+			} else {
+				sqlite3_result_double(context, value);
+			}
+		}
+		return true;
+	case GLua::TYPE_BOOL:
+		sqlite3_result_int(context, result->GetBool() ? 1 : 0);
+		return true;
+	case GLua::TYPE_STRING:
+		sqlite3_result_text(context, result->GetString(), -1, SQLITE_TRANSIENT);
+		return true;
+	}
+
+	return false;
+
+}
+
+void CFunction::xFunc(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+
+	CFunction* pFunction = (CFunction*)sqlite3_user_data(context);
+
+	pFunction->m_pFunction->Push();
+	pushArguments(argc, argv);
+
+	if( !g_pLua->Call(argc, 1) ) {
+		sqlite3_result_error(context, "lua function failed", -1);
+		return;
+	}
+
+	ILuaObject* pResult = g_pLua->GetReturn(0);
+
+	if( !setResult(context, pResult) ) {
+		sqlite3_result_error(context, "lua function returned an unsupported type", -1);
+	}
+
+	SAFE_UNREF(pResult);
+
+}
+
+// The running state of every group lives in its aggregate context as a Lua reference
+void CFunction::xStep(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+
+	CFunction* pFunction = (CFunction*)sqlite3_user_data(context);
+
+	ILuaObject** ppState = (ILuaObject**)sqlite3_aggregate_context(context, sizeof(ILuaObject*));
+
+	if( !ppState ) {
+		sqlite3_result_error_nomem(context);
+		return;
+	}
+
+	pFunction->m_pStep->Push();
+
+	if( *ppState ) {
+		g_pLua->Push(*ppState);
+	} else {
+		g_pLua->PushNil();
+	}
+
+	pushArguments(argc, argv);
+
+	if( !g_pLua->Call(argc + 1, 1) ) {
+		sqlite3_result_error(context, "lua step function failed", -1);
+		return;
+	}
+
+	SAFE_UNREF((*ppState));
+	*ppState = g_pLua->GetReturn(0);
+
+}
+
+void CFunction::xFinal(sqlite3_context* context)
+{
+
+	CFunction* pFunction = (CFunction*)sqlite3_user_data(context);
+
+	// No rows means no context was ever allocated, final still gets called with a nil state
+	ILuaObject** ppState = (ILuaObject**)sqlite3_aggregate_context(context, 0);
+	ILuaObject* pState = ppState ? *ppState : NULL;
+
+	if( !pFunction->m_pFinal ) {
+
+		if( !setResult(context, pState) ) {
+			sqlite3_result_error(context, "lua aggregate state is an unsupported type", -1);
+		}
+
+	} else {
+
+		pFunction->m_pFinal->Push();
+
+		if( pState ) {
+			g_pLua->Push(pState);
+		} else {
+			g_pLua->PushNil();
+		}
+
+		if( g_pLua->Call(1, 1) ) {
+
+			ILuaObject* pResult = g_pLua->GetReturn(0);
+
+			if( !setResult(context, pResult) ) {
+				sqlite3_result_error(context, "lua final function returned an unsupported type", -1);
+			}
+
+			SAFE_UNREF(pResult);
+
+		} else {
+			sqlite3_result_error(context, "lua final function failed", -1);
+		}
+
+	}
+
+	if( ppState ) {
+		SAFE_UNREF((*ppState));
+	}
+
+}
+
+void CFunction::xDestroy(void* usrPtr)
+{
+	delete (CFunction*)usrPtr;
+}
@@ -0,0 +1,183 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "int64.h"
+
+#define INT64_MAX_VALUE ((sqlite3_int64)(((sqlite3_uint64)1 << 63) - 1))
+#define INT64_MIN_VALUE (-INT64_MAX_VALUE - 1)
+
+const char* Int64ToString(sqlite3_int64 value, char* buffer)
+{
+
+	char digits[INT64_STRING_LENGTH];
+	int numDigits = 0;
+
+	// Work with the negative magnitude so the smallest value doesn't overflow
+	bool negative = ( value < 0 );
+	sqlite3_int64 remaining = negative ? value : -value;
+
+	do {
+		digits[numDigits++] = (char)('0' - (int)(remaining % 10));
+		remaining /= 10;
+	} while( remaining != 0 );
+
+	int length = 0;
+
+	if( negative ) {
+		buffer[length++] = '-';
+	}
+
+	while( numDigits > 0 ) {
+		buffer[length++] = digits[--numDigits];
+	}
+
+	buffer[length] = '\0';
+	return buffer;
+
+}
+
+bool StringToInt64(const char* string, sqlite3_int64* value)
+{
+
+	if( !string || !value ) return false;
+
+	while( *string == ' ' || *string == '\t' ) string++;
+
+	bool negative = false;
+	if( *string == '-' || *string == '+' ) {
+		negative = ( *string == '-' );
+		string++;
+	}
+
+	if( *string < '0' || *string > '9' ) return false;
+
+	// Accumulate negatively for the same reason as above
+	const sqlite3_int64 limit = negative ? INT64_MIN_VALUE : -INT64_MAX_VALUE;
+	sqlite3_int64 result = 0;
+
+	for( ; *string >= '0' && *string <= '9'; string++ ) {
+
+		int digit = *string - '0';
+
+		if( result < ( limit + digit ) / 10 ) return false;
+
+		result = result * 10 - digit;
+
+	}
+
+	if( *string != '\0' ) return false;
+
+	*value = negative ? result : -result;
+	return true;
+
+}
+
+
+bool LuaGetInt64(int stackPos, sqlite3_int64* value)
+{
+
+	if( g_pLua->GetType(stackPos) == GLua::TYPE_STRING ) {
+		return StringToInt64(g_pLua->GetString(stackPos), value);
+	}
+
+	if( g_pLua->GetType(stackPos) == GLua::TYPE_NUMBER ) {
+
+		double number = g_pLua->GetNumber(stackPos);
+
+		// 2^63 is exactly representable as a double, anything at or past it is not
+		if( !( number < 9223372036854775808.0 && number >= -9223372036854775808.0 ) ) {
+			return false;
+		}
+
+		*value = (sqlite3_int64)number;
+		return true;
+
+	}
+
+	return false;
+
+}
+
+sqlite3_int64 LuaCheckInt64(int stackPos)
+{
+
+	sqlite3_int64 value = 0;
+	bool valid = LuaGetInt64(stackPos, &value);
+
+	// LuaGetInt64 truncates fractions, which would quietly turn 0.5 into 0
+	if( valid && g_pLua->GetType(stackPos) == GLua::TYPE_NUMBER && (double)value != g_pLua->GetNumber(stackPos) ) {
+		valid = false;
+	}
+
+	if( !valid ) {
+		g_pLua->TypeError("integer", stackPos);
+		return 0;
+	}
+
+	return value;
+
+}
+
+void LuaPushInt64(sqlite3_int64 value)
+{
+	char buffer[INT64_STRING_LENGTH];
+	g_pLua->Push((const char*)Int64ToString(value, buffer));
+}
+
+void LuaSetMemberInt64(ILuaObject* table, float key, sqlite3_int64 value)
+{
+	char buffer[INT64_STRING_LENGTH];
+	table->SetMember(key, (const char*)Int64ToString(value, buffer));
+}
+
+void LuaSetMemberInt64(ILuaObject* table, const char* key, sqlite3_int64 value)
+{
+	char buffer[INT64_STRING_LENGTH];
+	table->SetMember(key, (const char*)Int64ToString(value, buffer));
+}
+
+
+void LuaPushInteger(sqlite3_int64 value)
+{
+	if( value >= -INT64_FLOAT_EXACT && value <= INT64_FLOAT_EXACT ) {
+		g_pLua->Push((float)value);
+	} else {
+		LuaPushInt64(value);
+	}
+}
+
+void LuaSetMemberInteger(ILuaObject* table, float key, sqlite3_int64 value)
+{
+	if( value >= -INT64_FLOAT_EXACT && value <= INT64_FLOAT_EXACT ) {
+		table->SetMember(key, (float)value);
+	} else {
+		LuaSetMemberInt64(table, key, value);
+	}
+}
+
+void LuaSetMemberInteger(ILuaObject* table, const char* key, sqlite3_int64 value)
+{
+	if( value >= -INT64_FLOAT_EXACT && value <= INT64_FLOAT_EXACT ) {
+		table->SetMember(key, (float)value);
+	} else {
+		LuaSetMemberInt64(table, key, value);
+	}
+}
@@ -0,0 +1,606 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "json.h"
+#include "int64.h"
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// Table walking
+//-----------------------------------------------------------------------------
+
+bool LuaTableWalkBegin(ILuaObject* table, LuaTableWalk* walk)
+{
+
+	walk->pMembers = table->GetMembers();
+	walk->ppValues = NULL;
+	walk->iCount = 0;
+
+	if( !walk->pMembers ) return false;
+
+	int count = walk->iCount = walk->pMembers->Count();
+
+	// An array needs every key to be an integer between 1 and the number of members
+	bool isArray = ( count > 0 );
+	for( int i = 0; i < count && isArray; i++ ) {
+		ILuaObject* pKey = walk->pMembers->Element(i).pKey;
+		if( !pKey->isNumber() ) {
+			isArray = false;
+		} else {
+			double key = pKey->GetDouble();
+			isArray = ( key == floor(key) && key >= 1 && key <= count );
+		}
+	}
+
+	if( !isArray ) return true;
+
+	// Members come back in hash order, so they are put in place by index first
+	walk->ppValues = (ILuaObject**)sqlite3_malloc(sizeof(ILuaObject*) * count);
+	if( !walk->ppValues ) {
+		LuaTableWalkEnd(walk);
+		return false;
+	}
+
+	for( int i = 0; i < count; i++ ) walk->ppValues[i] = NULL;
+	for( int i = 0; i < count; i++ ) {
+		LuaKeyValue& member = walk->pMembers->Element(i);
+		walk->ppValues[(int)member.pKey->GetDouble() - 1] = member.pValue;
+	}
+
+	return true;
+
+}
+
+void LuaTableWalkEnd(LuaTableWalk* walk)
+{
+	sqlite3_free(walk->ppValues);
+	walk->ppValues = NULL;
+	if( walk->pMembers ) {
+		g_pLua->DeleteLuaVector(walk->pMembers);
+		walk->pMembers = NULL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Strings
+//-----------------------------------------------------------------------------
+
+const char* LuaObjectString(ILuaObject* value, unsigned int* length)
+{
+	value->Push();
+	const char* pszValue = g_pLua->GetString(g_pLua->Top(), length);
+	g_pLua->Pop();
+	return pszValue;
+}
+
+ILuaObject* LuaNewString(const char* value, unsigned int length)
+{
+	// A length of 0 makes Push measure the string itself
+	g_pLua->Push(length ? value : "", length);
+	ILuaObject* pString = g_pLua->GetObject(g_pLua->Top());
+	g_pLua->Pop();
+	return pString;
+}
+
+//-----------------------------------------------------------------------------
+// Encoding
+//-----------------------------------------------------------------------------
+
+// NULs come out as \u0000 like any other control character
+static void JsonEncodeString(const char* value, unsigned int length, sqlite3_str* out)
+{
+
+	sqlite3_str_appendchar(out, 1, '"');
+
+	const unsigned char* pEnd = (const unsigned char*)value + length;
+
+	for( const unsigned char* p = (const unsigned char*)value; p < pEnd; p++ ) {
+		switch( *p ) {
+		case '"':	sqlite3_str_appendall(out, "\\\""); break;
+		case '\\':	sqlite3_str_appendall(out, "\\\\"); break;
+		case '\b':	sqlite3_str_appendall(out, "\\b"); break;
+		case '\f':	sqlite3_str_appendall(out, "\\f"); break;
+		case '\n':	sqlite3_str_appendall(out, "\\n"); break;
+		case '\r':	sqlite3_str_appendall(out, "\\r"); break;
+		case '\t':	sqlite3_str_appendall(out, "\\t"); break;
+		default:
+			if( *p < 0x20 ) {
+				sqlite3_str_appendf(out, "\\u%04x", *p);
+			} else {
+				sqlite3_str_appendchar(out, 1, (char)*p);
+			}
+			break;
+		}
+	}
+
+	sqlite3_str_appendchar(out, 1, '"');
+
+}
+
+static void JsonEncodeNumber(double value, sqlite3_str* out)
+{
+	// JSON has no representation for these
+	if( value != value || value - value != 0.0 ) {
+		sqlite3_str_appendall(out, "null");
+	} else if( value == floor(value) && fabs(value) < 1e15 ) {
+		sqlite3_str_appendf(out, "%lld", (sqlite3_int64)value);
+	} else {
+		sqlite3_str_appendf(out, "%.17g", value);
+	}
+}
+
+static bool JsonEncodeValue(ILuaObject* value, sqlite3_str* out, int depth);
+
+static bool JsonEncodeTable(ILuaObject* table, sqlite3_str* out, int depth)
+{
+
+	if( depth > JSON_MAX_DEPTH ) return false;
+
+	LuaTableWalk walk;
+	if( !LuaTableWalkBegin(table, &walk) ) return false;
+
+	CUtlLuaVector* pMembers = walk.pMembers;
+	int count = walk.iCount;
+	bool valid = true;
+
+	if( walk.ppValues ) {
+
+		sqlite3_str_appendchar(out, 1, '[');
+		for( int i = 0; i < count && valid; i++ ) {
+			if( i ) sqlite3_str_appendchar(out, 1, ',');
+			valid = walk.ppValues[i] ? JsonEncodeValue(walk.ppValues[i], out, depth + 1) : false;
+		}
+		sqlite3_str_appendchar(out, 1, ']');
+
+	} else {
+
+		sqlite3_str_appendchar(out, 1, '{');
+
+		for( int i = 0; i < count && valid; i++ ) {
+
+			LuaKeyValue& member = pMembers->Element(i);
+
+			if( i ) sqlite3_str_appendchar(out, 1, ',');
+
+			if( member.pKey->isString() ) {
+				unsigned int length = 0;
+				const char* pszKey = LuaObjectString(member.pKey, &length);
+				JsonEncodeString(pszKey ? pszKey : "", length, out);
+			} else if( member.pKey->isNumber() ) {
+				sqlite3_str_appendchar(out, 1, '"');
+				JsonEncodeNumber(member.pKey->GetDouble(), out);
+				sqlite3_str_appendchar(out, 1, '"');
+			} else {
+				valid = false;
+				break;
+			}
+
+			sqlite3_str_appendchar(out, 1, ':');
+			valid = JsonEncodeValue(member.pValue, out, depth + 1);
+
+		}
+
+		sqlite3_str_appendchar(out, 1, '}');
+
+	}
+
+	LuaTableWalkEnd(&walk);
+	return valid;
+
+}
+
+static bool JsonEncodeValue(ILuaObject* value, sqlite3_str* out, int depth)
+{
+
+	switch( value ? value->GetType() : GLua::TYPE_NIL ) {
+	case GLua::TYPE_NIL:
+		sqlite3_str_appendall(out, "null");
+		return true;
+	case GLua::TYPE_BOOL:
+		sqlite3_str_appendall(out, value->GetBool() ? "true" : "false");
+		return true;
+	case GLua::TYPE_NUMBER:
+		JsonEncodeNumber(value->GetDouble(), out);
+		return true;
+	case GLua::TYPE_STRING:
+		{
+			unsigned int length = 0;
+			const char* pszValue = LuaObjectString(value, &length);
+			JsonEncodeString(pszValue ? pszValue : "", length, out);
+		}
+		return true;
+	case GLua::TYPE_TABLE:
+		return JsonEncodeTable(value, out, depth);
+	}
+
+	return false;
+
+}
+
+bool JsonEncode(ILuaObject* value, sqlite3_str* out)
+{
+	if( !out ) return false;
+	return JsonEncodeValue(value, out, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Decoding
+//-----------------------------------------------------------------------------
+
+struct JsonParser
+{
+	const char* pCur;
+	const char* pEnd;
+	sqlite3_str* pString;	// scratch space for unescaped strings
+	int iDepth;
+};
+
+// Values are stored straight into their parent table under either a string key or an array index
+struct JsonTarget
+{
+	ILuaObject* pTable;
+	const char* pszKey;
+	int iIndex;
+};
+
+static void JsonSkipSpace(JsonParser* parser)
+{
+	while( parser->pCur < parser->pEnd && ( *parser->pCur == ' ' || *parser->pCur == '\t' || *parser->pCur == '\n' || *parser->pCur == '\r' ) ) {
+		parser->pCur++;
+	}
+}
+
+static bool JsonMatch(JsonParser* parser, const char* literal)
+{
+	size_t length = strlen(literal);
+	if( (size_t)( parser->pEnd - parser->pCur ) < length || strncmp(parser->pCur, literal, length) != 0 ) return false;
+	parser->pCur += length;
+	return true;
+}
+
+static int JsonHexDigit(char c)
+{
+	if( c >= '0' && c <= '9' ) return c - '0';
+	if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+	if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+	return -1;
+}
+
+static bool JsonReadHex4(JsonParser* parser, unsigned int* value)
+{
+	if( parser->pEnd - parser->pCur < 4 ) return false;
+	*value = 0;
+	for( int i = 0; i < 4; i++ ) {
+		int digit = JsonHexDigit(parser->pCur[i]);
+		if( digit < 0 ) return false;
+		*value = ( *value << 4 ) | (unsigned int)digit;
+	}
+	parser->pCur += 4;
+	return true;
+}
+
+static void JsonAppendUtf8(sqlite3_str* out, unsigned int code)
+{
+	if( code < 0x80 ) {
+		sqlite3_str_appendchar(out, 1, (char)code);
+	} else if( code < 0x800 ) {
+		sqlite3_str_appendchar(out, 1, (char)( 0xC0 | ( code >> 6 ) ));
+		sqlite3_str_appendchar(out, 1, (char)( 0x80 | ( code & 0x3F ) ));
+	} else if( code < 0x10000 ) {
+		sqlite3_str_appendchar(out, 1, (char)( 0xE0 | ( code >> 12 ) ));
+		sqlite3_str_appendchar(out, 1, (char)( 0x80 | ( ( code >> 6 ) & 0x3F ) ));
+		sqlite3_str_appendchar(out, 1, (char)( 0x80 | ( code & 0x3F ) ));
+	} else {
+		sqlite3_str_appendchar(out, 1, (char)( 0xF0 | ( code >> 18 ) ));
+		sqlite3_str_appendchar(out, 1, (char)( 0x80 | ( ( code >> 12 ) & 0x3F ) ));
+		sqlite3_str_appendchar(out, 1, (char)( 0x80 | ( ( code >> 6 ) & 0x3F ) ));
+		sqlite3_str_appendchar(out, 1, (char)( 0x80 | ( code & 0x3F ) ));
+	}
+}
+
+// Leaves the unescaped string in parser->pString, the opening quote has to be current
+static bool JsonReadString(JsonParser* parser)
+{
+
+	sqlite3_str_reset(parser->pString);
+	parser->pCur++;
+
+	while( parser->pCur < parser->pEnd ) {
+
+		char c = *parser->pCur++;
+
+		if( c == '"' ) return ( sqlite3_str_errcode(parser->pString) == SQLITE_OK );
+
+		if( c != '\\' ) {
+			sqlite3_str_appendchar(parser->pString, 1, c);
+			continue;
+		}
+
+		if( parser->pCur >= parser->pEnd ) return false;
+
+		switch( *parser->pCur++ ) {
+		case '"':	sqlite3_str_appendchar(parser->pString, 1, '"'); break;
+		case '\\':	sqlite3_str_appendchar(parser->pString, 1, '\\'); break;
+		case '/':	sqlite3_str_appendchar(parser->pString, 1, '/'); break;
+		case 'b':	sqlite3_str_appendchar(parser->pString, 1, '\b'); break;
+		case 'f':	sqlite3_str_appendchar(parser->pString, 1, '\f'); break;
+		case 'n':	sqlite3_str_appendchar(parser->pString, 1, '\n'); break;
+		case 'r':	sqlite3_str_appendchar(parser->pString, 1, '\r'); break;
+		case 't':	sqlite3_str_appendchar(parser->pString, 1, '\t'); break;
+		case 'u':
+			{
+				unsigned int code = 0;
+				if( !JsonReadHex4(parser, &code) ) return false;
+
+				// Characters outside the BMP come as a surrogate pair
+				if( code >= 0xD800 && code <= 0xDBFF ) {
+					unsigned int low = 0;
+					if( !JsonMatch(parser, "\\u") || !JsonReadHex4(parser, &low) || low < 0xDC00 || low > 0xDFFF ) return false;
+					code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+				}
+
+				JsonAppendUtf8(parser->pString, code);
+			}
+			break;
+		default:
+			return false;
+		}
+
+	}
+
+	return false;
+
+}
+
+static bool JsonParseValue(JsonParser* parser, const JsonTarget& target);
+
+static void JsonSetInteger(const JsonTarget& target, sqlite3_int64 value)
+{
+	if( target.pszKey ) {
+		LuaSetMemberInteger(target.pTable, target.pszKey, value);
+	} else {
+		LuaSetMemberInteger(target.pTable, (float)target.iIndex, value);
+	}
+}
+
+static void JsonSetNumber(const JsonTarget& target, double value)
+{
+	if( target.pszKey ) {
+		target.pTable->SetMember(target.pszKey, (float)value);
+	} else {
+		target.pTable->SetMember((float)target.iIndex, (float)value);
+	}
+}
+
+static void JsonSetBool(const JsonTarget& target, bool value)
+{
+	if( target.pszKey ) {
+		target.pTable->SetMember(target.pszKey, value);
+	} else {
+		target.pTable->SetMember((float)target.iIndex, value);
+	}
+}
+
+static void JsonSetObject(const JsonTarget& target, ILuaObject* value)
+{
+	if( target.pszKey ) {
+		target.pTable->SetMember(target.pszKey, value);
+	} else {
+		target.pTable->SetMember((float)target.iIndex, value);
+	}
+}
+
+static bool JsonParseArray(JsonParser* parser, const JsonTarget& target)
+{
+
+	ILuaObject* pTable = g_pLua->GetNewTable();
+	if( !pTable ) return false;
+
+	parser->pCur++;
+	JsonSkipSpace(parser);
+
+	bool valid = true;
+	int index = 1;
+
+	if( parser->pCur < parser->pEnd && *parser->pCur == ']' ) {
+		parser->pCur++;
+	} else {
+
+		for( ;; ) {
+
+			JsonTarget element = { pTable, NULL, index++ };
+
+			if( !JsonParseValue(parser, element) ) { valid = false; break; }
+
+			JsonSkipSpace(parser);
+			if( parser->pCur >= parser->pEnd ) { valid = false; break; }
+
+			char c = *parser->pCur++;
+			if( c == ']' ) break;
+			if( c != ',' ) { valid = false; break; }
+
+		}
+
+	}
+
+	if( valid ) JsonSetObject(target, pTable);
+
+	SAFE_UNREF(pTable);
+	return valid;
+
+}
+
+static bool JsonParseObject(JsonParser* parser, const JsonTarget& target)
+{
+
+	ILuaObject* pTable = g_pLua->GetNewTable();
+	if( !pTable ) return false;
+
+	parser->pCur++;
+	JsonSkipSpace(parser);
+
+	bool valid = true;
+
+	if( parser->pCur < parser->pEnd && *parser->pCur == '}' ) {
+		parser->pCur++;
+	} else {
+
+		for( ;; ) {
+
+			JsonSkipSpace(parser);
+			if( parser->pCur >= parser->pEnd || *parser->pCur != '"' || !JsonReadString(parser) ) { valid = false; break; }
+
+			// The scratch string gets reused by the value, so the key needs its own copy
+			char* pszKey = sqlite3_mprintf("%s", sqlite3_str_value(parser->pString) ? sqlite3_str_value(parser->pString) : "");
+			if( !pszKey ) { valid = false; break; }
+
+			JsonSkipSpace(parser);
+			if( parser->pCur >= parser->pEnd || *parser->pCur != ':' ) { sqlite3_free(pszKey); valid = false; break; }
+			parser->pCur++;
+
+			JsonTarget member = { pTable, pszKey, 0 };
+			valid = JsonParseValue(parser, member);
+			sqlite3_free(pszKey);
+
+			if( !valid ) break;
+
+			JsonSkipSpace(parser);
+			if( parser->pCur >= parser->pEnd ) { valid = false; break; }
+
+			char c = *parser->pCur++;
+			if( c == '}' ) break;
+			if( c != ',' ) { valid = false; break; }
+
+		}
+
+	}
+
+	if( valid ) JsonSetObject(target, pTable);
+
+	SAFE_UNREF(pTable);
+	return valid;
+
+}
+
+static bool JsonParseValue(JsonParser* parser, const JsonTarget& target)
+{
+
+	JsonSkipSpace(parser);
+	if( parser->pCur >= parser->pEnd ) return false;
+
+	switch( *parser->pCur ) {
+	case '{':
+	case '[':
+		{
+			if( ++parser->iDepth > JSON_MAX_DEPTH ) return false;
+			bool valid = ( *parser->pCur == '{' ) ? JsonParseObject(parser, target) : JsonParseArray(parser, target);
+			parser->iDepth--;
+			return valid;
+		}
+	case '"':
+		{
+			if( !JsonReadString(parser) ) return false;
+
+			// \u0000 may have put NULs in the string
+			ILuaObject* pString = LuaNewString(sqlite3_str_value(parser->pString), (unsigned int)sqlite3_str_length(parser->pString));
+			if( !pString ) return false;
+			JsonSetObject(target, pString);
+			SAFE_UNREF(pString);
+		}
+		return true;
+	case 't':
+		if( !JsonMatch(parser, "true") ) return false;
+		JsonSetBool(target, true);
+		return true;
+	case 'f':
+		if( !JsonMatch(parser, "false") ) return false;
+		JsonSetBool(target, false);
+		return true;
+	case 'n':
+		// Assigning nil is the same as leaving the member out
+		return JsonMatch(parser, "null");
+	}
+
+	// Copied out first since strtod needs a terminated string and the text might not be
+	char number[64];
+	int length = 0;
+
+	while( parser->pCur + length < parser->pEnd && length < (int)sizeof(number) - 1 && strchr("+-0123456789.eE", parser->pCur[length]) ) {
+		number[length] = parser->pCur[length];
+		length++;
+	}
+	number[length] = '\0';
+
+	if( length == 0 ) return false;
+
+	char* pEnd = NULL;
+	double value = strtod(number, &pEnd);
+	if( pEnd != number + length ) return false;
+
+	parser->pCur += length;
+
+	// Anything without a fraction or exponent that fits 64 bits is an integer
+	sqlite3_int64 integer = 0;
+	if( !strpbrk(number, ".eE") && StringToInt64(number, &integer) ) {
+		JsonSetInteger(target, integer);
+	} else {
+		JsonSetNumber(target, value);
+	}
+
+	return true;
+
+}
+
+ILuaObject* JsonDecode(const char* text, int length)
+{
+
+	if( !text ) return NULL;
+	if( length < 0 ) length = (int)strlen(text);
+
+	JsonParser parser;
+	parser.pCur = text;
+	parser.pEnd = text + length;
+	parser.pString = sqlite3_str_new(NULL);
+	parser.iDepth = 0;
+
+	// Scalars can only be read back out of a table, so everything is parsed into slot 1 of a holder
+	ILuaObject* pHolder = g_pLua->GetNewTable();
+	ILuaObject* pResult = NULL;
+
+	if( pHolder ) {
+
+		JsonTarget target = { pHolder, NULL, 1 };
+
+		if( JsonParseValue(&parser, target) ) {
+			JsonSkipSpace(&parser);
+			if( parser.pCur == parser.pEnd ) {
+				pResult = pHolder->GetMember(1.0f);
+			}
+		}
+
+	}
+
+	SAFE_UNREF(pHolder);
+	sqlite3_free(sqlite3_str_finish(parser.pString));
+
+	return pResult;
+
+}
@@ -0,0 +1,283 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "kvstore.h"
+#include "database.h"
+#include "statement.h"
+
+#define VALIDATE_KVSTORE(ret) if( !this->m_pGet || !this->m_pSet || !this->m_pDelete ) { return ret; }
+
+// The first version with RETURNING
+#define KVSTORE_RETURNING_VERSION 3035000
+
+CKVStore::CKVStore(void)
+{
+	this->m_pGet = NULL;
+	this->m_pSet = NULL;
+	this->m_pDelete = NULL;
+	this->m_pIncrement = NULL;
+	this->m_pInsertZero = NULL;
+	this->m_pAdd = NULL;
+	this->m_pDatabase = NULL;
+	this->m_pszName = NULL;
+	this->m_pBegin = NULL;
+	this->m_pCommit = NULL;
+	this->m_pRollback = NULL;
+}
+
+CKVStore::~CKVStore(void)
+{
+	// The statements are the store's own, even once the database has finalized them
+	CStatement* statements[] = { this->m_pGet, this->m_pSet, this->m_pDelete, this->m_pIncrement, this->m_pInsertZero, this->m_pAdd, this->m_pBegin, this->m_pCommit, this->m_pRollback };
+	for( int i = 0; i < (int)( sizeof(statements) / sizeof(statements[0]) ); i++ ) {
+		if( statements[i] ) { statements[i]->finalize(); delete statements[i]; }
+	}
+	sqlite3_free(this->m_pszName);
+}
+
+
+int CKVStore::create(CKVStore** store, CDatabase* database, const char* name)
+{
+
+	if( !store || !database || !name ) return SQLITE_ERROR;
+
+	*store = NULL;
+
+	char* pszSql = sqlite3_mprintf("CREATE TABLE IF NOT EXISTS \"%w\"(k TEXT PRIMARY KEY NOT NULL, v) WITHOUT ROWID;", name);
+	if( !pszSql ) return SQLITE_NOMEM;
+	int retcode = database->execute(pszSql);
+	sqlite3_free(pszSql);
+
+	if( retcode != SQLITE_OK ) return retcode;
+
+	CKVStore* pStore = new CKVStore();
+
+	pStore->m_pDatabase = database;
+	pStore->m_pszName = sqlite3_mprintf("%s", name);
+
+	if( !pStore->m_pszName ) {
+		delete pStore;
+		return SQLITE_NOMEM;
+	}
+
+	struct { CStatement** ppStmt; const char* pszFormat; } s_Statements[] = {
+		{ &pStore->m_pGet,			"SELECT v FROM \"%w\" WHERE k = ?;" },
+		{ &pStore->m_pSet,			"INSERT OR REPLACE INTO \"%w\"(k, v) VALUES(?, ?);" },
+		{ &pStore->m_pDelete,		"DELETE FROM \"%w\" WHERE k = ?;" },
+		{ &pStore->m_pBegin,		"SAVEPOINT kvstore;" },
+		{ &pStore->m_pCommit,		"RELEASE kvstore;" },
+		{ &pStore->m_pRollback,		"ROLLBACK TO kvstore;" },
+	};
+
+	for( int i = 0; i < (int)( sizeof(s_Statements) / sizeof(s_Statements[0]) ) && retcode == SQLITE_OK; i++ ) {
+		pszSql = sqlite3_mprintf(s_Statements[i].pszFormat, name);
+		retcode = pszSql ? database->prepare(s_Statements[i].ppStmt, pszSql) : SQLITE_NOMEM;
+		sqlite3_free(pszSql);
+	}
+
+	if( retcode != SQLITE_OK ) {
+		delete pStore;
+		return retcode;
+	}
+
+	*store = pStore;
+	return SQLITE_OK;
+
+}
+
+
+int CKVStore::bindValue(CStatement* stmt, int index, const KVValue& value)
+{
+	switch( value.iType ) {
+	case SQLITE_INTEGER:	return stmt->bindInt64(index, value.iInteger);
+	case SQLITE_FLOAT:		return stmt->bindDouble(index, value.dFloat);
+	case SQLITE_TEXT:		return stmt->bindText(index, value.pData, value.iLength);
+	case SQLITE_BLOB:		return stmt->bindBlob(index, value.pData, value.iLength);
+	}
+	return stmt->bindNull(index);
+}
+
+// Steps a statement that returns no rows and resets it
+int CKVStore::run(CStatement* stmt)
+{
+	if( !stmt ) return SQLITE_ERROR;
+	int retcode = stmt->step();
+	stmt->reset();
+	return ( retcode == SQLITE_DONE ) ? SQLITE_OK : retcode;
+}
+
+int CKVStore::get(const KVValue& key, KVCallback callback, void* usrPtr)
+{
+
+	VALIDATE_KVSTORE(SQLITE_ERROR);
+
+	int retcode = bindValue(this->m_pGet, 1, key);
+
+	if( retcode == SQLITE_OK ) {
+		retcode = this->m_pGet->step();
+		if( retcode == SQLITE_ROW ) {
+			callback(usrPtr, this->m_pGet);
+			retcode = SQLITE_DONE;
+		}
+	}
+
+	this->m_pGet->reset();
+
+	return ( retcode == SQLITE_DONE ) ? SQLITE_OK : retcode;
+
+}
+
+int CKVStore::set(const KVValue& key, const KVValue& value)
+{
+
+	VALIDATE_KVSTORE(SQLITE_ERROR);
+
+	int retcode = bindValue(this->m_pSet, 1, key);
+	if( retcode == SQLITE_OK ) retcode = bindValue(this->m_pSet, 2, value);
+	if( retcode == SQLITE_OK ) return run(this->m_pSet);
+
+	this->m_pSet->reset();
+	return retcode;
+
+}
+
+int CKVStore::remove(const KVValue& key)
+{
+
+	VALIDATE_KVSTORE(SQLITE_ERROR);
+
+	int retcode = bindValue(this->m_pDelete, 1, key);
+	if( retcode == SQLITE_OK ) return run(this->m_pDelete);
+
+	this->m_pDelete->reset();
+	return retcode;
+
+}
+
+// Once the database has closed the statements are finalized and the database may be gone, so nothing more is prepared
+int CKVStore::prepareIncrement(void)
+{
+
+	if( this->m_pIncrement || this->m_pAdd ) return SQLITE_OK;
+	if( this->m_pGet->isFinalized() ) return SQLITE_MISUSE;
+
+	int retcode = SQLITE_OK;
+	char* pszSql = NULL;
+
+	if( sqlite3_libversion_number() >= KVSTORE_RETURNING_VERSION ) {
+		pszSql = sqlite3_mprintf("INSERT INTO \"%w\"(k, v) VALUES(?1, ?2) ON CONFLICT(k) DO UPDATE SET v = coalesce(v, 0) + excluded.v RETURNING v;", this->m_pszName);
+		retcode = pszSql ? this->m_pDatabase->prepare(&this->m_pIncrement, pszSql) : SQLITE_NOMEM;
+		sqlite3_free(pszSql);
+		return retcode;
+	}
+
+	pszSql = sqlite3_mprintf("INSERT OR IGNORE INTO \"%w\"(k, v) VALUES(?1, 0);", this->m_pszName);
+	retcode = pszSql ? this->m_pDatabase->prepare(&this->m_pInsertZero, pszSql) : SQLITE_NOMEM;
+	sqlite3_free(pszSql);
+
+	if( retcode != SQLITE_OK ) return retcode;
+
+	pszSql = sqlite3_mprintf("UPDATE \"%w\" SET v = coalesce(v, 0) + ?2 WHERE k = ?1;", this->m_pszName);
+	retcode = pszSql ? this->m_pDatabase->prepare(&this->m_pAdd, pszSql) : SQLITE_NOMEM;
+	sqlite3_free(pszSql);
+
+	// Both or neither, so the next call tries again
+	if( retcode != SQLITE_OK ) {
+		this->m_pInsertZero->finalize();
+		delete this->m_pInsertZero;
+		this->m_pInsertZero = NULL;
+	}
+
+	return retcode;
+
+}
+
+int CKVStore::incrementInSavepoint(const KVValue& key, const KVValue& delta, KVCallback callback, void* usrPtr)
+{
+
+	int retcode = run(this->m_pBegin);
+	if( retcode != SQLITE_OK ) return retcode;
+
+	retcode = bindValue(this->m_pInsertZero, 1, key);
+	if( retcode == SQLITE_OK ) retcode = run(this->m_pInsertZero);
+	this->m_pInsertZero->reset();
+
+	if( retcode == SQLITE_OK ) retcode = bindValue(this->m_pAdd, 1, key);
+	if( retcode == SQLITE_OK ) retcode = bindValue(this->m_pAdd, 2, delta);
+	if( retcode == SQLITE_OK ) retcode = run(this->m_pAdd);
+	this->m_pAdd->reset();
+
+	if( retcode == SQLITE_OK && callback ) retcode = this->get(key, callback, usrPtr);
+
+	int endcode = this->endBatch(retcode == SQLITE_OK);
+	return ( retcode == SQLITE_OK ) ? endcode : retcode;
+
+}
+
+int CKVStore::increment(const KVValue& key, const KVValue& delta, KVCallback callback, void* usrPtr)
+{
+
+	VALIDATE_KVSTORE(SQLITE_ERROR);
+
+	int retcode = this->prepareIncrement();
+	if( retcode != SQLITE_OK ) return retcode;
+
+	if( !this->m_pIncrement ) return this->incrementInSavepoint(key, delta, callback, usrPtr);
+
+	retcode = bindValue(this->m_pIncrement, 1, key);
+	if( retcode == SQLITE_OK ) retcode = bindValue(this->m_pIncrement, 2, delta);
+
+	if( retcode == SQLITE_OK ) {
+		retcode = this->m_pIncrement->step();
+		if( retcode == SQLITE_ROW ) {
+			if( callback ) callback(usrPtr, this->m_pIncrement);
+			// RETURNING only finishes the write once the statement has run to the end
+			retcode = this->m_pIncrement->step();
+		}
+	}
+
+	this->m_pIncrement->reset();
+
+	return ( retcode == SQLITE_DONE ) ? SQLITE_OK : retcode;
+
+}
+
+
+int CKVStore::beginBatch(void)
+{
+	VALIDATE_KVSTORE(SQLITE_ERROR);
+	return run(this->m_pBegin);
+}
+
+// A rolled back savepoint still has to be released to end it
+int CKVStore::endBatch(bool commit)
+{
+
+	VALIDATE_KVSTORE(SQLITE_ERROR);
+
+	if( !commit ) {
+		int retcode = run(this->m_pRollback);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	return run(this->m_pCommit);
+
+}
@@ -0,0 +1,264 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "natives.h"
+#include <math.h>
+
+#ifdef SQLITE_INNOCUOUS
+#define NATIVE_FLAGS ( SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS )
+#else
+#define NATIVE_FLAGS ( SQLITE_UTF8 | SQLITE_DETERMINISTIC )
+#endif
+
+#define ASCII_LOWER(c) ( ( (c) >= 'A' && (c) <= 'Z' ) ? (c) + ( 'a' - 'A' ) : (c) )
+#define ASCII_DIGIT(c) ( (c) >= '0' && (c) <= '9' )
+
+// Reads argc doubles into values, returns false and sets a NULL result if any of them is NULL
+static bool GetDoubles(sqlite3_context* context, int argc, sqlite3_value** argv, double* values)
+{
+	for( int i = 0; i < argc; i++ ) {
+		if( sqlite3_value_type(argv[i]) == SQLITE_NULL ) {
+			sqlite3_result_null(context);
+			return false;
+		}
+		values[i] = sqlite3_value_double(argv[i]);
+	}
+	return true;
+}
+
+
+static void NativeDist3(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+	double v[6];
+	if( !GetDoubles(context, argc, argv, v) ) return;
+	double dx = v[3] - v[0];
+	double dy = v[4] - v[1];
+	double dz = v[5] - v[2];
+	sqlite3_result_double(context, sqrt(dx * dx + dy * dy + dz * dz));
+}
+
+static void NativeDist2(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+	double v[4];
+	if( !GetDoubles(context, argc, argv, v) ) return;
+	double dx = v[2] - v[0];
+	double dy = v[3] - v[1];
+	sqlite3_result_double(context, sqrt(dx * dx + dy * dy));
+}
+
+// Registered for two and three arguments
+static void NativeVecLen(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+	double v[3] = { 0.0, 0.0, 0.0 };
+	if( !GetDoubles(context, argc, argv, v) ) return;
+	sqlite3_result_double(context, sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]));
+}
+
+// The corners may be given in any order
+static void NativeInBox(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+
+	double v[9];
+	if( !GetDoubles(context, argc, argv, v) ) return;
+
+	for( int axis = 0; axis < 3; axis++ ) {
+
+		double low = v[3 + axis];
+		double high = v[6 + axis];
+
+		if( low > high ) {
+			double swap = low;
+			low = high;
+			high = swap;
+		}
+
+		if( v[axis] < low || v[axis] > high ) {
+			sqlite3_result_int(context, 0);
+			return;
+		}
+
+	}
+
+	sqlite3_result_int(context, 1);
+
+}
+
+// Values are masked to their width, the fields together may not take more than 64 bits
+static void NativeBitPack(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+
+	if( argc < 2 || ( argc % 2 ) != 0 ) {
+		sqlite3_result_error(context, "bitpack takes pairs of value, bits", -1);
+		return;
+	}
+
+	sqlite3_uint64 packed = 0;
+	int offset = 0;
+
+	for( int i = 0; i < argc; i += 2 ) {
+
+		if( sqlite3_value_type(argv[i]) == SQLITE_NULL || sqlite3_value_type(argv[i + 1]) == SQLITE_NULL ) {
+			sqlite3_result_null(context);
+			return;
+		}
+
+		int bits = sqlite3_value_int(argv[i + 1]);
+
+		if( bits < 1 || offset + bits > 64 ) {
+			sqlite3_result_error(context, "bitpack fields have to fit into 64 bits", -1);
+			return;
+		}
+
+		sqlite3_uint64 mask = ( bits == 64 ) ? ~(sqlite3_uint64)0 : ( ( (sqlite3_uint64)1 << bits ) - 1 );
+		packed |= ( (sqlite3_uint64)sqlite3_value_int64(argv[i]) & mask ) << offset;
+
+		offset += bits;
+
+	}
+
+	sqlite3_result_int64(context, (sqlite3_int64)packed);
+
+}
+
+static void NativeBitUnpack(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+
+	if( sqlite3_value_type(argv[0]) == SQLITE_NULL || sqlite3_value_type(argv[1]) == SQLITE_NULL || sqlite3_value_type(argv[2]) == SQLITE_NULL ) {
+		sqlite3_result_null(context);
+		return;
+	}
+
+	int offset = sqlite3_value_int(argv[1]);
+	int bits = sqlite3_value_int(argv[2]);
+
+	if( offset < 0 || bits < 1 || offset + bits > 64 ) {
+		sqlite3_result_error(context, "bitunpack field is outside of 64 bits", -1);
+		return;
+	}
+
+	sqlite3_uint64 mask = ( bits == 64 ) ? ~(sqlite3_uint64)0 : ( ( (sqlite3_uint64)1 << bits ) - 1 );
+	sqlite3_uint64 packed = (sqlite3_uint64)sqlite3_value_int64(argv[0]);
+
+	sqlite3_result_int64(context, (sqlite3_int64)( ( packed >> offset ) & mask ));
+
+}
+
+
+static int CollateAsciiNoCase(void* usrPtr, int length1, const void* data1, int length2, const void* data2)
+{
+
+	const unsigned char* a = (const unsigned char*)data1;
+	const unsigned char* b = (const unsigned char*)data2;
+	int length = ( length1 < length2 ) ? length1 : length2;
+
+	for( int i = 0; i < length; i++ ) {
+		int diff = ASCII_LOWER(a[i]) - ASCII_LOWER(b[i]);
+		if( diff != 0 ) return diff;
+	}
+
+	return length1 - length2;
+
+}
+
+// Digit runs are compared by length once leading zeros are skipped and then digit by digit, so any length works
+static int CollateNatural(void* usrPtr, int length1, const void* data1, int length2, const void* data2)
+{
+
+	const unsigned char* a = (const unsigned char*)data1;
+	const unsigned char* b = (const unsigned char*)data2;
+	int i = 0;
+	int j = 0;
+
+	while( i < length1 && j < length2 ) {
+
+		if( ASCII_DIGIT(a[i]) && ASCII_DIGIT(b[j]) ) {
+
+			while( i < length1 && a[i] == '0' ) i++;
+			while( j < length2 && b[j] == '0' ) j++;
+
+			int start1 = i;
+			int start2 = j;
+
+			while( i < length1 && ASCII_DIGIT(a[i]) ) i++;
+			while( j < length2 && ASCII_DIGIT(b[j]) ) j++;
+
+			int digits1 = i - start1;
+			int digits2 = j - start2;
+
+			if( digits1 != digits2 ) return digits1 - digits2;
+
+			for( int k = 0; k < digits1; k++ ) {
+				if( a[start1 + k] != b[start2 + k] ) return a[start1 + k] - b[start2 + k];
+			}
+
+			continue;
+
+		}
+
+		int diff = ASCII_LOWER(a[i]) - ASCII_LOWER(b[j]);
+		if( diff != 0 ) return diff;
+
+		i++;
+		j++;
+
+	}
+
+	return ( length1 - i ) - ( length2 - j );
+
+}
+
+
+struct NativeFunction
+{
+	const char* pszName;
+	int iNumArgs;
+	void (*pFunction)(sqlite3_context*, int, sqlite3_value**);
+};
+
+static const NativeFunction s_NativeFunctions[] = {
+	{ "dist3",		6,	NativeDist3 },
+	{ "dist2",		4,	NativeDist2 },
+	{ "vec_len",	2,	NativeVecLen },
+	{ "vec_len",	3,	NativeVecLen },
+	{ "inbox",		9,	NativeInBox },
+	{ "bitpack",	-1,	NativeBitPack },
+	{ "bitunpack",	3,	NativeBitUnpack },
+};
+
+int RegisterNatives(sqlite3* db)
+{
+
+	if( !db ) return SQLITE_ERROR;
+
+	int retcode = SQLITE_OK;
+
+	for( int i = 0; i < (int)( sizeof(s_NativeFunctions) / sizeof(s_NativeFunctions[0]) ); i++ ) {
+		retcode = sqlite3_create_function_v2(db, s_NativeFunctions[i].pszName, s_NativeFunctions[i].iNumArgs, NATIVE_FLAGS, NULL,
+			s_NativeFunctions[i].pFunction, NULL, NULL, NULL);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+
+	retcode = sqlite3_create_collation_v2(db, "ASCII_NOCASE", SQLITE_UTF8, NULL, CollateAsciiNoCase, NULL);
+	if( retcode != SQLITE_OK ) return retcode;
+
+	return sqlite3_create_collation_v2(db, "NATSORT", SQLITE_UTF8, NULL, CollateNatural, NULL);
+
+}
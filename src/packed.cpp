@@ -0,0 +1,557 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "packed.h"
+#include "json.h"
+#include <sqlite3.h>
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// Output buffer
+//-----------------------------------------------------------------------------
+
+void PackBufferInit(PackBuffer* buffer)
+{
+	buffer->pData = buffer->aInline;
+	buffer->iLength = 0;
+	buffer->iCapacity = PACKED_INLINE_SIZE;
+	buffer->bOutOfMemory = false;
+}
+
+void PackBufferFree(PackBuffer* buffer)
+{
+	if( buffer->pData != buffer->aInline ) {
+		sqlite3_free(buffer->pData);
+	}
+	PackBufferInit(buffer);
+}
+
+static unsigned char* PackReserve(PackBuffer* buffer, int count)
+{
+
+	if( buffer->bOutOfMemory ) return NULL;
+
+	if( buffer->iLength + count > buffer->iCapacity ) {
+
+		int capacity = buffer->iCapacity * 2;
+		while( capacity < buffer->iLength + count ) capacity *= 2;
+
+		unsigned char* pData = (unsigned char*)sqlite3_malloc(capacity);
+		if( !pData ) {
+			buffer->bOutOfMemory = true;
+			return NULL;
+		}
+
+		memcpy(pData, buffer->pData, buffer->iLength);
+		if( buffer->pData != buffer->aInline ) sqlite3_free(buffer->pData);
+
+		buffer->pData = pData;
+		buffer->iCapacity = capacity;
+
+	}
+
+	unsigned char* pOut = buffer->pData + buffer->iLength;
+	buffer->iLength += count;
+	return pOut;
+
+}
+
+static void PackByte(PackBuffer* buffer, unsigned char value)
+{
+	unsigned char* pOut = PackReserve(buffer, 1);
+	if( pOut ) pOut[0] = value;
+}
+
+// Writes a tag followed by a big endian value of the given width
+static void PackTagged(PackBuffer* buffer, unsigned char tag, sqlite3_uint64 value, int width)
+{
+	unsigned char* pOut = PackReserve(buffer, 1 + width);
+	if( !pOut ) return;
+	pOut[0] = tag;
+	for( int i = 0; i < width; i++ ) {
+		pOut[width - i] = (unsigned char)( value >> ( i * 8 ) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Encoding
+//-----------------------------------------------------------------------------
+
+static void PackNumber(PackBuffer* buffer, double value)
+{
+
+	// Anything integral that fits in 64 bits is stored as an integer
+	if( value == floor(value) && value >= -9223372036854775808.0 && value < 18446744073709551616.0 ) {
+
+		if( value >= 0 ) {
+			sqlite3_uint64 n = (sqlite3_uint64)value;
+			if( n < 0x80 ) {
+				PackByte(buffer, (unsigned char)n);
+			} else if( n <= 0xFF ) {
+				PackTagged(buffer, 0xCC, n, 1);
+			} else if( n <= 0xFFFF ) {
+				PackTagged(buffer, 0xCD, n, 2);
+			} else if( n <= 0xFFFFFFFF ) {
+				PackTagged(buffer, 0xCE, n, 4);
+			} else {
+				PackTagged(buffer, 0xCF, n, 8);
+			}
+		} else {
+			sqlite3_int64 n = (sqlite3_int64)value;
+			if( n >= -32 ) {
+				PackByte(buffer, (unsigned char)( n & 0xFF ));
+			} else if( n >= -128 ) {
+				PackTagged(buffer, 0xD0, (sqlite3_uint64)n, 1);
+			} else if( n >= -32768 ) {
+				PackTagged(buffer, 0xD1, (sqlite3_uint64)n, 2);
+			} else if( n >= -2147483647 - 1 ) {
+				PackTagged(buffer, 0xD2, (sqlite3_uint64)n, 4);
+			} else {
+				PackTagged(buffer, 0xD3, (sqlite3_uint64)n, 8);
+			}
+		}
+
+		return;
+
+	}
+
+	float single = (float)value;
+
+	if( (double)single == value || value != value ) {
+		unsigned int bits = 0;
+		memcpy(&bits, &single, sizeof(bits));
+		PackTagged(buffer, 0xCA, bits, 4);
+	} else {
+		sqlite3_uint64 bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+		PackTagged(buffer, 0xCB, bits, 8);
+	}
+
+}
+
+static void PackString(PackBuffer* buffer, const char* value, int length)
+{
+
+	if( length < 32 ) {
+		PackByte(buffer, (unsigned char)( 0xA0 | length ));
+	} else if( length <= 0xFF ) {
+		PackTagged(buffer, 0xD9, length, 1);
+	} else if( length <= 0xFFFF ) {
+		PackTagged(buffer, 0xDA, length, 2);
+	} else {
+		PackTagged(buffer, 0xDB, length, 4);
+	}
+
+	unsigned char* pOut = PackReserve(buffer, length);
+	if( pOut ) memcpy(pOut, value, length);
+
+}
+
+// Array and map headers share their layout, only the tags differ
+static void PackHeader(PackBuffer* buffer, int count, unsigned char fixTag, unsigned char tag16, unsigned char tag32)
+{
+	if( count < 16 ) {
+		PackByte(buffer, (unsigned char)( fixTag | count ));
+	} else if( count <= 0xFFFF ) {
+		PackTagged(buffer, tag16, count, 2);
+	} else {
+		PackTagged(buffer, tag32, count, 4);
+	}
+}
+
+static bool PackValue(ILuaObject* value, PackBuffer* buffer, int depth);
+
+static bool PackTable(ILuaObject* table, PackBuffer* buffer, int depth)
+{
+
+	if( depth > PACKED_MAX_DEPTH ) return false;
+
+	LuaTableWalk walk;
+	if( !LuaTableWalkBegin(table, &walk) ) return false;
+
+	CUtlLuaVector* pMembers = walk.pMembers;
+	int count = walk.iCount;
+	bool valid = true;
+
+	if( walk.ppValues ) {
+
+		PackHeader(buffer, count, 0x90, 0xDC, 0xDD);
+		for( int i = 0; i < count && valid; i++ ) {
+			valid = walk.ppValues[i] ? PackValue(walk.ppValues[i], buffer, depth + 1) : false;
+		}
+
+	} else {
+
+		PackHeader(buffer, count, 0x80, 0xDE, 0xDF);
+
+		for( int i = 0; i < count && valid; i++ ) {
+
+			LuaKeyValue& member = pMembers->Element(i);
+
+			if( !member.pKey->isString() && !member.pKey->isNumber() ) {
+				valid = false;
+			} else {
+				valid = PackValue(member.pKey, buffer, depth + 1) && PackValue(member.pValue, buffer, depth + 1);
+			}
+
+		}
+
+	}
+
+	LuaTableWalkEnd(&walk);
+	return valid;
+
+}
+
+static bool PackValue(ILuaObject* value, PackBuffer* buffer, int depth)
+{
+
+	switch( value ? value->GetType() : GLua::TYPE_NIL ) {
+	case GLua::TYPE_NIL:
+		PackByte(buffer, 0xC0);
+		return true;
+	case GLua::TYPE_BOOL:
+		PackByte(buffer, value->GetBool() ? 0xC3 : 0xC2);
+		return true;
+	case GLua::TYPE_NUMBER:
+		PackNumber(buffer, value->GetDouble());
+		return true;
+	case GLua::TYPE_STRING:
+		{
+			unsigned int length = 0;
+			const char* pszValue = LuaObjectString(value, &length);
+			PackString(buffer, pszValue ? pszValue : "", (int)length);
+		}
+		return true;
+	case GLua::TYPE_TABLE:
+		return PackTable(value, buffer, depth);
+	}
+
+	return false;
+
+}
+
+bool PackEncode(ILuaObject* value, PackBuffer* buffer)
+{
+	if( !buffer ) return false;
+	return PackValue(value, buffer, 0) && !buffer->bOutOfMemory;
+}
+
+//-----------------------------------------------------------------------------
+// Decoding
+//-----------------------------------------------------------------------------
+
+struct PackReader
+{
+	const unsigned char* pCur;
+	const unsigned char* pEnd;
+	int iDepth;
+};
+
+// Decoded values are stored straight into their parent table under a string or number key.
+// String keys are held as Lua strings, so any NULs in them survive.
+struct PackTarget
+{
+	ILuaObject* pTable;
+	ILuaObject* pKey;
+	double dKey;
+};
+
+enum PackKind
+{
+	PACK_NIL,
+	PACK_BOOL,
+	PACK_NUMBER,
+	PACK_STRING,
+	PACK_ARRAY,
+	PACK_MAP
+};
+
+// A scalar read off the input, strings point into the input itself
+struct PackItem
+{
+	PackKind kind;
+	bool bValue;
+	double dValue;
+	const char* pszValue;
+	int iLength;
+	int iCount;
+};
+
+static bool PackReadUInt(PackReader* reader, int width, sqlite3_uint64* value)
+{
+	if( reader->pEnd - reader->pCur < width ) return false;
+	*value = 0;
+	for( int i = 0; i < width; i++ ) {
+		*value = ( *value << 8 ) | reader->pCur[i];
+	}
+	reader->pCur += width;
+	return true;
+}
+
+static bool PackReadSigned(PackReader* reader, int width, double* value)
+{
+	sqlite3_uint64 bits = 0;
+	if( !PackReadUInt(reader, width, &bits) ) return false;
+	// Sign extend from the top bit of the width that was read
+	if( width < 8 && ( bits >> ( width * 8 - 1 ) ) & 1 ) {
+		bits |= ~(sqlite3_uint64)0 << ( width * 8 );
+	}
+	*value = (double)(sqlite3_int64)bits;
+	return true;
+}
+
+static bool PackReadSized(PackReader* reader, int length, PackItem* item)
+{
+	if( length < 0 || reader->pEnd - reader->pCur < length ) return false;
+	item->kind = PACK_STRING;
+	item->pszValue = (const char*)reader->pCur;
+	item->iLength = length;
+	reader->pCur += length;
+	return true;
+}
+
+static bool PackReadItem(PackReader* reader, PackItem* item)
+{
+
+	if( reader->pCur >= reader->pEnd ) return false;
+
+	unsigned char tag = *reader->pCur++;
+	sqlite3_uint64 n = 0;
+
+	if( tag < 0x80 ) {
+		item->kind = PACK_NUMBER;
+		item->dValue = tag;
+		return true;
+	} else if( tag >= 0xE0 ) {
+		item->kind = PACK_NUMBER;
+		item->dValue = (signed char)tag;
+		return true;
+	} else if( tag >= 0xA0 && tag <= 0xBF ) {
+		return PackReadSized(reader, tag & 0x1F, item);
+	} else if( tag >= 0x90 && tag <= 0x9F ) {
+		item->kind = PACK_ARRAY;
+		item->iCount = tag & 0x0F;
+		return true;
+	} else if( tag >= 0x80 && tag <= 0x8F ) {
+		item->kind = PACK_MAP;
+		item->iCount = tag & 0x0F;
+		return true;
+	}
+
+	switch( tag ) {
+	case 0xC0:
+		item->kind = PACK_NIL;
+		return true;
+	case 0xC2:
+	case 0xC3:
+		item->kind = PACK_BOOL;
+		item->bValue = ( tag == 0xC3 );
+		return true;
+	case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+		if( !PackReadUInt(reader, 1 << ( tag - 0xCC ), &n) ) return false;
+		item->kind = PACK_NUMBER;
+		item->dValue = (double)n;
+		return true;
+	case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+		item->kind = PACK_NUMBER;
+		return PackReadSigned(reader, 1 << ( tag - 0xD0 ), &item->dValue);
+	case 0xCA:
+		{
+			if( !PackReadUInt(reader, 4, &n) ) return false;
+			unsigned int bits = (unsigned int)n;
+			float single = 0.0f;
+			memcpy(&single, &bits, sizeof(single));
+			item->kind = PACK_NUMBER;
+			item->dValue = single;
+		}
+		return true;
+	case 0xCB:
+		if( !PackReadUInt(reader, 8, &n) ) return false;
+		memcpy(&item->dValue, &n, sizeof(item->dValue));
+		item->kind = PACK_NUMBER;
+		return true;
+	// Binary data is handed back as a string, the same as a BLOB column
+	case 0xD9: case 0xC4:
+		return PackReadUInt(reader, 1, &n) && PackReadSized(reader, (int)n, item);
+	case 0xDA: case 0xC5:
+		return PackReadUInt(reader, 2, &n) && PackReadSized(reader, (int)n, item);
+	case 0xDB: case 0xC6:
+		return PackReadUInt(reader, 4, &n) && n <= 0x7FFFFFFF && PackReadSized(reader, (int)n, item);
+	case 0xDC:
+	case 0xDE:
+		if( !PackReadUInt(reader, 2, &n) ) return false;
+		item->kind = ( tag == 0xDC ) ? PACK_ARRAY : PACK_MAP;
+		item->iCount = (int)n;
+		return true;
+	case 0xDD:
+	case 0xDF:
+		if( !PackReadUInt(reader, 4, &n) || n > 0x7FFFFFFF ) return false;
+		item->kind = ( tag == 0xDD ) ? PACK_ARRAY : PACK_MAP;
+		item->iCount = (int)n;
+		return true;
+	}
+
+	return false;
+
+}
+
+static bool PackParseValue(PackReader* reader, const PackTarget& target);
+
+static void PackSetObject(const PackTarget& target, ILuaObject* value)
+{
+	if( target.pKey ) {
+		target.pTable->SetMember(target.pKey, value);
+	} else {
+		target.pTable->SetMember((float)target.dKey, value);
+	}
+}
+
+// Stores whatever was just pushed, for the values that can't be set under an object key directly
+static void PackSetPushed(const PackTarget& target)
+{
+	ILuaObject* pValue = g_pLua->GetObject(g_pLua->Top());
+	g_pLua->Pop();
+	if( pValue ) PackSetObject(target, pValue);
+	SAFE_UNREF(pValue);
+}
+
+static bool PackParseTable(PackReader* reader, const PackItem& item, const PackTarget& target)
+{
+
+	if( ++reader->iDepth > PACKED_MAX_DEPTH ) return false;
+
+	// Every element needs at least a byte, which stops a forged count from looping on nothing
+	if( item.iCount > reader->pEnd - reader->pCur ) return false;
+
+	ILuaObject* pTable = g_pLua->GetNewTable();
+	if( !pTable ) return false;
+
+	bool valid = true;
+
+	for( int i = 0; i < item.iCount && valid; i++ ) {
+
+		if( item.kind == PACK_ARRAY ) {
+
+			PackTarget element = { pTable, NULL, (double)( i + 1 ) };
+			valid = PackParseValue(reader, element);
+
+		} else {
+
+			// Keys can not be tables, so they are read as a plain item
+			PackItem key;
+			if( !PackReadItem(reader, &key) ) {
+				valid = false;
+			} else if( key.kind == PACK_STRING ) {
+				ILuaObject* pKey = LuaNewString(key.pszValue, (unsigned int)key.iLength);
+				if( pKey ) {
+					PackTarget member = { pTable, pKey, 0.0 };
+					valid = PackParseValue(reader, member);
+					SAFE_UNREF(pKey);
+				} else {
+					valid = false;
+				}
+			} else if( key.kind == PACK_NUMBER ) {
+				PackTarget member = { pTable, NULL, key.dValue };
+				valid = PackParseValue(reader, member);
+			} else {
+				valid = false;
+			}
+
+		}
+
+	}
+
+	if( valid ) PackSetObject(target, pTable);
+
+	SAFE_UNREF(pTable);
+	reader->iDepth--;
+	return valid;
+
+}
+
+static bool PackParseValue(PackReader* reader, const PackTarget& target)
+{
+
+	PackItem item;
+	if( !PackReadItem(reader, &item) ) return false;
+
+	switch( item.kind ) {
+	case PACK_NIL:
+		return true;
+	case PACK_BOOL:
+		if( target.pKey ) {
+			g_pLua->Push(item.bValue);
+			PackSetPushed(target);
+		} else {
+			target.pTable->SetMember((float)target.dKey, item.bValue);
+		}
+		return true;
+	case PACK_NUMBER:
+		if( target.pKey ) {
+			g_pLua->Push((float)item.dValue);
+			PackSetPushed(target);
+		} else {
+			target.pTable->SetMember((float)target.dKey, (float)item.dValue);
+		}
+		return true;
+	case PACK_STRING:
+		// Pushed with its length straight out of the input, embedded zeros included
+		g_pLua->Push(item.iLength ? (const char*)item.pszValue : "", (unsigned int)item.iLength);
+		PackSetPushed(target);
+		return true;
+	case PACK_ARRAY:
+	case PACK_MAP:
+		return PackParseTable(reader, item, target);
+	}
+
+	return false;
+
+}
+
+ILuaObject* PackDecode(const void* data, int length)
+{
+
+	if( !data || length <= 0 ) return NULL;
+
+	PackReader reader;
+	reader.pCur = (const unsigned char*)data;
+	reader.pEnd = reader.pCur + length;
+	reader.iDepth = 0;
+
+	// Parsed into slot 1 of a holder for the same reason as JsonDecode
+	ILuaObject* pHolder = g_pLua->GetNewTable();
+	ILuaObject* pResult = NULL;
+
+	if( pHolder ) {
+
+		PackTarget target = { pHolder, NULL, 1.0 };
+
+		if( PackParseValue(&reader, target) && reader.pCur == reader.pEnd ) {
+			pResult = pHolder->GetMember(1.0f);
+		}
+
+	}
+
+	SAFE_UNREF(pHolder);
+	return pResult;
+
+}
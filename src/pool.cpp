@@ -0,0 +1,182 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "pool.h"
+#include <stdlib.h>
+
+// Blocks are kept 8 byte aligned so doubles and 64 bit integers stay aligned
+#define POOL_ALIGN(size) ( ( (size) + 7 ) & ~(size_t)7 )
+
+CPool::CPool(size_t blockSize, int blocksPerChunk)
+{
+	this->m_iBlockSize = POOL_ALIGN( blockSize < sizeof(Block) ? sizeof(Block) : blockSize );
+	this->m_iBlocksPerChunk = ( blocksPerChunk > 0 ) ? blocksPerChunk : 1;
+	this->m_pFree = NULL;
+	this->m_pChunks = NULL;
+	this->m_iLive = 0;
+	this->m_iPeak = 0;
+	this->m_iReserved = 0;
+	this->m_iAllocs = 0;
+	this->m_iReused = 0;
+}
+
+CPool::~CPool(void)
+{
+	// Something still points into the chunks, leaking them beats a crash on unload
+	if( this->m_iLive > 0 ) return;
+
+	while( this->m_pChunks ) {
+		Chunk* pNext = this->m_pChunks->pNext;
+		::free(this->m_pChunks);
+		this->m_pChunks = pNext;
+	}
+
+	this->m_pFree = NULL;
+	this->m_iReserved = 0;
+}
+
+bool CPool::grow(void)
+{
+
+	size_t header = POOL_ALIGN(sizeof(Chunk));
+	char* pMemory = (char*)malloc(header + this->m_iBlockSize * this->m_iBlocksPerChunk);
+	if( !pMemory ) return false;
+
+	Chunk* pChunk = (Chunk*)pMemory;
+	pChunk->pNext = this->m_pChunks;
+	this->m_pChunks = pChunk;
+
+	// Thread the new blocks onto the free list back to front so they are handed out in address order
+	for( int i = this->m_iBlocksPerChunk - 1; i >= 0; i-- ) {
+		Block* pBlock = (Block*)( pMemory + header + this->m_iBlockSize * i );
+		pBlock->pNext = this->m_pFree;
+		this->m_pFree = pBlock;
+	}
+
+	this->m_iReserved += this->m_iBlocksPerChunk;
+	return true;
+
+}
+
+void* CPool::alloc(void)
+{
+
+	if( this->m_pFree ) {
+		this->m_iReused++;
+	} else if( !this->grow() ) {
+		return NULL;
+	}
+
+	Block* pBlock = this->m_pFree;
+	this->m_pFree = pBlock->pNext;
+
+	this->m_iAllocs++;
+	if( ++this->m_iLive > this->m_iPeak ) this->m_iPeak = this->m_iLive;
+
+	return pBlock;
+
+}
+
+void CPool::free(void* ptr)
+{
+	if( !ptr ) return;
+	Block* pBlock = (Block*)ptr;
+	pBlock->pNext = this->m_pFree;
+	this->m_pFree = pBlock;
+	this->m_iLive--;
+}
+
+size_t CPool::getBlockSize(void)
+{
+	return this->m_iBlockSize;
+}
+
+int CPool::getLive(void)
+{
+	return this->m_iLive;
+}
+
+int CPool::getPeak(void)
+{
+	return this->m_iPeak;
+}
+
+int CPool::getReserved(void)
+{
+	return this->m_iReserved;
+}
+
+int CPool::getAllocs(void)
+{
+	return this->m_iAllocs;
+}
+
+// Allocations served from the free list rather than a fresh chunk
+int CPool::getReused(void)
+{
+	return this->m_iReused;
+}
+
+
+static CPool s_ScratchPools[] = {
+	CPool(64, 64),
+	CPool(256, 32),
+	CPool(1024, 16),
+};
+
+#define NUM_SCRATCH_POOLS ( (int)( sizeof(s_ScratchPools) / sizeof(s_ScratchPools[0]) ) )
+
+static CPool* FindScratchPool(size_t size)
+{
+	for( int i = 0; i < NUM_SCRATCH_POOLS; i++ ) {
+		if( size <= s_ScratchPools[i].getBlockSize() ) return &s_ScratchPools[i];
+	}
+	return NULL;
+}
+
+void* ScratchAlloc(size_t size)
+{
+	CPool* pPool = FindScratchPool(size);
+	return pPool ? pPool->alloc() : malloc(size);
+}
+
+// size has to be the one the memory was allocated with
+void ScratchFree(void* ptr, size_t size)
+{
+	if( !ptr ) return;
+	CPool* pPool = FindScratchPool(size);
+	if( pPool ) {
+		pPool->free(ptr);
+	} else {
+		::free(ptr);
+	}
+}
+
+int GetNumScratchPools(void)
+{
+	return NUM_SCRATCH_POOLS;
+}
+
+CPool* GetScratchPool(int index)
+{
+	if( index < 0 || index >= NUM_SCRATCH_POOLS ) return NULL;
+	return &s_ScratchPools[index];
+}
@@ -0,0 +1,889 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "querycache.h"
+#include "thread.h"
+
+#define CACHE_NUM_BUCKETS		1024
+#define CACHE_VALUE_OVERHEAD	64		// roughly what SQLite allocates per value besides its data
+
+// No single result may take more than this share of the cache
+#define CACHE_MAX_ENTRY_SHARE	4
+
+struct CacheTable
+{
+	char* pszName;
+	int iEntries;
+	CacheTable* pNext;
+};
+
+// Built-in functions that do not give the same result every time they are called with the same arguments. The date
+// and time functions are flagged deterministic since they only look at the clock once per statement.
+static const char* s_pszVolatileFunctions[] = {
+	"random", "randomblob", "changes", "total_changes", "last_insert_rowid",
+	"date", "time", "datetime", "julianday", "strftime", "unixepoch", "timediff",
+	"current_date", "current_time", "current_timestamp", "sqlite_offset", "load_extension",
+};
+
+static bool IsVolatileFunction(const char* name)
+{
+	for( int i = 0; i < (int)( sizeof(s_pszVolatileFunctions) / sizeof(s_pszVolatileFunctions[0]) ); i++ ) {
+		if( sqlite3_stricmp(name, s_pszVolatileFunctions[i]) == 0 ) return true;
+	}
+	return false;
+}
+
+static unsigned int HashKey(const char* key)
+{
+	unsigned int hash = 2166136261U;
+	for( const unsigned char* p = (const unsigned char*)key; *p; p++ ) {
+		hash = ( hash ^ *p ) * 16777619U;
+	}
+	return hash;
+}
+
+// Copies a list of terminated names and adds the empty name that ends it
+static char* CopyList(sqlite3_str* list)
+{
+	int length = sqlite3_str_length(list);
+	char* pszList = (char*)sqlite3_malloc(length + 1);
+	if( !pszList ) return NULL;
+	if( length ) memcpy(pszList, sqlite3_str_value(list), length);
+	pszList[length] = '\0';
+	return pszList;
+}
+
+CQueryCache::CQueryCache(sqlite3* db, sqlite3_int64 maxBytes, double maxAge)
+{
+
+	this->m_pDatabase = db;
+	this->m_iMaxBytes = maxBytes;
+	this->m_dMaxAge = maxAge;
+
+	this->m_iNumBuckets = CACHE_NUM_BUCKETS;
+	this->m_ppBuckets = (CachedResult**)sqlite3_malloc(sizeof(CachedResult*) * this->m_iNumBuckets);
+	if( this->m_ppBuckets ) memset(this->m_ppBuckets, 0, sizeof(CachedResult*) * this->m_iNumBuckets);
+
+	this->m_pNewest = NULL;
+	this->m_pOldest = NULL;
+	this->m_iNumEntries = 0;
+	this->m_iBytes = 0;
+
+	this->m_pTables = NULL;
+	this->m_iGeneration = 0;
+
+	this->m_pDirty = sqlite3_str_new(NULL);
+	this->m_bAllDirty = false;
+	this->m_bIncoming = false;
+
+	this->m_bCollecting = false;
+	this->m_pReads = sqlite3_str_new(NULL);
+	this->m_pWrites = sqlite3_str_new(NULL);
+	this->m_pCalls = sqlite3_str_new(NULL);
+	this->m_bVolatile = false;
+
+	this->m_pVolatileFunctions = sqlite3_str_new(NULL);
+	this->m_bFunctionsLoaded = false;
+	this->m_bFunctionsKnown = false;
+
+	this->resetStats();
+
+	sqlite3_set_authorizer(db, CQueryCache::authorizer, this);
+	sqlite3_update_hook(db, CQueryCache::updateHook, this);
+	sqlite3_rollback_hook(db, CQueryCache::rollbackHook, this);
+
+}
+
+CQueryCache::~CQueryCache(void)
+{
+
+	if( this->m_pDatabase ) {
+		sqlite3_set_authorizer(this->m_pDatabase, NULL, NULL);
+		sqlite3_update_hook(this->m_pDatabase, NULL, NULL);
+		sqlite3_rollback_hook(this->m_pDatabase, NULL, NULL);
+	}
+
+	this->flush();
+
+	while( this->m_pTables ) {
+		CacheTable* pNext = this->m_pTables->pNext;
+		sqlite3_free(this->m_pTables->pszName);
+		sqlite3_free(this->m_pTables);
+		this->m_pTables = pNext;
+	}
+
+	sqlite3_free(this->m_ppBuckets);
+	sqlite3_free(sqlite3_str_finish(this->m_pDirty));
+	sqlite3_free(sqlite3_str_finish(this->m_pReads));
+	sqlite3_free(sqlite3_str_finish(this->m_pWrites));
+	sqlite3_free(sqlite3_str_finish(this->m_pCalls));
+	sqlite3_free(sqlite3_str_finish(this->m_pVolatileFunctions));
+
+}
+
+void CQueryCache::setLimits(sqlite3_int64 maxBytes, double maxAge)
+{
+	this->m_iMaxBytes = maxBytes;
+	this->m_dMaxAge = maxAge;
+	this->evict();
+}
+
+
+//-----------------------------------------------------------------------------
+// Hooks
+//-----------------------------------------------------------------------------
+
+int CQueryCache::authorizer(void* usrPtr, int action, const char* arg1, const char* arg2, const char* dbName, const char* trigger)
+{
+
+	CQueryCache* pCache = (CQueryCache*)usrPtr;
+	const char* pszWrite = NULL;
+
+	switch( action ) {
+	case SQLITE_READ:
+		if( pCache->m_bCollecting && arg1 && !listContains(sqlite3_str_value(pCache->m_pReads), sqlite3_str_length(pCache->m_pReads), arg1) ) {
+			listAdd(pCache->m_pReads, arg1);
+		}
+		break;
+	case SQLITE_INSERT:
+	case SQLITE_UPDATE:
+	case SQLITE_DELETE:
+		pszWrite = arg1;
+		break;
+	case SQLITE_CREATE_INDEX:
+	case SQLITE_CREATE_TABLE:
+	case SQLITE_CREATE_TEMP_INDEX:
+	case SQLITE_CREATE_TEMP_TABLE:
+	case SQLITE_CREATE_TEMP_TRIGGER:
+	case SQLITE_CREATE_TEMP_VIEW:
+	case SQLITE_CREATE_TRIGGER:
+	case SQLITE_CREATE_VIEW:
+	case SQLITE_CREATE_VTABLE:
+	case SQLITE_DROP_INDEX:
+	case SQLITE_DROP_TABLE:
+	case SQLITE_DROP_TEMP_INDEX:
+	case SQLITE_DROP_TEMP_TABLE:
+	case SQLITE_DROP_TEMP_TRIGGER:
+	case SQLITE_DROP_TEMP_VIEW:
+	case SQLITE_DROP_TRIGGER:
+	case SQLITE_DROP_VIEW:
+	case SQLITE_DROP_VTABLE:
+	case SQLITE_ALTER_TABLE:
+	case SQLITE_ATTACH:
+	case SQLITE_DETACH:
+		pszWrite = "*";
+		break;
+	case SQLITE_PRAGMA:
+	case SQLITE_TRANSACTION:
+	case SQLITE_SAVEPOINT:
+		pCache->m_bVolatile = true;
+		break;
+	case SQLITE_FUNCTION:
+		// Whether anything else is deterministic is looked up once the statement is prepared, see callsVolatile
+		if( !pCache->m_bCollecting || !arg2 ) break;
+		if( IsVolatileFunction(arg2) ) {
+			pCache->m_bVolatile = true;
+		} else if( !listContains(sqlite3_str_value(pCache->m_pCalls), sqlite3_str_length(pCache->m_pCalls), arg2) ) {
+			listAdd(pCache->m_pCalls, arg2);
+		}
+		break;
+	}
+
+	if( pszWrite ) {
+		if( pCache->m_bCollecting ) {
+			if( !listContains(sqlite3_str_value(pCache->m_pWrites), sqlite3_str_length(pCache->m_pWrites), pszWrite) ) {
+				listAdd(pCache->m_pWrites, pszWrite);
+			}
+		} else {
+			// Anything prepared outside CDatabase::prepare, like execute, runs straight after
+			pCache->tableWritten(pszWrite);
+		}
+	}
+
+	return SQLITE_OK;
+
+}
+
+void CQueryCache::updateHook(void* usrPtr, int op, const char* dbName, const char* table, sqlite3_int64 rowid)
+{
+	CQueryCache* pCache = (CQueryCache*)usrPtr;
+	pCache->tableWritten(table);
+}
+
+// Nothing uncommitted is ever stored, so a rollback only has to stop tables counting as dirty
+void CQueryCache::rollbackHook(void* usrPtr)
+{
+	CQueryCache* pCache = (CQueryCache*)usrPtr;
+	sqlite3_str_reset(pCache->m_pDirty);
+	pCache->m_bAllDirty = false;
+}
+
+
+//-----------------------------------------------------------------------------
+// Table lists
+//-----------------------------------------------------------------------------
+
+// A negative length means the list ends with an empty name
+bool CQueryCache::listContains(const char* list, int length, const char* name)
+{
+	if( !list ) return false;
+	for( const char* p = list; ( length < 0 || p < list + length ) && *p; p += strlen(p) + 1 ) {
+		if( sqlite3_stricmp(p, name) == 0 ) return true;
+	}
+	return false;
+}
+
+void CQueryCache::listAdd(sqlite3_str* list, const char* name)
+{
+	sqlite3_str_append(list, name, (int)strlen(name) + 1);
+}
+
+void CQueryCache::markDirty(const char* table)
+{
+	if( strcmp(table, "*") == 0 ) {
+		this->m_bAllDirty = true;
+	} else if( !listContains(sqlite3_str_value(this->m_pDirty), sqlite3_str_length(this->m_pDirty), table) ) {
+		listAdd(this->m_pDirty, table);
+	}
+}
+
+// The commit hook runs before the commit is known to have gone through, so the end of a transaction
+// is picked up from the connection being back in autocommit instead
+bool CQueryCache::isDirty(const char* tables)
+{
+
+	if( this->m_bIncoming ) return true;
+
+	if( sqlite3_get_autocommit(this->m_pDatabase) ) {
+		sqlite3_str_reset(this->m_pDirty);
+		this->m_bAllDirty = false;
+		return false;
+	}
+
+	if( this->m_bAllDirty ) return true;
+
+	const char* pszDirty = sqlite3_str_value(this->m_pDirty);
+	int length = sqlite3_str_length(this->m_pDirty);
+
+	for( const char* p = tables; *p; p += strlen(p) + 1 ) {
+		if( listContains(pszDirty, length, p) ) return true;
+	}
+
+	return false;
+
+}
+
+// Built-in aggregates are not flagged deterministic although they only depend on their rows, every other function
+// needs the flag on all of its overloads
+void CQueryCache::loadFunctions(void)
+{
+
+	this->m_bFunctionsLoaded = true;
+	this->m_bFunctionsKnown = false;
+	sqlite3_str_reset(this->m_pVolatileFunctions);
+
+	sqlite3_stmt* pStmt = NULL;
+	if( sqlite3_prepare_v2(this->m_pDatabase, "SELECT name, builtin, type, flags FROM pragma_function_list;", -1, &pStmt, NULL) != SQLITE_OK ) {
+		sqlite3_finalize(pStmt);
+		return;
+	}
+
+	int retcode = SQLITE_OK;
+
+	while( ( retcode = sqlite3_step(pStmt) ) == SQLITE_ROW ) {
+
+		const char* pszName = (const char*)sqlite3_column_text(pStmt, 0);
+		const char* pszType = (const char*)sqlite3_column_text(pStmt, 2);
+
+		bool builtin = ( sqlite3_column_int(pStmt, 1) != 0 );
+		bool aggregate = ( pszType && ( *pszType == 'a' || *pszType == 'w' ) );
+		bool deterministic = ( sqlite3_column_int(pStmt, 3) & SQLITE_DETERMINISTIC ) != 0;
+
+		if( pszName && !deterministic && !( builtin && aggregate ) &&
+			!listContains(sqlite3_str_value(this->m_pVolatileFunctions), sqlite3_str_length(this->m_pVolatileFunctions), pszName) ) {
+			listAdd(this->m_pVolatileFunctions, pszName);
+		}
+
+	}
+
+	this->m_bFunctionsKnown = ( sqlite3_finalize(pStmt) == SQLITE_OK && retcode == SQLITE_DONE );
+
+}
+
+// Runs outside the authorizer, which must not prepare statements of its own
+bool CQueryCache::callsVolatile(void)
+{
+
+	const char* pszCalls = sqlite3_str_value(this->m_pCalls);
+	int length = sqlite3_str_length(this->m_pCalls);
+
+	if( length == 0 ) return false;
+
+	if( !this->m_bFunctionsLoaded ) this->loadFunctions();
+	if( !this->m_bFunctionsKnown ) return true;
+
+	const char* pszVolatile = sqlite3_str_value(this->m_pVolatileFunctions);
+	int volatileLength = sqlite3_str_length(this->m_pVolatileFunctions);
+
+	for( const char* p = pszCalls; p < pszCalls + length; p += strlen(p) + 1 ) {
+		if( listContains(pszVolatile, volatileLength, p) ) return true;
+	}
+
+	return false;
+
+}
+
+CacheTable* CQueryCache::findTable(const char* name, bool create)
+{
+
+	for( CacheTable* pTable = this->m_pTables; pTable; pTable = pTable->pNext ) {
+		if( sqlite3_stricmp(pTable->pszName, name) == 0 ) return pTable;
+	}
+
+	if( !create ) return NULL;
+
+	CacheTable* pTable = (CacheTable*)sqlite3_malloc(sizeof(CacheTable));
+	if( !pTable ) return NULL;
+
+	pTable->pszName = sqlite3_mprintf("%s", name);
+	if( !pTable->pszName ) {
+		sqlite3_free(pTable);
+		return NULL;
+	}
+
+	pTable->iEntries = 0;
+	pTable->pNext = this->m_pTables;
+	this->m_pTables = pTable;
+
+	return pTable;
+
+}
+
+
+//-----------------------------------------------------------------------------
+// Entries
+//-----------------------------------------------------------------------------
+
+void CQueryCache::releaseResult(CachedResult* entry)
+{
+
+	if( --entry->iRefs > 0 ) return;
+
+	if( entry->ppValues ) {
+		for( int i = 0; i < entry->iNumRows * entry->iNumColumns; i++ ) {
+			sqlite3_value_free(entry->ppValues[i]);
+		}
+		sqlite3_free(entry->ppValues);
+	}
+
+	sqlite3_free(entry->pszKey);
+	sqlite3_free(entry->pszTables);
+	sqlite3_free(entry);
+
+}
+
+CachedResult* CQueryCache::lookup(const char* key)
+{
+
+	if( !this->m_ppBuckets ) return NULL;
+
+	unsigned int hash = HashKey(key);
+
+	CachedResult* pEntry = this->m_ppBuckets[hash % this->m_iNumBuckets];
+	while( pEntry && ( pEntry->iHash != hash || strcmp(pEntry->pszKey, key) != 0 ) ) {
+		pEntry = pEntry->pNextInBucket;
+	}
+
+	if( !pEntry ) return NULL;
+
+	if( this->m_dMaxAge > 0 && GetTimeMilliseconds() - pEntry->dStored > this->m_dMaxAge ) {
+		this->remove(pEntry);
+		this->m_iEvictions++;
+		return NULL;
+	}
+
+	// Move to the front of the LRU list
+	if( pEntry != this->m_pNewest ) {
+		pEntry->pPrev->pNext = pEntry->pNext;
+		if( pEntry->pNext ) pEntry->pNext->pPrev = pEntry->pPrev;
+		else this->m_pOldest = pEntry->pPrev;
+		pEntry->pPrev = NULL;
+		pEntry->pNext = this->m_pNewest;
+		this->m_pNewest->pPrev = pEntry;
+		this->m_pNewest = pEntry;
+	}
+
+	return pEntry;
+
+}
+
+// Takes over the recorded rows and key of info
+void CQueryCache::store(StatementCacheInfo* info, int columns)
+{
+
+	if( !this->m_ppBuckets || columns < 1 || info->iRecordBytes > this->m_iMaxBytes / CACHE_MAX_ENTRY_SHARE ) return;
+
+	// Another statement with the same SQL and parameters may have stored it first
+	CachedResult* pExisting = this->lookup(info->pszRecordKey);
+	if( pExisting ) this->remove(pExisting);
+
+	CachedResult* pEntry = (CachedResult*)sqlite3_malloc(sizeof(CachedResult));
+	if( !pEntry ) return;
+
+	int tablesLength = 0;
+	while( info->pszReads[tablesLength] ) tablesLength += (int)strlen(info->pszReads + tablesLength) + 1;
+
+	pEntry->pszTables = (char*)sqlite3_malloc(tablesLength + 1);
+	if( !pEntry->pszTables ) {
+		sqlite3_free(pEntry);
+		return;
+	}
+	memcpy(pEntry->pszTables, info->pszReads, tablesLength + 1);
+
+	pEntry->pszKey = info->pszRecordKey;
+	pEntry->iHash = HashKey(pEntry->pszKey);
+	pEntry->iNumColumns = columns;
+	pEntry->iNumRows = info->iNumRecorded / columns;
+	pEntry->ppValues = info->ppRecorded;
+	pEntry->iBytes = info->iRecordBytes + tablesLength + (sqlite3_int64)strlen(pEntry->pszKey) + sizeof(CachedResult);
+	pEntry->dStored = GetTimeMilliseconds();
+	pEntry->iRefs = 1;
+
+	info->pszRecordKey = NULL;
+	info->ppRecorded = NULL;
+	info->iNumRecorded = 0;
+	info->iRecordCapacity = 0;
+	info->iRecordBytes = 0;
+
+	for( const char* p = pEntry->pszTables; *p; p += strlen(p) + 1 ) {
+		CacheTable* pTable = this->findTable(p, true);
+		if( pTable ) pTable->iEntries++;
+	}
+
+	CachedResult** ppBucket = &this->m_ppBuckets[pEntry->iHash % this->m_iNumBuckets];
+	pEntry->pNextInBucket = *ppBucket;
+	*ppBucket = pEntry;
+
+	pEntry->pPrev = NULL;
+	pEntry->pNext = this->m_pNewest;
+	if( this->m_pNewest ) this->m_pNewest->pPrev = pEntry;
+	else this->m_pOldest = pEntry;
+	this->m_pNewest = pEntry;
+
+	this->m_iNumEntries++;
+	this->m_iBytes += pEntry->iBytes;
+	this->m_iStores++;
+
+	this->evict();
+
+}
+
+// Statements still reading the entry keep it alive until they reset
+void CQueryCache::remove(CachedResult* entry)
+{
+
+	CachedResult** ppLink = &this->m_ppBuckets[entry->iHash % this->m_iNumBuckets];
+	while( *ppLink && *ppLink != entry ) ppLink = &(*ppLink)->pNextInBucket;
+	if( *ppLink ) *ppLink = entry->pNextInBucket;
+
+	if( entry->pPrev ) entry->pPrev->pNext = entry->pNext;
+	else this->m_pNewest = entry->pNext;
+	if( entry->pNext ) entry->pNext->pPrev = entry->pPrev;
+	else this->m_pOldest = entry->pPrev;
+
+	for( const char* p = entry->pszTables; *p; p += strlen(p) + 1 ) {
+		CacheTable* pTable = this->findTable(p, false);
+		if( pTable ) pTable->iEntries--;
+	}
+
+	this->m_iNumEntries--;
+	this->m_iBytes -= entry->iBytes;
+
+	releaseResult(entry);
+
+}
+
+void CQueryCache::evict(void)
+{
+	while( this->m_pOldest && this->m_iBytes > this->m_iMaxBytes ) {
+		this->remove(this->m_pOldest);
+		this->m_iEvictions++;
+	}
+}
+
+void CQueryCache::invalidate(const char* table)
+{
+
+	this->m_iGeneration++;
+
+	if( strcmp(table, "*") == 0 ) {
+		this->m_iInvalidations += this->m_iNumEntries;
+		this->flush();
+		return;
+	}
+
+	// The update hook calls in for every row, this keeps that cheap once nothing depends on the table
+	CacheTable* pTable = this->findTable(table, false);
+	if( !pTable || pTable->iEntries == 0 ) return;
+
+	CachedResult* pEntry = this->m_pNewest;
+	while( pEntry && pTable->iEntries > 0 ) {
+		CachedResult* pNext = pEntry->pNext;
+		if( listContains(pEntry->pszTables, -1, table) ) {
+			this->remove(pEntry);
+			this->m_iInvalidations++;
+		}
+		pEntry = pNext;
+	}
+
+}
+
+void CQueryCache::flush(void)
+{
+	while( this->m_pNewest ) {
+		this->remove(this->m_pNewest);
+	}
+}
+
+void CQueryCache::tableWritten(const char* table)
+{
+	this->invalidate(table);
+	this->markDirty(table);
+}
+
+// Also drops everything once the backup is done, the last pages it wrote were not seen either
+void CQueryCache::setIncoming(bool incoming)
+{
+	this->m_bIncoming = incoming;
+	this->invalidate("*");
+}
+
+void CQueryCache::functionsChanged(void)
+{
+	this->m_bFunctionsLoaded = false;
+	this->invalidate("*");
+}
+
+
+//-----------------------------------------------------------------------------
+// Statements
+//-----------------------------------------------------------------------------
+
+void CQueryCache::beginPrepare(void)
+{
+	this->m_bCollecting = true;
+	this->m_bVolatile = false;
+	sqlite3_str_reset(this->m_pReads);
+	sqlite3_str_reset(this->m_pWrites);
+	sqlite3_str_reset(this->m_pCalls);
+}
+
+StatementCacheInfo* CQueryCache::endPrepare(sqlite3_stmt* stmt)
+{
+
+	this->m_bCollecting = false;
+
+	if( !stmt ) return NULL;
+
+	bool cacheable = sqlite3_stmt_readonly(stmt) && !this->m_bVolatile && sqlite3_column_count(stmt) > 0 && !this->callsVolatile();
+	bool writes = ( sqlite3_str_length(this->m_pWrites) > 0 );
+
+	if( !cacheable && !writes ) return NULL;
+
+	StatementCacheInfo* pInfo = (StatementCacheInfo*)sqlite3_malloc(sizeof(StatementCacheInfo));
+	if( !pInfo ) return NULL;
+
+	memset(pInfo, 0, sizeof(*pInfo));
+
+	if( cacheable ) pInfo->pszReads = CopyList(this->m_pReads);
+	if( writes ) {
+		pInfo->pszWrites = CopyList(this->m_pWrites);
+		// Without its write list the statement could leave stale results behind
+		if( !pInfo->pszWrites ) this->invalidate("*");
+	}
+
+	return pInfo;
+
+}
+
+// The SQL is compiled a second time to find out, a statement that no longer compiles counts as writing everything
+StatementCacheInfo* CQueryCache::trackWrites(sqlite3_stmt* stmt)
+{
+
+	if( !stmt || sqlite3_stmt_readonly(stmt) ) return NULL;
+
+	sqlite3_stmt* pCopy = NULL;
+
+	this->beginPrepare();
+	int retcode = sqlite3_prepare_v2(this->m_pDatabase, sqlite3_sql(stmt), -1, &pCopy, NULL);
+	this->m_bCollecting = false;
+	sqlite3_finalize(pCopy);
+
+	// Transaction control and the like write nothing that was cached
+	if( retcode == SQLITE_OK && sqlite3_str_length(this->m_pWrites) == 0 ) return NULL;
+
+	StatementCacheInfo* pInfo = (StatementCacheInfo*)sqlite3_malloc(sizeof(StatementCacheInfo));
+	if( !pInfo ) return NULL;
+
+	memset(pInfo, 0, sizeof(*pInfo));
+
+	if( retcode == SQLITE_OK ) {
+		pInfo->pszWrites = CopyList(this->m_pWrites);
+	}
+
+	if( !pInfo->pszWrites ) {
+		pInfo->pszWrites = (char*)sqlite3_malloc(3);
+		if( !pInfo->pszWrites ) {
+			sqlite3_free(pInfo);
+			return NULL;
+		}
+		memcpy(pInfo->pszWrites, "*\0", 3);
+	}
+
+	return pInfo;
+
+}
+
+int CQueryCache::step(sqlite3_stmt* stmt, StatementCacheInfo* info)
+{
+
+	// Stepping past the end starts over, the same as sqlite3_step does on its own
+	if( info->bDone ) resetInfo(info);
+
+	if( info->pServing ) {
+		if( ++info->iRow < info->pServing->iNumRows ) return SQLITE_ROW;
+		info->bDone = true;
+		return SQLITE_DONE;
+	}
+
+	if( !info->bStarted ) {
+
+		info->bStarted = true;
+
+		if( info->pszWrites ) {
+			for( const char* p = info->pszWrites; *p; p += strlen(p) + 1 ) {
+				this->tableWritten(p);
+			}
+		}
+
+		if( info->pszReads && !info->iInexactParams ) {
+
+			if( this->isDirty(info->pszReads) ) {
+
+				this->m_iBypasses++;
+
+			} else {
+
+				char* pszKey = sqlite3_expanded_sql(stmt);
+
+				if( pszKey ) {
+
+					CachedResult* pEntry = this->lookup(pszKey);
+
+					if( pEntry ) {
+						sqlite3_free(pszKey);
+						this->m_iHits++;
+						pEntry->iRefs++;
+						info->pServing = pEntry;
+						info->iRow = 0;
+						if( pEntry->iNumRows > 0 ) return SQLITE_ROW;
+						info->bDone = true;
+						return SQLITE_DONE;
+					}
+
+					this->m_iMisses++;
+					info->pszRecordKey = pszKey;
+					info->iGeneration = this->m_iGeneration;
+
+				}
+
+			}
+
+		}
+
+	}
+
+	int retcode = sqlite3_step(stmt);
+
+	if( info->pszRecordKey ) {
+
+		if( retcode == SQLITE_ROW ) {
+
+			int columns = sqlite3_column_count(stmt);
+
+			if( info->iNumRecorded + columns > info->iRecordCapacity ) {
+				int capacity = info->iRecordCapacity ? info->iRecordCapacity * 2 : columns * 8;
+				while( capacity < info->iNumRecorded + columns ) capacity *= 2;
+				sqlite3_value** ppRecorded = (sqlite3_value**)sqlite3_realloc64(info->ppRecorded, sizeof(sqlite3_value*) * (sqlite3_uint64)capacity);
+				if( ppRecorded ) {
+					info->ppRecorded = ppRecorded;
+					info->iRecordCapacity = capacity;
+				} else {
+					discardRecording(info);
+				}
+			}
+
+			for( int i = 0; info->pszRecordKey && i < columns; i++ ) {
+				sqlite3_value* pValue = sqlite3_value_dup(sqlite3_column_value(stmt, i));
+				if( !pValue ) {
+					discardRecording(info);
+					break;
+				}
+				info->ppRecorded[info->iNumRecorded++] = pValue;
+				info->iRecordBytes += CACHE_VALUE_OVERHEAD + sizeof(sqlite3_value*) + sqlite3_value_bytes(pValue);
+			}
+
+			// Bigger than the cache would take anyway
+			if( info->pszRecordKey && info->iRecordBytes > this->m_iMaxBytes / CACHE_MAX_ENTRY_SHARE ) {
+				discardRecording(info);
+			}
+
+		} else if( retcode == SQLITE_DONE ) {
+
+			if( info->iGeneration == this->m_iGeneration ) {
+				this->store(info, sqlite3_column_count(stmt));
+			}
+			discardRecording(info);
+
+		} else {
+
+			discardRecording(info);
+
+		}
+
+	}
+
+	if( retcode != SQLITE_ROW ) info->bDone = true;
+
+	return retcode;
+
+}
+
+void CQueryCache::discardRecording(StatementCacheInfo* info)
+{
+
+	if( info->ppRecorded ) {
+		for( int i = 0; i < info->iNumRecorded; i++ ) {
+			sqlite3_value_free(info->ppRecorded[i]);
+		}
+		sqlite3_free(info->ppRecorded);
+	}
+
+	sqlite3_free(info->pszRecordKey);
+
+	info->pszRecordKey = NULL;
+	info->ppRecorded = NULL;
+	info->iNumRecorded = 0;
+	info->iRecordCapacity = 0;
+	info->iRecordBytes = 0;
+
+}
+
+void CQueryCache::resetInfo(StatementCacheInfo* info)
+{
+
+	if( !info ) return;
+
+	if( info->pServing ) {
+		releaseResult(info->pServing);
+		info->pServing = NULL;
+	}
+
+	discardRecording(info);
+
+	info->iRow = 0;
+	info->bStarted = false;
+	info->bDone = false;
+
+}
+
+void CQueryCache::freeInfo(StatementCacheInfo* info)
+{
+	if( !info ) return;
+	resetInfo(info);
+	sqlite3_free(info->pszReads);
+	sqlite3_free(info->pszWrites);
+	sqlite3_free(info);
+}
+
+sqlite3_value* CQueryCache::getValue(StatementCacheInfo* info, int column)
+{
+	if( !info || !info->pServing ) return NULL;
+	CachedResult* pEntry = info->pServing;
+	if( column < 0 || column >= pEntry->iNumColumns || info->iRow >= pEntry->iNumRows ) return NULL;
+	return pEntry->ppValues[info->iRow * pEntry->iNumColumns + column];
+}
+
+
+int CQueryCache::getNumEntries(void)
+{
+	return this->m_iNumEntries;
+}
+
+sqlite3_int64 CQueryCache::getBytes(void)
+{
+	return this->m_iBytes;
+}
+
+sqlite3_int64 CQueryCache::getMaxBytes(void)
+{
+	return this->m_iMaxBytes;
+}
+
+sqlite3_int64 CQueryCache::getNumHits(void)
+{
+	return this->m_iHits;
+}
+
+sqlite3_int64 CQueryCache::getNumMisses(void)
+{
+	return this->m_iMisses;
+}
+
+sqlite3_int64 CQueryCache::getNumStores(void)
+{
+	return this->m_iStores;
+}
+
+sqlite3_int64 CQueryCache::getNumInvalidations(void)
+{
+	return this->m_iInvalidations;
+}
+
+sqlite3_int64 CQueryCache::getNumEvictions(void)
+{
+	return this->m_iEvictions;
+}
+
+sqlite3_int64 CQueryCache::getNumBypasses(void)
+{
+	return this->m_iBypasses;
+}
+
+void CQueryCache::resetStats(void)
+{
+	this->m_iHits = 0;
+	this->m_iMisses = 0;
+	this->m_iStores = 0;
+	this->m_iInvalidations = 0;
+	this->m_iEvictions = 0;
+	this->m_iBypasses = 0;
+}
@@ -0,0 +1,221 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "spatial.h"
+#include "database.h"
+#include "statement.h"
+
+#define VALIDATE_SPATIAL(ret) if( !this->m_pInsert || !this->m_pRemove || !this->m_pQuery ) { return ret; }
+
+CSpatialIndex::CSpatialIndex(int dimensions)
+{
+	this->m_iDimensions = dimensions;
+	this->m_pInsert = NULL;
+	this->m_pRemove = NULL;
+	this->m_pQuery = NULL;
+}
+
+CSpatialIndex::~CSpatialIndex(void)
+{
+	// Statements the database already finalized when it closed are still ours to free
+	if( this->m_pInsert ) { this->m_pInsert->finalize(); delete this->m_pInsert; }
+	if( this->m_pRemove ) { this->m_pRemove->finalize(); delete this->m_pRemove; }
+	if( this->m_pQuery ) { this->m_pQuery->finalize(); delete this->m_pQuery; }
+}
+
+
+// Creates the rtree table unless it already exists, fails with SQLITE_ERROR when SQLite was built without R*Tree
+int CSpatialIndex::create(CSpatialIndex** index, CDatabase* database, const char* name, int dimensions)
+{
+
+	if( !index || !database || !name ) return SQLITE_ERROR;
+
+	*index = NULL;
+
+	if( dimensions < 1 || dimensions > SPATIAL_MAX_DIMENSIONS ) return SQLITE_RANGE;
+
+	char columns[128] = "id";
+	char where[256] = "";
+	int columnsLength = 2;
+	int whereLength = 0;
+
+	for( int i = 0; i < dimensions; i++ ) {
+		sqlite3_snprintf(sizeof(columns) - columnsLength, columns + columnsLength, ", min%d, max%d", i, i);
+		columnsLength += (int)strlen(columns + columnsLength);
+		sqlite3_snprintf(sizeof(where) - whereLength, where + whereLength, "%smax%d >= ? AND min%d <= ?", i ? " AND " : "", i, i);
+		whereLength += (int)strlen(where + whereLength);
+	}
+
+	char* pszSql = sqlite3_mprintf("CREATE VIRTUAL TABLE IF NOT EXISTS \"%w\" USING rtree(%s);", name, columns);
+	if( !pszSql ) return SQLITE_NOMEM;
+	int retcode = database->execute(pszSql);
+	sqlite3_free(pszSql);
+
+	if( retcode != SQLITE_OK ) return retcode;
+
+	CSpatialIndex* pIndex = new CSpatialIndex(dimensions);
+
+	// One placeholder for the id and one per coordinate
+	char placeholders[64] = "?";
+	for( int i = 0; i < dimensions * 2; i++ ) {
+		strcat(placeholders, ", ?");
+	}
+
+	pszSql = sqlite3_mprintf("INSERT OR REPLACE INTO \"%w\" VALUES(%s);", name, placeholders);
+	retcode = pszSql ? database->prepare(&pIndex->m_pInsert, pszSql) : SQLITE_NOMEM;
+	sqlite3_free(pszSql);
+
+	if( retcode == SQLITE_OK ) {
+		pszSql = sqlite3_mprintf("DELETE FROM \"%w\" WHERE id = ?;", name);
+		retcode = pszSql ? database->prepare(&pIndex->m_pRemove, pszSql) : SQLITE_NOMEM;
+		sqlite3_free(pszSql);
+	}
+
+	if( retcode == SQLITE_OK ) {
+		pszSql = sqlite3_mprintf("SELECT %s FROM \"%w\" WHERE %s;", columns, name, where);
+		retcode = pszSql ? database->prepare(&pIndex->m_pQuery, pszSql) : SQLITE_NOMEM;
+		sqlite3_free(pszSql);
+	}
+
+	if( retcode != SQLITE_OK ) {
+		delete pIndex;
+		return retcode;
+	}
+
+	*index = pIndex;
+	return SQLITE_OK;
+
+}
+
+
+int CSpatialIndex::getDimensions(void)
+{
+	return this->m_iDimensions;
+}
+
+
+int CSpatialIndex::bindBox(CStatement* stmt, int firstIndex, const double* min, const double* max)
+{
+	for( int i = 0; i < this->m_iDimensions; i++ ) {
+		int retcode = stmt->bindDouble(firstIndex + i * 2, min[i]);
+		if( retcode != SQLITE_OK ) return retcode;
+		retcode = stmt->bindDouble(firstIndex + i * 2 + 1, max[i]);
+		if( retcode != SQLITE_OK ) return retcode;
+	}
+	return SQLITE_OK;
+}
+
+// Replaces the box if the id is already in the index
+int CSpatialIndex::insert(sqlite3_int64 id, const double* min, const double* max)
+{
+
+	VALIDATE_SPATIAL(SQLITE_ERROR);
+
+	int retcode = this->m_pInsert->bindInt64(1, id);
+	if( retcode == SQLITE_OK ) retcode = this->bindBox(this->m_pInsert, 2, min, max);
+	if( retcode == SQLITE_OK ) retcode = this->m_pInsert->step();
+
+	this->m_pInsert->reset();
+
+	return ( retcode == SQLITE_DONE ) ? SQLITE_OK : retcode;
+
+}
+
+int CSpatialIndex::remove(sqlite3_int64 id)
+{
+
+	VALIDATE_SPATIAL(SQLITE_ERROR);
+
+	int retcode = this->m_pRemove->bindInt64(1, id);
+	if( retcode == SQLITE_OK ) retcode = this->m_pRemove->step();
+
+	this->m_pRemove->reset();
+
+	return ( retcode == SQLITE_DONE ) ? SQLITE_OK : retcode;
+
+}
+
+// Calls back with every id whose box overlaps the query box
+int CSpatialIndex::queryBox(const double* min, const double* max, SpatialCallback callback, void* usrPtr)
+{
+
+	VALIDATE_SPATIAL(SQLITE_ERROR);
+
+	// The query is written as max >= queryMin AND min <= queryMax, which is the same order bindBox uses
+	int retcode = this->bindBox(this->m_pQuery, 1, min, max);
+
+	if( retcode == SQLITE_OK ) {
+		while( ( retcode = this->m_pQuery->step() ) == SQLITE_ROW ) {
+			callback(usrPtr, this->m_pQuery->getInt64(0));
+		}
+	}
+
+	this->m_pQuery->reset();
+
+	return ( retcode == SQLITE_DONE ) ? SQLITE_OK : retcode;
+
+}
+
+// The index narrows things down to the boxes touching the bounding box of the sphere, those are then
+// checked against the sphere itself using the point of each box closest to the center
+int CSpatialIndex::queryRadius(const double* center, double radius, SpatialCallback callback, void* usrPtr)
+{
+
+	VALIDATE_SPATIAL(SQLITE_ERROR);
+
+	double min[SPATIAL_MAX_DIMENSIONS];
+	double max[SPATIAL_MAX_DIMENSIONS];
+
+	for( int i = 0; i < this->m_iDimensions; i++ ) {
+		min[i] = center[i] - radius;
+		max[i] = center[i] + radius;
+	}
+
+	int retcode = this->bindBox(this->m_pQuery, 1, min, max);
+
+	if( retcode == SQLITE_OK ) {
+
+		while( ( retcode = this->m_pQuery->step() ) == SQLITE_ROW ) {
+
+			double distance = 0.0;
+
+			for( int i = 0; i < this->m_iDimensions; i++ ) {
+				double low = this->m_pQuery->getDouble(1 + i * 2);
+				double high = this->m_pQuery->getDouble(2 + i * 2);
+				double delta = 0.0;
+				if( center[i] < low ) delta = low - center[i];
+				else if( center[i] > high ) delta = center[i] - high;
+				distance += delta * delta;
+			}
+
+			if( distance <= radius * radius ) {
+				callback(usrPtr, this->m_pQuery->getInt64(0));
+			}
+
+		}
+
+	}
+
+	this->m_pQuery->reset();
+
+	return ( retcode == SQLITE_DONE ) ? SQLITE_OK : retcode;
+
+}
@@ -1,282 +1,609 @@
-/*
-
-    Gm_sqlite3 the improved sqlite library for Garry's Mod
-    Copyright (C) 2010 James John Kelly Jr
-
-	This library is free software; you can redistribute it and/or
-	modify it under the terms of the GNU Lesser General Public
-	License as published by the Free Software Foundation; either
-	version 2.1 of the License, or (at your option) any later version.
-
-	This library is distributed in the hope that it will be useful,
-	but WITHOUT ANY WARRANTY; without even the implied warranty of
-	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-	Lesser General Public License for more details.
-
-	You should have received a copy of the GNU Lesser General Public
-	License along with this library; if not, write to the Free Software
-	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
-
-*/
-
-#include "statement.h"
-#include "database.h"
-
-#define VALIDATE_STATEMENT(ret) if( !this->m_pStmt ) { return ret; }
-
-CStatement::CStatement(int code, sqlite3_stmt* stmt)
-{
-	Msg("CStatement\n");
-	ASSERT( stmt != NULL );
-	this->m_pStmt = stmt;
-}
-
-CStatement::~CStatement(void)
-{
-	// I had to disable this because the garbage collector would cause a crash right here, so be sure to finalize your statements!
-	//this->finalize();
-}
-
-int CStatement::finalize(void)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_finalize(this->m_pStmt);
-}
-
-
-const char* CStatement::getSql(void)
-{
-	VALIDATE_STATEMENT(NULL);
-	return sqlite3_sql(this->m_pStmt);
-}
-
-
-int CStatement::step(void)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_step(this->m_pStmt);
-}
-
-int CStatement::reset(void)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_reset(this->m_pStmt);
-}
-
-int CStatement::clearBindings(void)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_clear_bindings(this->m_pStmt);
-}
-
-
-int CStatement::getNumberOfParameters(void)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_bind_parameter_count(this->m_pStmt);
-}
-
-const char* CStatement::getParameterName(int index)
-{
-	VALIDATE_STATEMENT(NULL);
-	return sqlite3_bind_parameter_name(this->m_pStmt, index);
-}
-
-int CStatement::getParameterIndex(const char* name)
-{
-	VALIDATE_STATEMENT(0);
-	return sqlite3_bind_parameter_index(this->m_pStmt, name);
-}
-
-
-int CStatement::bindNull(int index)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_bind_null(this->m_pStmt, index);
-}
-
-int CStatement::bindNull(const char* name)
-{
-	return this->bindNull(this->getParameterIndex(name));
-}
-
-
-int CStatement::bindInteger(int index, int value)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_bind_int(this->m_pStmt, index, value);
-}
-
-int CStatement::bindInteger(const char* name, int value)
-{
-	return this->bindInteger(this->getParameterIndex(name), value);
-}
-
-
-int CStatement::bindInt64(int index, sqlite3_int64 value)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_bind_int64(this->m_pStmt, index, value);
-}
-
-int CStatement::bindInt64(const char* name, sqlite3_int64 value)
-{
-	return this->bindInt64(this->getParameterIndex(name), value);
-}
-
-
-int CStatement::bindFloat(int index, float value)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_bind_double(this->m_pStmt, index, (double)value);
-}
-
-int CStatement::bindFloat(const char* name, float value)
-{
-	return this->bindFloat(this->getParameterIndex(name), value);
-}
-
-
-int CStatement::bindDouble(int index, double value)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_bind_double(this->m_pStmt, index, value);
-}
-
-int CStatement::bindDouble(const char* name, double value)
-{
-	return this->bindDouble(this->getParameterIndex(name), value);
-}
-
-
-int CStatement::bindText(int index, const char *value)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_bind_text(this->m_pStmt, index, value, strlen(value)*sizeof(char), SQLITE_TRANSIENT);
-}
-
-int CStatement::bindText(const char* name, const char* value)
-{
-	return this->bindText(this->getParameterIndex(name), value);
-}
-
-
-int CStatement::bindBlob(int index, const char *value, int length)
-{
-	VALIDATE_STATEMENT(SQLITE_ERROR);
-	return sqlite3_bind_blob(this->m_pStmt, index, value, length, SQLITE_TRANSIENT);
-}
-
-int CStatement::bindBlob(const char* name, const char *value, int length)
-{
-	return this->bindBlob(this->getParameterIndex(name), value, length);
-}
-
-
-int CStatement::getNumberOfColumns(void)
-{
-	VALIDATE_STATEMENT(0);
-	return sqlite3_column_count(this->m_pStmt);
-}
-
-const char* CStatement::getColumnName(int index)
-{
-	VALIDATE_STATEMENT(NULL);
-	return sqlite3_column_name(this->m_pStmt, index);
-}
-
-// SQLite3 doesn't have a sqlite3_column_index function, so we have to do it ourselves for now
-int CStatement::getColumnIndex(const char *name)
-{
-	VALIDATE_STATEMENT(-1);
-	int index = -1;
-	int length = this->getNumberOfColumns();
-	for( int i = 0; i < length; i++ ) {
-		if( stricmp(name, this->getColumnName(i)) == 0 ) {
-			index = i;
-			break;
-		}
-	}
-	return index;
-}
-
-int CStatement::getColumnType(int index)
-{
-	VALIDATE_STATEMENT(0);
-	return sqlite3_column_type(this->m_pStmt, index);
-}
-
-
-int CStatement::getInteger(int index)
-{
-	VALIDATE_STATEMENT(0);
-	return sqlite3_column_int(this->m_pStmt, index);
-}
-
-int CStatement::getInteger(const char* name)
-{
-	return this->getInteger(this->getColumnIndex(name));
-}
-
-
-sqlite3_int64 CStatement::getInt64(int index)
-{
-	VALIDATE_STATEMENT(0);
-	return sqlite3_column_int64(this->m_pStmt, index);
-}
-
-sqlite3_int64 CStatement::getInt64(const char *name)
-{
-	return this->getInt64(this->getColumnIndex(name));
-}
-
-
-float CStatement::getFloat(int index)
-{
-	VALIDATE_STATEMENT(0);
-	return (float)sqlite3_column_double(this->m_pStmt, index);
-}
-
-float CStatement::getFloat(const char *name)
-{
-	return this->getFloat(this->getColumnIndex(name));
-}
-
-
-double CStatement::getDouble(int index)
-{
-	VALIDATE_STATEMENT(0);
-	return sqlite3_column_double(this->m_pStmt, index);
-}
-
-double CStatement::getDouble(const char *name)
-{
-	return this->getDouble(this->getColumnIndex(name));
-}
-
-
-const char* CStatement::getText(int index)
-{
-	VALIDATE_STATEMENT(NULL);
-	return (const char*)sqlite3_column_text(this->m_pStmt, index);
-}
-
-const char* CStatement::getText(const char *name)
-{
-	return this->getText(this->getColumnIndex(name));
-}
-
-
-const void* CStatement::getBlob(int index, int* length)
-{
-	VALIDATE_STATEMENT(NULL);
-	if( length ) {
-		*length = sqlite3_column_bytes(this->m_pStmt, index);
-	}
-	return sqlite3_column_blob(this->m_pStmt, index);
-}
-
-const void* CStatement::getBlob(const char* name, int* length)
-{
-	return this->getBlob(this->getColumnIndex(name), length);
-}
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "statement.h"
+#include "database.h"
+#include "thread.h"
+#include <new>
+
+#define VALIDATE_STATEMENT(ret) if( !this->m_pStmt ) { return ret; }
+
+CPool CStatement::s_Pool(sizeof(CStatement), 256);
+
+void* CStatement::operator new(size_t size)
+{
+	void* ptr = ( size <= s_Pool.getBlockSize() ) ? s_Pool.alloc() : ::operator new(size);
+	if( !ptr ) throw std::bad_alloc();
+	return ptr;
+}
+
+void CStatement::operator delete(void* ptr, size_t size)
+{
+	if( size <= s_Pool.getBlockSize() ) {
+		s_Pool.free(ptr);
+	} else {
+		::operator delete(ptr);
+	}
+}
+
+CPool* CStatement::getPool(void)
+{
+	return &s_Pool;
+}
+
+CStatement::CStatement(int code, sqlite3_stmt* stmt, CDatabase* owner)
+{
+	Msg("CStatement\n");
+	ASSERT( stmt != NULL );
+	this->m_pStmt = stmt;
+	this->m_pOwner = NULL;
+	this->m_pPrevLive = NULL;
+	this->m_pNextLive = NULL;
+	this->m_dCreated = GetTimeMilliseconds();
+	this->m_pSchema = NULL;
+	this->m_iSchemaSize = 0;
+	this->m_iRow = 0;
+	this->m_ppPins = NULL;
+	this->m_iNumPins = 0;
+	this->m_pCacheInfo = NULL;
+	if( owner ) owner->trackStatement(this);
+}
+
+CStatement::~CStatement(void)
+{
+	// Closing the database finalizes everything it tracks first, so anything still live here was leaked by a script
+	if( this->m_pStmt ) {
+		if( this->m_pOwner ) this->m_pOwner->m_iNumLeakedStatements++;
+		this->finalize();
+	}
+	this->clearResultSchema();
+	this->releasePins();
+	if( this->m_ppPins ) {
+		ScratchFree(this->m_ppPins, sizeof(ILuaObject*) * this->m_iNumPins);
+		this->m_ppPins = NULL;
+	}
+}
+
+int CStatement::finalize(void)
+{
+	if( this->m_pOwner ) this->m_pOwner->untrackStatement(this);
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_finalize(this->m_pStmt);
+	this->m_pStmt = NULL;
+	this->releasePins();
+	CQueryCache::freeInfo(this->m_pCacheInfo);
+	this->m_pCacheInfo = NULL;
+	return retcode;
+}
+
+bool CStatement::isFinalized(void)
+{
+	return ( this->m_pStmt == NULL );
+}
+
+// Seconds since the statement was prepared
+double CStatement::getAge(void)
+{
+	return ( GetTimeMilliseconds() - this->m_dCreated ) / 1000.0;
+}
+
+
+// Makes room for the parameter's pin, false if the parameter can't be pinned
+bool CStatement::canPin(int index)
+{
+
+	if( !this->m_ppPins ) {
+
+		int numPins = this->getNumberOfParameters();
+		if( numPins < 1 ) return false;
+
+		this->m_ppPins = (ILuaObject**)ScratchAlloc(sizeof(ILuaObject*) * numPins);
+		if( !this->m_ppPins ) return false;
+
+		this->m_iNumPins = numPins;
+
+		for( int i = 0; i < this->m_iNumPins; i++ ) {
+			this->m_ppPins[i] = NULL;
+		}
+
+	}
+
+	// Parameter indexes start at 1
+	return ( index >= 1 && index <= this->m_iNumPins );
+
+}
+
+// Replaces whatever the parameter had pinned, canPin has to have succeeded first
+void CStatement::pin(int index, ILuaObject* value)
+{
+	this->releasePin(index);
+	this->m_ppPins[index - 1] = value;
+}
+
+void CStatement::releasePin(int index)
+{
+	if( !this->m_ppPins || index < 1 || index > this->m_iNumPins ) return;
+	SAFE_UNREF(this->m_ppPins[index - 1]);
+}
+
+void CStatement::releasePins(void)
+{
+	if( !this->m_ppPins ) return;
+	for( int i = 0; i < this->m_iNumPins; i++ ) {
+		SAFE_UNREF(this->m_ppPins[i]);
+	}
+}
+
+
+const char* CStatement::getSql(void)
+{
+	VALIDATE_STATEMENT(NULL);
+	return sqlite3_sql(this->m_pStmt);
+}
+
+
+int CStatement::step(void)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	CQueryCache* pCache = this->m_pOwner ? this->m_pOwner->getResultCache() : NULL;
+	int retcode = ( pCache && this->m_pCacheInfo ) ? pCache->step(this->m_pStmt, this->m_pCacheInfo) : sqlite3_step(this->m_pStmt);
+	this->m_iRow = ( retcode == SQLITE_ROW ) ? this->m_iRow + 1 : 0;
+	return retcode;
+}
+
+int CStatement::reset(void)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	CQueryCache::resetInfo(this->m_pCacheInfo);
+	this->m_iRow = 0;
+	return sqlite3_reset(this->m_pStmt);
+}
+
+int CStatement::getRow(void)
+{
+	return this->m_iRow;
+}
+
+int CStatement::clearBindings(void)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_clear_bindings(this->m_pStmt);
+	this->releasePins();
+	if( this->m_pCacheInfo ) this->m_pCacheInfo->iInexactParams = 0;
+	return retcode;
+}
+
+
+int CStatement::getNumberOfParameters(void)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	return sqlite3_bind_parameter_count(this->m_pStmt);
+}
+
+const char* CStatement::getParameterName(int index)
+{
+	VALIDATE_STATEMENT(NULL);
+	return sqlite3_bind_parameter_name(this->m_pStmt, index);
+}
+
+int CStatement::getParameterIndex(const char* name)
+{
+	VALIDATE_STATEMENT(0);
+	return sqlite3_bind_parameter_index(this->m_pStmt, name);
+}
+
+
+int CStatement::bindNull(int index)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_bind_null(this->m_pStmt, index);
+	this->releasePin(index);
+	this->setExactParam(index, retcode == SQLITE_OK);
+	return retcode;
+}
+
+int CStatement::bindNull(const char* name)
+{
+	return this->bindNull(this->getParameterIndex(name));
+}
+
+
+int CStatement::bindInteger(int index, int value)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_bind_int(this->m_pStmt, index, value);
+	this->releasePin(index);
+	this->setExactParam(index, retcode == SQLITE_OK);
+	return retcode;
+}
+
+int CStatement::bindInteger(const char* name, int value)
+{
+	return this->bindInteger(this->getParameterIndex(name), value);
+}
+
+
+int CStatement::bindInt64(int index, sqlite3_int64 value)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_bind_int64(this->m_pStmt, index, value);
+	this->releasePin(index);
+	this->setExactParam(index, retcode == SQLITE_OK);
+	return retcode;
+}
+
+int CStatement::bindInt64(const char* name, sqlite3_int64 value)
+{
+	return this->bindInt64(this->getParameterIndex(name), value);
+}
+
+
+int CStatement::bindFloat(int index, float value)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_bind_double(this->m_pStmt, index, (double)value);
+	this->releasePin(index);
+	this->setExactParam(index, false);
+	return retcode;
+}
+
+int CStatement::bindFloat(const char* name, float value)
+{
+	return this->bindFloat(this->getParameterIndex(name), value);
+}
+
+
+int CStatement::bindDouble(int index, double value)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_bind_double(this->m_pStmt, index, value);
+	this->releasePin(index);
+	this->setExactParam(index, false);
+	return retcode;
+}
+
+int CStatement::bindDouble(const char* name, double value)
+{
+	return this->bindDouble(this->getParameterIndex(name), value);
+}
+
+
+int CStatement::bindText(int index, const char *value)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_bind_text(this->m_pStmt, index, value, strlen(value)*sizeof(char), SQLITE_TRANSIENT);
+	this->releasePin(index);
+	this->setExactParam(index, retcode == SQLITE_OK);
+	return retcode;
+}
+
+int CStatement::bindText(const char* name, const char* value)
+{
+	return this->bindText(this->getParameterIndex(name), value);
+}
+
+// Binding with an explicit length keeps embedded NULs intact
+int CStatement::bindText(int index, const char* value, int length)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_bind_text(this->m_pStmt, index, value, length, SQLITE_TRANSIENT);
+	this->releasePin(index);
+	this->setExactParam(index, retcode == SQLITE_OK && !( length > 0 && memchr(value, 0, length) ));
+	return retcode;
+}
+
+int CStatement::bindText(const char* name, const char* value, int length)
+{
+	return this->bindText(this->getParameterIndex(name), value, length);
+}
+
+// SQLite reads straight from the Lua string, the owner is referenced so it can't be collected while bound.
+// Nothing would keep value alive without its pin, so a parameter that can't be pinned gets a copy instead.
+int CStatement::bindStatic(int index, const char* value, int length, ILuaObject* owner, bool isText)
+{
+	if( !this->m_pStmt ) {
+		SAFE_UNREF(owner);
+		return SQLITE_ERROR;
+	}
+	if( !this->canPin(index) ) {
+		SAFE_UNREF(owner);
+		return isText ? this->bindText(index, value, length) : this->bindBlob(index, value, length);
+	}
+	int retcode = isText ? sqlite3_bind_text(this->m_pStmt, index, value, length, SQLITE_STATIC)
+		: sqlite3_bind_blob(this->m_pStmt, index, value, length, SQLITE_STATIC);
+	if( retcode == SQLITE_OK ) {
+		this->pin(index, owner);
+	} else {
+		SAFE_UNREF(owner);
+	}
+	this->setExactParam(index, retcode == SQLITE_OK && !( isText && length > 0 && memchr(value, 0, length) ));
+	return retcode;
+}
+
+int CStatement::bindTextStatic(int index, const char* value, int length, ILuaObject* owner)
+{
+	return this->bindStatic(index, value, length, owner, true);
+}
+
+int CStatement::bindTextStatic(const char* name, const char* value, int length, ILuaObject* owner)
+{
+	return this->bindTextStatic(this->getParameterIndex(name), value, length, owner);
+}
+
+
+int CStatement::bindBlob(int index, const char *value, int length)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+	int retcode = sqlite3_bind_blob(this->m_pStmt, index, value, length, SQLITE_TRANSIENT);
+	this->releasePin(index);
+	this->setExactParam(index, retcode == SQLITE_OK);
+	return retcode;
+}
+
+int CStatement::bindBlob(const char* name, const char *value, int length)
+{
+	return this->bindBlob(this->getParameterIndex(name), value, length);
+}
+
+int CStatement::bindBlobStatic(int index, const char* value, int length, ILuaObject* owner)
+{
+	return this->bindStatic(index, value, length, owner, false);
+}
+
+int CStatement::bindBlobStatic(const char* name, const char* value, int length, ILuaObject* owner)
+{
+	return this->bindBlobStatic(this->getParameterIndex(name), value, length, owner);
+}
+
+int CStatement::bindPointer(int index, void* value, const char* type, void (*destroy)(void*))
+{
+	if( !this->m_pStmt ) {
+		if( destroy ) destroy(value);
+		return SQLITE_ERROR;
+	}
+	int retcode = sqlite3_bind_pointer(this->m_pStmt, index, value, type, destroy);
+	this->releasePin(index);
+	this->setExactParam(index, false);
+	return retcode;
+}
+
+int CStatement::bindPointer(const char* name, void* value, const char* type, void (*destroy)(void*))
+{
+	return this->bindPointer(this->getParameterIndex(name), value, type, destroy);
+}
+
+
+int CStatement::getNumberOfColumns(void)
+{
+	VALIDATE_STATEMENT(0);
+	return sqlite3_column_count(this->m_pStmt);
+}
+
+const char* CStatement::getColumnName(int index)
+{
+	VALIDATE_STATEMENT(NULL);
+	return sqlite3_column_name(this->m_pStmt, index);
+}
+
+// SQLite3 doesn't have a sqlite3_column_index function, so we have to do it ourselves for now
+int CStatement::getColumnIndex(const char *name)
+{
+	VALIDATE_STATEMENT(-1);
+	int index = -1;
+	int length = this->getNumberOfColumns();
+	for( int i = 0; i < length; i++ ) {
+		if( stricmp(name, this->getColumnName(i)) == 0 ) {
+			index = i;
+			break;
+		}
+	}
+	return index;
+}
+
+// Keeps track of the parameters the result cache can't key on, a failed bind counts as inexact to be safe
+void CStatement::setExactParam(int index, bool exact)
+{
+	if( !this->m_pCacheInfo || index < 1 ) return;
+	sqlite3_uint64 bit = (sqlite3_uint64)1 << ( index < 64 ? index - 1 : 63 );
+	if( !exact ) {
+		this->m_pCacheInfo->iInexactParams |= bit;
+	} else if( index < 64 ) {
+		this->m_pCacheInfo->iInexactParams &= ~bit;
+	}
+}
+
+// Rows served from the result cache are read from its copies, NULL means read the VDBE as usual
+sqlite3_value* CStatement::getCachedValue(int index)
+{
+	if( !this->m_pCacheInfo ) return NULL;
+	return CQueryCache::getValue(this->m_pCacheInfo, index);
+}
+
+int CStatement::getColumnType(int index)
+{
+	VALIDATE_STATEMENT(0);
+	sqlite3_value* pValue = this->getCachedValue(index);
+	if( pValue ) return sqlite3_value_type(pValue);
+	return sqlite3_column_type(this->m_pStmt, index);
+}
+
+
+int CStatement::getStatus(int op, bool reset)
+{
+	VALIDATE_STATEMENT(0);
+	return sqlite3_stmt_status(this->m_pStmt, op, reset ? 1 : 0);
+}
+
+
+int CStatement::getInteger(int index)
+{
+	VALIDATE_STATEMENT(0);
+	sqlite3_value* pValue = this->getCachedValue(index);
+	if( pValue ) return sqlite3_value_int(pValue);
+	return sqlite3_column_int(this->m_pStmt, index);
+}
+
+int CStatement::getInteger(const char* name)
+{
+	return this->getInteger(this->getColumnIndex(name));
+}
+
+
+sqlite3_int64 CStatement::getInt64(int index)
+{
+	VALIDATE_STATEMENT(0);
+	sqlite3_value* pValue = this->getCachedValue(index);
+	if( pValue ) return sqlite3_value_int64(pValue);
+	return sqlite3_column_int64(this->m_pStmt, index);
+}
+
+sqlite3_int64 CStatement::getInt64(const char *name)
+{
+	return this->getInt64(this->getColumnIndex(name));
+}
+
+
+float CStatement::getFloat(int index)
+{
+	VALIDATE_STATEMENT(0);
+	sqlite3_value* pValue = this->getCachedValue(index);
+	if( pValue ) return (float)sqlite3_value_double(pValue);
+	return (float)sqlite3_column_double(this->m_pStmt, index);
+}
+
+float CStatement::getFloat(const char *name)
+{
+	return this->getFloat(this->getColumnIndex(name));
+}
+
+
+double CStatement::getDouble(int index)
+{
+	VALIDATE_STATEMENT(0);
+	sqlite3_value* pValue = this->getCachedValue(index);
+	if( pValue ) return sqlite3_value_double(pValue);
+	return sqlite3_column_double(this->m_pStmt, index);
+}
+
+double CStatement::getDouble(const char *name)
+{
+	return this->getDouble(this->getColumnIndex(name));
+}
+
+
+const char* CStatement::getText(int index)
+{
+	VALIDATE_STATEMENT(NULL);
+	sqlite3_value* pValue = this->getCachedValue(index);
+	if( pValue ) return (const char*)sqlite3_value_text(pValue);
+	return (const char*)sqlite3_column_text(this->m_pStmt, index);
+}
+
+const char* CStatement::getText(const char *name)
+{
+	return this->getText(this->getColumnIndex(name));
+}
+
+
+const void* CStatement::getBlob(int index, int* length)
+{
+	VALIDATE_STATEMENT(NULL);
+	sqlite3_value* pValue = this->getCachedValue(index);
+	if( pValue ) {
+		const void* pBlob = sqlite3_value_blob(pValue);
+		if( length ) {
+			*length = sqlite3_value_bytes(pValue);
+		}
+		return pBlob;
+	}
+	if( length ) {
+		*length = sqlite3_column_bytes(this->m_pStmt, index);
+	}
+	return sqlite3_column_blob(this->m_pStmt, index);
+}
+
+const void* CStatement::getBlob(const char* name, int* length)
+{
+	return this->getBlob(this->getColumnIndex(name), length);
+}
+
+
+// Column names are copied, the ones sqlite3_column_name returns are freed when a schema change re-prepares the statement
+int CStatement::setResultSchema(const ResultColumn* columns, int count)
+{
+	VALIDATE_STATEMENT(SQLITE_ERROR);
+
+	if( !columns || count < 1 || count > this->getNumberOfColumns() ) {
+		return SQLITE_RANGE;
+	}
+
+	this->clearResultSchema();
+
+	this->m_pSchema = (ResultColumn*)ScratchAlloc(sizeof(ResultColumn) * count);
+	if( !this->m_pSchema ) return SQLITE_NOMEM;
+
+	this->m_iSchemaSize = count;
+
+	for( int i = 0; i < count; i++ ) {
+		this->m_pSchema[i].pszName = NULL;
+	}
+
+	for( int i = 0; i < count; i++ ) {
+		this->m_pSchema[i].iType = columns[i].iType;
+		this->m_pSchema[i].pDecoder = columns[i].pDecoder;
+		this->m_pSchema[i].pResolved = columns[i].pDecoder;
+		this->m_pSchema[i].pszName = sqlite3_mprintf("%s", this->getColumnName(i));
+		if( !this->m_pSchema[i].pszName ) {
+			this->clearResultSchema();
+			return SQLITE_NOMEM;
+		}
+	}
+
+	return SQLITE_OK;
+}
+
+void CStatement::clearResultSchema(void)
+{
+	if( this->m_pSchema ) {
+		for( int i = 0; i < this->m_iSchemaSize; i++ ) {
+			sqlite3_free((void*)this->m_pSchema[i].pszName);
+		}
+		ScratchFree(this->m_pSchema, sizeof(ResultColumn) * this->m_iSchemaSize);
+		this->m_pSchema = NULL;
+	}
+	this->m_iSchemaSize = 0;
+}
+
+const ResultColumn* CStatement::getResultSchema(int* count)
+{
+	if( count ) {
+		*count = this->m_iSchemaSize;
+	}
+	return this->m_pSchema;
+}
+
+void CStatement::resolveResultSchema(ColumnDecoder fallback)
+{
+	for( int i = 0; i < this->m_iSchemaSize; i++ ) {
+		ResultColumn& column = this->m_pSchema[i];
+		column.pResolved = ( column.iType == 0 || this->getColumnType(i) == column.iType ) ? column.pDecoder : fallback;
+	}
+}
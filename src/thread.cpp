@@ -0,0 +1,168 @@
+/*
+
+    Gm_sqlite3 the improved sqlite library for Garry's Mod
+    Copyright (C) 2010 James John Kelly Jr
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "thread.h"
+
+#if !_WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// CMutex
+//-----------------------------------------------------------------------------
+
+CMutex::CMutex(void)
+{
+#if _WIN32
+	InitializeCriticalSection(&this->m_Section);
+#else
+	pthread_mutex_init(&this->m_Mutex, NULL);
+#endif
+}
+
+CMutex::~CMutex(void)
+{
+#if _WIN32
+	DeleteCriticalSection(&this->m_Section);
+#else
+	pthread_mutex_destroy(&this->m_Mutex);
+#endif
+}
+
+void CMutex::lock(void)
+{
+#if _WIN32
+	EnterCriticalSection(&this->m_Section);
+#else
+	pthread_mutex_lock(&this->m_Mutex);
+#endif
+}
+
+void CMutex::unlock(void)
+{
+#if _WIN32
+	LeaveCriticalSection(&this->m_Section);
+#else
+	pthread_mutex_unlock(&this->m_Mutex);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// CThread
+//-----------------------------------------------------------------------------
+
+CThread::CThread(void)
+{
+#if _WIN32
+	this->m_hThread = NULL;
+#else
+	this->m_bStarted = false;
+#endif
+	this->m_pFunction = NULL;
+	this->m_pUsrPtr = NULL;
+}
+
+CThread::~CThread(void)
+{
+	this->join();
+}
+
+#if _WIN32
+DWORD WINAPI CThread::entry(LPVOID param)
+#else
+void* CThread::entry(void* param)
+#endif
+{
+	CThread* pThread = (CThread*)param;
+	pThread->m_pFunction(pThread->m_pUsrPtr);
+	return 0;
+}
+
+bool CThread::start(ThreadFunction function, void* usrPtr)
+{
+
+	if( this->isRunning() || !function ) return false;
+
+	this->m_pFunction = function;
+	this->m_pUsrPtr = usrPtr;
+
+#if _WIN32
+	this->m_hThread = CreateThread(NULL, 0, CThread::entry, this, 0, NULL);
+	return ( this->m_hThread != NULL );
+#else
+	this->m_bStarted = ( pthread_create(&this->m_Thread, NULL, CThread::entry, this) == 0 );
+	return this->m_bStarted;
+#endif
+
+}
+
+void CThread::join(void)
+{
+#if _WIN32
+	if( this->m_hThread ) {
+		WaitForSingleObject(this->m_hThread, INFINITE);
+		CloseHandle(this->m_hThread);
+		this->m_hThread = NULL;
+	}
+#else
+	if( this->m_bStarted ) {
+		pthread_join(this->m_Thread, NULL);
+		this->m_bStarted = false;
+	}
+#endif
+}
+
+bool CThread::isRunning(void)
+{
+#if _WIN32
+	return ( this->m_hThread != NULL );
+#else
+	return this->m_bStarted;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Misc
+//-----------------------------------------------------------------------------
+
+void ThreadSleep(int milliseconds)
+{
+#if _WIN32
+	Sleep(milliseconds);
+#else
+	usleep(milliseconds * 1000);
+#endif
+}
+
+double GetTimeMilliseconds(void)
+{
+#if _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+#endif
+}
@@ -1,92 +1,167 @@
-require("sqlite3")
-
-function sqlite3callback(numColumns, columns, values)
-	print("== sqlite3callback: "..numColumns.." columns")
-	PrintTable(columns)
-	print("values:")
-	PrintTable(values)
-	return sqlite3.SQLITE_OK
-end
-
-function doSQLiteTest(player, command, arguments)
-
-	print("Running SQLite version "..sqlite3.LibVersion())
-	PrintTable(sqlite3)
-	
-	local db = sqlite3.New()
-	local rt = nil;
-	
-	-- The question mark will prepend the base folder path
-	if db:Open("?sqlite3test.db", sqlite3.SQLITE_OPEN_READWRITE + sqlite3.SQLITE_OPEN_CREATE) == sqlite3.SQLITE_OK then
-		print("Opened database")
-	else
-		print("Failed to open database")
-		return
-	end
-
-	if db:Execute("CREATE TABLE IF NOT EXISTS test ( s TEXT, x INTEGER );") == sqlite3.SQLITE_OK  then
-		print("Successfully created table")
-	else
-		print("Failed to created table")
-		return
-	end
-	
-	print("== INSERT ==") -- Insert rows using parameterized queries
-	
-	db:Execute("BEGIN;") -- If you are going to do a large amount of inserts, then a transaction can speed it up
-	local stmt, rt = db:Prepare("INSERT INTO test ( s, x ) VALUES ( ?, ? );")
-	for i=0,50 do
-	
-		local s = ""
-		local v = math.random(1,2)
-		
-		if v == 1 then
-			s = "Test1"
-		else
-			s = "Test2"
-		end
-		
-		v = math.random(0,1000)
-		
-		stmt:BindString(1, s)
-		stmt:BindInteger(2, v)
-		
-		print("I. Value: "..s..", "..v)
-		
-		stmt:Step() -- Execute the query
-		stmt:Reset() -- Reset the query back to its initial state
-		
-	end
-	stmt:Finalize() -- ALWAYS FINALIZE your statements when you are finished with them, or suffer memory leaks and crashes
-	db:Execute("END;") -- End Transaction
-
-	print("== SELECT ==") -- Process rows as tables, using parameterized queries
-	
-	stmt = db:Prepare("SELECT * FROM test WHERE s = $STRING ORDER BY x DESC;")
-	stmt:BindString("$STRING", "Test1") -- You can also use paramterized queries using names instead of indexes, unlike the previous example
-	while true do
-		local row = stmt:Fetch()
-		if not row then break end 
-		print("S. Value: "..row["s"]..", "..row["x"])
-	end
-	stmt:Finalize() -- ALWAYS FINALIZE your statements when you are finished with them, or suffer memory leaks and crashes
-	
-	print("== SELECT #2 ==") -- Or process them the SQLite way
-	
-	stmt = db:Prepare("SELECT s, x FROM test ORDER BY x DESC;")
-	while stmt:Step() == sqlite3.SQLITE_ROW do
-		-- You can retrieve results by either column name or index
-		print("S. Value: "..stmt:GetString("s")..", "..stmt:GetInteger(1))
-	end
-	print("Original SQL statement: "..stmt:SQLString())
-	stmt:Finalize() -- ALWAYS FINALIZE your statements (Trying to make a point here)
-
-	print("== Callback Test==")
-	db:Execute("SELECT * FROM test WHERE s=\"Test1\";", sqlite3callback)
-	
-	print("== Total Changes: "..db:TotalChanges())
-	
-	db:Close()
-	
-end
-concommand.Add("sqlite3test", doSQLiteTest)
+require("sqlite3")
+
+function sqlite3callback(numColumns, columns, values)
+	print("== sqlite3callback: "..numColumns.." columns")
+	PrintTable(columns)
+	print("values:")
+	PrintTable(values)
+	return sqlite3.SQLITE_OK
+end
+
+function doSQLiteTest(player, command, arguments)
+
+	print("Running SQLite version "..sqlite3.LibVersion())
+	PrintTable(sqlite3)
+	
+	local db = sqlite3.New()
+	local rt = nil;
+	
+	-- The question mark will prepend the base folder path
+	if db:Open("?sqlite3test.db", sqlite3.SQLITE_OPEN_READWRITE + sqlite3.SQLITE_OPEN_CREATE) == sqlite3.SQLITE_OK then
+		print("Opened database")
+	else
+		print("Failed to open database")
+		return
+	end
+
+	if db:Execute("CREATE TABLE IF NOT EXISTS test ( s TEXT, x INTEGER );") == sqlite3.SQLITE_OK  then
+		print("Successfully created table")
+	else
+		print("Failed to created table")
+		return
+	end
+	
+	print("== INSERT ==") -- Insert rows using parameterized queries
+	
+	db:Execute("BEGIN;") -- If you are going to do a large amount of inserts, then a transaction can speed it up
+	local stmt, rt = db:Prepare("INSERT INTO test ( s, x ) VALUES ( ?, ? );")
+	for i=0,50 do
+	
+		local s = ""
+		local v = math.random(1,2)
+		
+		if v == 1 then
+			s = "Test1"
+		else
+			s = "Test2"
+		end
+		
+		v = math.random(0,1000)
+		
+		stmt:BindString(1, s)
+		stmt:BindInteger(2, v)
+		
+		print("I. Value: "..s..", "..v)
+		
+		stmt:Step() -- Execute the query
+		stmt:Reset() -- Reset the query back to its initial state
+		
+	end
+	stmt:Finalize() -- ALWAYS FINALIZE your statements when you are finished with them, or suffer memory leaks and crashes
+	db:Execute("END;") -- End Transaction
+
+	print("== SELECT ==") -- Process rows as tables, using parameterized queries
+	
+	stmt = db:Prepare("SELECT * FROM test WHERE s = $STRING ORDER BY x DESC;")
+	stmt:BindString("$STRING", "Test1") -- You can also use paramterized queries using names instead of indexes, unlike the previous example
+	while true do
+		local row = stmt:Fetch()
+		if not row then break end 
+		print("S. Value: "..row["s"]..", "..row["x"])
+	end
+	stmt:Finalize() -- ALWAYS FINALIZE your statements when you are finished with them, or suffer memory leaks and crashes
+	
+	print("== SELECT #2 ==") -- Or process them the SQLite way
+	
+	stmt = db:Prepare("SELECT s, x FROM test ORDER BY x DESC;")
+	while stmt:Step() == sqlite3.SQLITE_ROW do
+		-- You can retrieve results by either column name or index
+		print("S. Value: "..stmt:GetString("s")..", "..stmt:GetInteger(1))
+	end
+	print("Original SQL statement: "..stmt:SQLString())
+	stmt:Finalize() -- ALWAYS FINALIZE your statements (Trying to make a point here)
+
+	print("== Callback Test==")
+	db:Execute("SELECT * FROM test WHERE s=\"Test1\";", sqlite3callback)
+	
+	print("== Total Changes: "..db:TotalChanges())
+	
+	db:Close()
+	
+end
+concommand.Add("sqlite3test", doSQLiteTest)
+
+-- Multi-process stress test: run "sqlite3stress <seconds> <writesPerTick>" on every server that shares the
+-- database file at the same time, each server is one writer process. Prints the writes per second it got through
+-- and how long it had to wait on the others.
+local stressRunning = false
+
+function doSQLiteStress(player, command, arguments)
+
+	-- The console passes a NULL entity, players have to be superadmins to flood the file with writes
+	if player:IsValid() and not player:IsSuperAdmin() then
+		player:PrintMessage(HUD_PRINTCONSOLE, "sqlite3stress is only available to superadmins\n")
+		return
+	end
+
+	if stressRunning then
+		print("Stress test is already running")
+		return
+	end
+
+	local seconds = math.Clamp(math.floor(tonumber(arguments[1]) or 30), 1, 300)
+	local perTick = math.Clamp(math.floor(tonumber(arguments[2]) or 20), 1, 200)
+	local server = GetConVarString("hostport")
+
+	local db = sqlite3.New()
+
+	if db:Open("?sqlite3stress.db", "shared") ~= sqlite3.SQLITE_OK then
+		print("Failed to open database")
+		return
+	end
+
+	db:Execute("CREATE TABLE IF NOT EXISTS stress ( server TEXT, n INTEGER, t REAL );")
+
+	local written, failed, queued = 0, 0, 0
+	local started = SysTime()
+
+	local function finished(retcode, latency)
+		if retcode == sqlite3.SQLITE_OK then
+			written = written + 1
+		else
+			failed = failed + 1
+		end
+	end
+
+	stressRunning = true
+	print("== Stress test: "..seconds.." seconds, "..perTick.." writes per tick, server "..server)
+
+	hook.Add("Think", "sqlite3stress", function()
+
+		if SysTime() - started < seconds then
+			for i=1,perTick do
+				queued = queued + 1
+				db:ExecuteDeferred(string.format("INSERT INTO stress ( server, n, t ) VALUES ( '%s', %d, %f );", server, queued, SysTime()), finished)
+			end
+			return
+		end
+
+		-- Wait for whatever is still queued before reporting
+		if db:DeferredStats().queued > 0 and SysTime() - started < seconds + 30 then return end
+
+		hook.Remove("Think", "sqlite3stress")
+
+		local elapsed = SysTime() - started
+		print("Writes: "..written.." ok, "..failed.." failed, "..string.format("%.1f", written / elapsed).." per second")
+		print("== ContentionStats")
+		PrintTable(db:ContentionStats())
+		print("== DeferredStats")
+		PrintTable(db:DeferredStats())
+
+		db:Close()
+		stressRunning = false
+
+	end)
+
+end
+concommand.Add("sqlite3stress", doSQLiteStress)